@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Pipelines.hpp"
+#include "StripStreaming.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+using namespace cv; 
+namespace fs = std::filesystem; 
+
+// Headless batch tool: runs one of the pipelines over a set of images on a 
+// pool of worker threads and writes every result to the output directory, 
+// without opening any window. 
+static void PrintUsage(const char* program) {
+    cout << "Usage: " << program << " --pipeline NAME [options] INPUT..." << endl
+         << "  INPUT               an image, a directory (not recursive) or @FILE with one path per line" << endl
+         << "  -p, --pipeline NAME the pipeline to run (see --list)" << endl
+         << "  -o, --output DIR    output directory (default: output)" << endl
+         << "  -j, --threads N     worker threads (default: one per hardware thread)" << endl
+         << "  -s, --set KEY=VALUE pipeline parameter, can be repeated" << endl
+         << "  -e, --ext EXT       extension of the written images (default: png); csv or bin" << endl
+         << "                      write the features instead (the corners of harris)" << endl
+         << "  -b, --band-rows N   stream the images in bands of N rows (canny, average, median);" << endl
+         << "                      PGM/PPM inputs and outputs are then never held whole in memory" << endl
+         << "  -t, --trace FILE    write a Chrome trace of the stages (needs IPA_ENABLE_TRACING)" << endl
+         << "  -l, --list          list the available pipelines" << endl; 
+}
+
+static bool IsImageFile(const fs::path& path) {
+    static const vector<string> extensions = {".png", ".jpg", ".jpeg", ".tif", ".tiff", ".bmp", ".pgm", ".ppm", ".webp"}; 
+    string extension = path.extension().string(); 
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower); 
+    return find(extensions.begin(), extensions.end(), extension) != extensions.end(); 
+}
+
+// Expands the inputs given on the command line into the list of images: 
+// directories contribute their image files in name order, @FILE lists 
+// contribute one path per non-empty line. 
+static void CollectInputs(const string& input, vector<fs::path>& images) {
+    if(!input.empty() && input[0] == '@') {
+        ifstream list(input.substr(1)); 
+        if(!list) {
+            throw runtime_error("cannot open the list file " + input.substr(1)); 
+        }
+
+        string line; 
+        while(getline(list, line)) {
+            if(!line.empty() && line.back() == '\r') {
+                line.pop_back(); 
+            }
+            if(!line.empty()) {
+                images.push_back(line); 
+            }
+        }
+    } else if(fs::is_directory(input)) {
+        vector<fs::path> entries; 
+        for(const fs::directory_entry& entry : fs::directory_iterator(input)) {
+            if(entry.is_regular_file() && IsImageFile(entry.path())) {
+                entries.push_back(entry.path()); 
+            }
+        }
+        sort(entries.begin(), entries.end()); 
+        images.insert(images.end(), entries.begin(), entries.end()); 
+    } else {
+        images.push_back(input); 
+    }
+}
+
+// Runs a pipeline band by band. PGM and PPM files are read and written 
+// incrementally; the other formats can only be decoded and encoded whole, 
+// so for them only the intermediate images of the pipeline are bounded. 
+static void StreamImage(const Pipeline& pipeline, const PipelineParams& params, const fs::path& image, const fs::path& outputFile, int bandRows) {
+    unique_ptr<RowSource> source; 
+    if(IsPnmFile(image.string())) {
+        source.reset(new PnmRowSource(image.string(), pipeline.readFlags)); 
+    } else {
+        Mat inputImage = imread(image.string(), pipeline.readFlags); 
+        if(inputImage.empty()) {
+            throw runtime_error("cannot read the image"); 
+        }
+        source.reset(new MatRowSource(inputImage)); 
+    }
+
+    IPA_TRACE_SCOPE(pipeline.name.c_str(), static_cast<int64_t>(source->Rows()) * source->Cols()); 
+
+    if(IsPnmFile(outputFile.string())) {
+        PnmRowSink sink(outputFile.string()); 
+        pipeline.stream(*source, sink, bandRows, params); 
+    } else {
+        MatRowSink sink; 
+        pipeline.stream(*source, sink, bandRows, params); 
+        if(!imwrite(outputFile.string(), sink.Result())) {
+            throw runtime_error("cannot write " + outputFile.string()); 
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    string pipelineName; 
+    string outputDir = "output"; 
+    string extension = "png"; 
+    string traceFile; 
+    int threads = 0; 
+    int bandRows = 0; 
+    PipelineParams params; 
+    vector<string> inputs; 
+
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i]; 
+        bool hasValue = i+1 < argc; 
+
+        if(arg == "-h" || arg == "--help") {
+            PrintUsage(argv[0]); 
+            return 0; 
+        } else if(arg == "-l" || arg == "--list") {
+            for(const Pipeline& pipeline : Pipelines()) {
+                cout << pipeline.name << "\t" << pipeline.description << endl; 
+            }
+            return 0; 
+        } else if((arg == "-p" || arg == "--pipeline") && hasValue) {
+            pipelineName = argv[++i]; 
+        } else if((arg == "-o" || arg == "--output") && hasValue) {
+            outputDir = argv[++i]; 
+        } else if((arg == "-j" || arg == "--threads") && hasValue) {
+            threads = atoi(argv[++i]); 
+        } else if((arg == "-b" || arg == "--band-rows") && hasValue) {
+            bandRows = atoi(argv[++i]); 
+            if(bandRows <= 0) {
+                cerr << "The bands must have at least one row" << endl; 
+                return 2; 
+            }
+        } else if((arg == "-t" || arg == "--trace") && hasValue) {
+            traceFile = argv[++i]; 
+        } else if((arg == "-e" || arg == "--ext") && hasValue) {
+            extension = argv[++i]; 
+        } else if((arg == "-s" || arg == "--set") && hasValue) {
+            string pair = argv[++i]; 
+            size_t equal = pair.find('='); 
+            if(equal == string::npos || equal == 0) {
+                cerr << "Invalid parameter '" << pair << "', expected KEY=VALUE" << endl; 
+                return 2; 
+            }
+            params.Set(pair.substr(0, equal), pair.substr(equal+1)); 
+        } else if(!arg.empty() && arg[0] == '-' && arg != "-") {
+            cerr << "Unknown option " << arg << endl; 
+            PrintUsage(argv[0]); 
+            return 2; 
+        } else {
+            inputs.push_back(arg); 
+        }
+    }
+
+    const Pipeline* pipeline = FindPipeline(pipelineName); 
+    if(pipeline == nullptr || inputs.empty()) {
+        if(!pipelineName.empty() && pipeline == nullptr) {
+            cerr << "Unknown pipeline '" << pipelineName << "'" << endl; 
+        }
+        PrintUsage(argv[0]); 
+        return 2; 
+    }
+
+    if(bandRows > 0 && !pipeline->stream) {
+        cerr << "The pipeline '" << pipeline->name << "' cannot be streamed in bands" << endl; 
+        return 2; 
+    }
+
+    bool writeData = IsDataExtension(extension); 
+    if(writeData && !pipeline->writeData) {
+        cerr << "The pipeline '" << pipeline->name << "' writes only images, not ." << extension << " files" << endl; 
+        return 2; 
+    }
+
+    vector<fs::path> images; 
+    try {
+        for(const string& input : inputs) {
+            CollectInputs(input, images); 
+        }
+        fs::create_directories(outputDir); 
+    } catch(const exception& e) {
+        cerr << e.what() << endl; 
+        return 2; 
+    }
+
+    // The outputs are named after the stems of the inputs, so two inputs 
+    // with the same stem (a.png and a.jpg, or the same name in two 
+    // directories) would be written to the same file by two workers at once. 
+    vector<fs::path> outputFiles; 
+    map<fs::path, fs::path> outputSources; 
+    for(const fs::path& image : images) {
+        fs::path outputFile = fs::path(outputDir) / (image.stem().string() + "_" + pipeline->name + "." + extension); 
+        auto inserted = outputSources.emplace(outputFile, image); 
+        if(!inserted.second) {
+            cerr << image.string() << " and " << inserted.first->second.string() << " would both be written to " 
+                 << outputFile.string() << "; rename one of them or run them separately" << endl; 
+            return 2; 
+        }
+        outputFiles.push_back(outputFile); 
+    }
+
+    // The parallelism comes from the images processed at the same time, so 
+    // the internal threads of OpenCV would only oversubscribe the cores. 
+    ThreadPool pool(threads); 
+    if(pool.Size() > 1) {
+        setNumThreads(1); 
+    }
+
+    if(!traceFile.empty()) {
+        if(!TracingAvailable()) {
+            cerr << "Tracing is not compiled in, rebuild with -DIPA_ENABLE_TRACING=ON" << endl; 
+            return 2; 
+        }
+        StartTracing(); 
+    }
+
+    mutex consoleMutex; 
+    atomic<int> failures(0); 
+    auto start = chrono::steady_clock::now(); 
+
+    for(size_t n = 0; n < images.size(); n++) {
+        pool.Submit([&, n] {
+            const fs::path& image = images[n]; 
+            const fs::path& outputFile = outputFiles[n]; 
+            auto imageStart = chrono::steady_clock::now(); 
+            string error; 
+
+            try {
+                if(bandRows > 0) {
+                    StreamImage(*pipeline, params, image, outputFile, bandRows); 
+                } else {
+                    Mat inputImage = imread(image.string(), pipeline->readFlags); 
+                    if(inputImage.empty()) {
+                        throw runtime_error("cannot read the image"); 
+                    }
+
+                    // The features are written by the pipeline itself, 
+                    // without rendering an image. 
+                    IPA_TRACE_BEGIN(pipelineStage, pipeline->name.c_str(), inputImage.total()); 
+                    if(writeData) {
+                        pipeline->writeData(inputImage, params, outputFile.string()); 
+                        IPA_TRACE_STOP(pipelineStage); 
+                    } else {
+                        Mat resultImage = pipeline->run(inputImage, params); 
+                        IPA_TRACE_STOP(pipelineStage); 
+
+                        if(!imwrite(outputFile.string(), resultImage)) {
+                            throw runtime_error("cannot write " + outputFile.string()); 
+                        }
+                    }
+                }
+            } catch(const exception& e) {
+                error = e.what(); 
+            }
+
+            double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - imageStart).count(); 
+            lock_guard<mutex> lock(consoleMutex); 
+            if(error.empty()) {
+                cout << image.string() << " -> " << outputFile.string() << " (" << elapsed << " ms)" << endl; 
+            } else {
+                failures++; 
+                cerr << image.string() << ": " << error << endl; 
+            }
+        }); 
+    }
+    pool.Wait(); 
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count(); 
+    cout << images.size() << " images, " << failures.load() << " failed, " << seconds << " s with " 
+         << pool.Size() << " threads (" << (seconds > 0 ? images.size()/seconds : 0.0) << " images/s)" << endl; 
+
+    if(!traceFile.empty()) {
+        StopTracing(); 
+        PrintTraceSummary(cout); 
+        if(!WriteTrace(traceFile)) {
+            cerr << "Cannot write " << traceFile << endl; 
+            return 1; 
+        }
+    }
+
+    return failures.load() == 0 ? 0 : 1; 
+}
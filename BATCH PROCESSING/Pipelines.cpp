@@ -0,0 +1,259 @@
+#include <stack>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+#include "Pipelines.hpp"
+#include "CannyEdgeDetector.hpp"
+#include "DistanceTransformation.hpp"
+#include "Histogram_Equalization.hpp"
+#include "HarrisCornerDetection.hpp"
+#include "HoughTransformationCircle.hpp"
+#include "HoughTransformationRect.hpp"
+#include "K-Means.hpp"
+#include "LowHighPass.hpp"
+#include "Ohlander.hpp"
+#include "RegionGrowing.hpp"
+#include "SplitAndMerge.hpp"
+#include "SplitAndMergeIt.hpp"
+#include "Thresholding.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+void PipelineParams::Set(const string& key, const string& value) {
+    this->values[key] = value; 
+}
+
+bool PipelineParams::Has(const string& key) const {
+    return this->values.count(key) > 0; 
+}
+
+int PipelineParams::GetInt(const string& key, int fallback) const {
+    auto it = this->values.find(key); 
+    if(it == this->values.end()) {
+        return fallback; 
+    }
+
+    size_t used = 0; 
+    int value = stoi(it->second, &used); 
+    if(used != it->second.size()) {
+        throw invalid_argument("parameter '" + key + "' is not an integer: " + it->second); 
+    }
+    return value; 
+}
+
+double PipelineParams::GetDouble(const string& key, double fallback) const {
+    auto it = this->values.find(key); 
+    if(it == this->values.end()) {
+        return fallback; 
+    }
+
+    size_t used = 0; 
+    double value = stod(it->second, &used); 
+    if(used != it->second.size()) {
+        throw invalid_argument("parameter '" + key + "' is not a number: " + it->second); 
+    }
+    return value; 
+}
+
+string PipelineParams::GetString(const string& key, const string& fallback) const {
+    auto it = this->values.find(key); 
+    return it == this->values.end() ? fallback : it->second; 
+}
+
+// The morphological post-processing that both the Split and Merge 
+// programs apply to smooth the borders of the regions. 
+static void SmoothRegions(Mat& resultImage) {
+    Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(5, 5));
+    dilate(resultImage, resultImage, kernel, Point(-1, -1), 2);
+    erode(resultImage, resultImage, kernel, Point(-1, -1), 2);
+    erode(resultImage, resultImage, kernel, Point(-1, -1), 2);
+    dilate(resultImage, resultImage, kernel, Point(-1, -1), 2); 
+}
+
+// The options of the harris pipeline. The staged mode finds the corners of 
+// SobelFilter and GaussianFilter followed by HarrisCornerDetector, as the 
+// demo. 
+static HarrisOptions HarrisParams(const PipelineParams& params) {
+    HarrisOptions options; 
+    options.windowSize = params.GetInt("window", 3); 
+    options.suppressionRadius = params.GetInt("radius", -1); 
+    options.maxCorners = params.GetInt("corners", 0); 
+    options.gaussianSize = params.GetInt("size", 3); 
+    options.gaussianSigma = static_cast<float>(params.GetDouble("sigma", 1.0)); 
+    options.threads = params.GetInt("threads", 1); 
+    options.levels = params.GetInt("levels", 1); 
+
+    string mode = params.GetString("mode", "staged"); 
+    if(mode == "staged") {
+        options.derivatives = HarrisDerivatives::Absolute; 
+    } else if(mode != "fused") {
+        throw invalid_argument("parameter 'mode' must be staged or fused: " + mode); 
+    }
+    return options; 
+}
+
+// Every pipeline mirrors the main() of the corresponding demo program, 
+// with the command line arguments replaced by named parameters. 
+static vector<Pipeline> BuildPipelines() {
+    vector<Pipeline> pipelines; 
+
+    pipelines.push_back({"canny", "Canny edge detector (size, sigma, mode=staged|fused)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat inputImage = input; 
+            string mode = params.GetString("mode", "staged"); 
+            if(mode == "fused") {
+                return FusedCanny(inputImage, params.GetInt("size", 3), params.GetInt("sigma", 3)); 
+            } else if(mode != "staged") {
+                throw invalid_argument("parameter 'mode' must be staged or fused: " + mode); 
+            }
+
+            Mat gaussianFilter = GaussianFilter(inputImage, params.GetInt("size", 3), params.GetInt("sigma", 3)); 
+            return SobelApplication(gaussianFilter, 3); 
+        },
+        [](RowSource& source, RowSink& sink, int bandRows, const PipelineParams& params) {
+            StreamCanny(source, sink, params.GetInt("size", 3), params.GetInt("sigma", 3), bandRows); 
+        }}); 
+
+    pipelines.push_back({"harris", "Harris corner detector (size, sigma, upper, window, radius, corners, threads, levels, mode=staged|fused); --ext csv|bin writes the corners", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            return DrawHarrisCorners(input, DetectHarrisCorners(input, params.GetInt("upper", 1000), HarrisParams(params))); 
+        },
+        nullptr,
+        [](const Mat& input, const PipelineParams& params, const string& file) {
+            vector<HarrisCorner> corners = DetectHarrisCorners(input, params.GetInt("upper", 1000), HarrisParams(params)); 
+            bool csv = file.size() >= 4 && file.compare(file.size()-4, 4, ".csv") == 0; 
+            WriteHarrisCorners(file, corners, csv ? CornerFileFormat::Csv : CornerFileFormat::Binary); 
+        }}); 
+
+    pipelines.push_back({"kmeans", "K-Means color clustering (k, iterations, threshold, threads, colorbits, hamerly, tolerance, minibatch, seeding=kmeans++|random, seed)", IMREAD_COLOR,
+        [](const Mat& input, const PipelineParams& params) {
+            KMeansOptions options; 
+            options.threads = params.GetInt("threads", 1); 
+            options.colorBits = params.GetInt("colorbits", 0); 
+            options.hamerly = params.GetInt("hamerly", 0) != 0; 
+            options.reassignedTolerance = params.GetDouble("tolerance", 0); 
+            options.miniBatch = params.GetInt("minibatch", 0); 
+            string seeding = params.GetString("seeding", "kmeans++"); 
+            if(seeding == "kmeans++") {
+                options.seeding = KMeansSeeding::PlusPlus; 
+            } else if(seeding != "random") {
+                throw invalid_argument("parameter 'seeding' must be random or kmeans++: " + seeding); 
+            }
+            options.sampleSeed = static_cast<unsigned>(params.GetInt("seed", 1)); 
+            return K_Means(input, params.GetInt("k", 8), params.GetInt("iterations", 10), params.GetInt("threshold", 1), options); 
+        }}); 
+
+    pipelines.push_back({"average", "Average filter (radius)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat inputImage = input; 
+            return Average(inputImage, params.GetInt("radius", 1)); 
+        },
+        [](RowSource& source, RowSink& sink, int bandRows, const PipelineParams& params) {
+            StreamStrips(source, {AverageStage(params.GetInt("radius", 1))}, sink, bandRows); 
+        }}); 
+
+    pipelines.push_back({"median", "Median filter (radius, threads)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat inputImage = input; 
+            return Median(inputImage, params.GetInt("radius", 1), params.GetInt("threads", 1)); 
+        },
+        [](RowSource& source, RowSink& sink, int bandRows, const PipelineParams& params) {
+            StreamStrips(source, {MedianStage(params.GetInt("radius", 1))}, sink, bandRows); 
+        }}); 
+
+    pipelines.push_back({"distance4", "Binarization + 4-connected distance transformation", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams&) {
+            return TransformationDistance4(Binarization(input)); 
+        }}); 
+
+    pipelines.push_back({"distance8", "Binarization + 8-connected distance transformation", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams&) {
+            return TransformationDistance8(Binarization(input)); 
+        }}); 
+
+    pipelines.push_back({"equalization", "Histogram equalization", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams&) {
+            return GetEqualization(GetProbabilities(input), input); 
+        }}); 
+
+    pipelines.push_back({"threshold", "Binary thresholding (value)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat inputImage = input; 
+            return Threshold(inputImage, params.GetInt("value", 128)); 
+        }}); 
+
+    pipelines.push_back({"regiongrowing", "Region growing (threshold)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat inputImage = input; 
+            return StartGrow(inputImage, params.GetInt("threshold", 10)); 
+        }}); 
+
+    pipelines.push_back({"splitmerge", "Recursive split and merge (threshold)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            int threshold = params.GetInt("threshold", 64); 
+            Mat inputImage = input.clone(); 
+            Mat resultImage = inputImage.clone(); 
+
+            Region regionSplitted = Split(inputImage, Rect(0, 0, inputImage.cols, inputImage.rows), threshold);
+            Merge(inputImage, regionSplitted, threshold);
+            Fill(resultImage, regionSplitted);
+            SmoothRegions(resultImage); 
+            return resultImage; 
+        }}); 
+
+    pipelines.push_back({"splitmerge-it", "Iterative split and merge (threshold)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            int threshold = params.GetInt("threshold", 64); 
+            Mat inputImage; 
+            GaussianBlur(input, inputImage, Size(5, 5), 0, 0);
+            Mat resultImage = inputImage.clone(); 
+
+            stack<iterative::Region> regionList = iterative::Split(inputImage, Rect(0, 0, inputImage.cols, inputImage.rows), threshold); 
+            iterative::Merge(resultImage, regionList, threshold); 
+            SmoothRegions(resultImage); 
+            return resultImage; 
+        }}); 
+
+    pipelines.push_back({"ohlander", "Ohlander histogram clustering (threshold)", IMREAD_COLOR,
+        [](const Mat& input, const PipelineParams& params) {
+            return OhlanderSegmentation(input, params.GetInt("threshold", 30)); 
+        }}); 
+
+    pipelines.push_back({"hough-line", "Canny + Hough transformation for lines (threshold)", IMREAD_GRAYSCALE,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat clonedImage = input.clone(); 
+            Mat blurredImage, cannyImage; 
+            GaussianBlur(input, blurredImage, Size(5, 5), 1.4, 1.4); 
+            Canny(blurredImage, cannyImage, 60, 160, 3); 
+            return HoughTransformation(cannyImage, clonedImage, params.GetInt("threshold", 100)); 
+        }}); 
+
+    pipelines.push_back({"hough-circle", "Canny + Hough transformation for circles (threshold, rmax, rmin)", IMREAD_COLOR,
+        [](const Mat& input, const PipelineParams& params) {
+            Mat clonedImage = input.clone(); 
+            Mat blurredImage, cannyImage; 
+            GaussianBlur(input, blurredImage, Size(5, 5), 1.5, 1.5); 
+            Canny(blurredImage, cannyImage, 80, 150, 3); 
+            return HoughTransformation(cannyImage, clonedImage, params.GetInt("threshold", 150), params.GetInt("rmax", 60), params.GetInt("rmin", 20)); 
+        }}); 
+
+    return pipelines; 
+}
+
+const vector<Pipeline>& Pipelines() {
+    static const vector<Pipeline> pipelines = BuildPipelines(); 
+    return pipelines; 
+}
+
+const Pipeline* FindPipeline(const string& name) {
+    for(const Pipeline& pipeline : Pipelines()) {
+        if(pipeline.name == name) {
+            return &pipeline; 
+        }
+    }
+    return nullptr; 
+}
+
+bool IsDataExtension(const string& extension) {
+    return extension == "csv" || extension == "bin"; 
+}
@@ -0,0 +1,47 @@
+#ifndef PIPELINES_HPP
+#define PIPELINES_HPP
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "StripStreaming.hpp"
+
+// The parameters of a pipeline, given as key=value pairs on the command 
+// line. Every pipeline reads only the keys it knows, with its own defaults. 
+class PipelineParams {
+    public: 
+    void Set(const std::string& key, const std::string& value); 
+    bool Has(const std::string& key) const; 
+    int GetInt(const std::string& key, int fallback) const; 
+    double GetDouble(const std::string& key, double fallback) const; 
+    std::string GetString(const std::string& key, const std::string& fallback) const; 
+
+    private: 
+    std::map<std::string, std::string> values; 
+}; 
+
+// A pipeline is the headless equivalent of one of the demo programs: it 
+// takes the image read with readFlags and returns the image to write. The 
+// pipelines made only of neighbourhood operations can also stream the image 
+// in bands of the given number of rows; stream is empty for the others. The 
+// pipelines that find features (the corners of Harris) can also write them 
+// to a file instead of an image, when the extension is csv or bin; 
+// writeData is empty for the others. 
+struct Pipeline {
+    std::string name; 
+    std::string description; 
+    int readFlags; 
+    std::function<cv::Mat(const cv::Mat&, const PipelineParams&)> run; 
+    std::function<void(RowSource&, RowSink&, int, const PipelineParams&)> stream; 
+    std::function<void(const cv::Mat&, const PipelineParams&, const std::string&)> writeData; 
+}; 
+
+// True for the extensions of the files written by writeData (csv, bin). 
+bool IsDataExtension(const std::string& extension); 
+
+const std::vector<Pipeline>& Pipelines(); 
+const Pipeline* FindPipeline(const std::string& name); 
+
+#endif
@@ -0,0 +1,737 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "CannyEdgeDetector.hpp"
+#include "CpuDispatch.hpp"
+#include "DistanceTransformation.hpp"
+#include "Histogram_Equalization.hpp"
+#include "HarrisCornerDetection.hpp"
+#include "HoughTransformationRect.hpp"
+#include "ImagePyramid.hpp"
+#include "K-Means.hpp"
+#include "LowHighPass.hpp"
+#include "MemoryStats.hpp"
+#include "RegionGrowing.hpp"
+#include "Sobel.hpp"
+#include "SplitAndMerge.hpp"
+#include "StripStreaming.hpp"
+#include "Thresholding.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+// Benchmark of the hand-written kernels against the OpenCV functions they 
+// reimplement. Every kernel runs on a ladder of sizes, on synthetic images 
+// and on the bundled images resized to the same sizes; for each run we 
+// report the median latency, the throughput, the allocations per call and 
+// the ratio against the OpenCV reference, optionally as JSON. 
+
+// A kernel of the benchmark. The reference is the matching OpenCV call and 
+// may be missing; maxMegapixels keeps the slowest kernels out of the sizes 
+// where a single call would take minutes (disabled by --no-limits). The 
+// kernels that reimplement another kernel of the repository name it as 
+// their baseline, and their result must be identical to it bit for bit; 
+// the approximate ones (as the mini-batch K-Means) are compared with their 
+// baseline by the squared error of their result against the input instead. 
+// The kernels that compute exactly what their reference computes (the 
+// medians, with the same replicated border as cv::medianBlur) set 
+// exactReference, and their result must be identical to the reference. 
+struct BenchmarkKernel {
+    string name; 
+    bool color; 
+    double maxMegapixels; 
+    function<Mat(const Mat&)> run; 
+    string referenceName; 
+    function<Mat(const Mat&)> reference; 
+    string baseline; 
+    bool approximate = false; 
+    bool exactReference = false; 
+}; 
+
+struct Measurement {
+    double medianMs = 0; 
+    double allocationsPerCall = 0; 
+    double bytesPerCall = 0; 
+    int calls = 0; 
+}; 
+
+struct BenchmarkInput {
+    string name; 
+    Mat gray; 
+    Mat color; 
+}; 
+
+struct Options {
+    vector<double> sizes = {0.25, 1, 4, 16, 64, 100}; 
+    vector<string> kernels; 
+    vector<string> images; 
+    bool synthetic = true; 
+    bool limits = true; 
+    int repeats = 5; 
+    double minSeconds = 0.2; 
+    string jsonFile; 
+    string traceFile; 
+}; 
+
+// The corners as an image of one row per corner (x, y, the bits of the 
+// response and the level), so that they can be compared with SameImage. 
+static Mat CornersImage(const vector<HarrisCorner>& corners) {
+    Mat image(static_cast<int>(corners.size()), 4, CV_32SC1); 
+    for(int i = 0; i < image.rows; i++) {
+        memcpy(image.ptr(i), &corners[i], sizeof(HarrisCorner)); 
+    }
+    return image; 
+}
+
+// The stages applied to the image streamed in bands of bandRows rows, whose 
+// result must be the one of the same filters on the whole image. 
+static Mat StreamedImage(const Mat& src, const vector<StripStage>& stages, int bandRows) {
+    MatRowSource source(src); 
+    MatRowSink sink; 
+    StreamStrips(source, stages, sink, bandRows); 
+    return sink.Result(); 
+}
+
+static vector<BenchmarkKernel> BuildKernels() {
+    vector<BenchmarkKernel> kernels; 
+
+    kernels.push_back({"gaussian3", false, 100, 
+        [](const Mat& src) { Mat input = src; return GaussianFilter(input, 3, 3); },
+        "cv::GaussianBlur", 
+        [](const Mat& src) { Mat dst; GaussianBlur(src, dst, Size(3, 3), 3); return dst; }}); 
+
+    kernels.push_back({"gaussian7", false, 16, 
+        [](const Mat& src) { Mat input = src; return GaussianFilter(input, 7, 3.0f); },
+        "cv::GaussianBlur", 
+        [](const Mat& src) { Mat dst; GaussianBlur(src, dst, Size(7, 7), 3); return dst; }}); 
+
+    kernels.push_back({"gaussian15", false, 16, 
+        [](const Mat& src) { Mat input = src; return GaussianFilter(input, 15, 5.0f); },
+        "cv::GaussianBlur", 
+        [](const Mat& src) { Mat dst; GaussianBlur(src, dst, Size(15, 15), 5); return dst; }}); 
+
+    kernels.push_back({"gaussian7-stream", false, 16, 
+        [](const Mat& src) { return StreamedImage(src, {GaussianFilterStage(7, 3)}, 64); },
+        "cv::GaussianBlur", 
+        [](const Mat& src) { Mat dst; GaussianBlur(src, dst, Size(7, 7), 3); return dst; }, 
+        "gaussian7"}); 
+
+    kernels.push_back({"canny", false, 100, 
+        [](const Mat& src) { Mat input = src; Mat blurred = GaussianFilter(input, 3, 3); return SobelApplication(blurred, 3); },
+        "cv::GaussianBlur+cv::Canny", 
+        [](const Mat& src) { Mat blurred, dst; GaussianBlur(src, blurred, Size(3, 3), 3); Canny(blurred, dst, 50, 100, 3); return dst; }}); 
+
+    kernels.push_back({"canny-fused", false, 100, 
+        [](const Mat& src) { Mat input = src; return FusedCanny(input, 3, 3); },
+        "cv::GaussianBlur+cv::Canny", 
+        [](const Mat& src) { Mat blurred, dst; GaussianBlur(src, blurred, Size(3, 3), 3); Canny(blurred, dst, 50, 100, 3); return dst; }, 
+        "canny"}); 
+
+    kernels.push_back({"sobel", false, 100, 
+        [](const Mat& src) { Mat input = src; return SobelFilter(input).first; },
+        "cv::Sobel x2", 
+        [](const Mat& src) { Mat dx, dy; Sobel(src, dx, CV_16S, 1, 0, 3); Sobel(src, dy, CV_16S, 0, 1, 3); return dx; }}); 
+
+    kernels.push_back({"sobel-signed", false, 100, 
+        [](const Mat& src) { Mat Ix, Iy; SobelDerivatives(src, Ix, Iy); return Ix; },
+        "cv::Sobel x2", 
+        [](const Mat& src) { Mat dx, dy; Sobel(src, dx, CV_16S, 1, 0, 3); Sobel(src, dy, CV_16S, 0, 1, 3); return dx; }}); 
+
+    kernels.push_back({"harris", false, 16, 
+        [](const Mat& src) {
+            Mat input = src; 
+            pair<Mat, Mat> sobelFilter = SobelFilter(input); 
+            Mat Ix = GaussianFilter(sobelFilter.first, 3, 1.0f); 
+            Mat Iy = GaussianFilter(sobelFilter.second, 3, 1.0f); 
+            return HarrisCornerDetector(input, Ix, Iy, 1000); 
+        },
+        "cv::cornerMinEigenVal", 
+        [](const Mat& src) { Mat dst; cornerMinEigenVal(src, dst, 3, 3); return dst; }}); 
+
+    kernels.push_back({"harris-fused", false, 16, 
+        [](const Mat& src) {
+            Mat input = src; 
+            HarrisOptions options; 
+            options.gaussianSize = 3; 
+            return HarrisCornerDetector(input, 1000, options); 
+        },
+        "cv::cornerMinEigenVal", 
+        [](const Mat& src) { Mat dst; cornerMinEigenVal(src, dst, 3, 3); return dst; }}); 
+
+    kernels.push_back({"harris-corners", false, 16, 
+        [](const Mat& src) {
+            HarrisOptions options; 
+            options.gaussianSize = 3; 
+            return CornersImage(DetectHarrisCorners(src, 1000, options)); 
+        },
+        "cv::cornerMinEigenVal", 
+        [](const Mat& src) { Mat dst; cornerMinEigenVal(src, dst, 3, 3); return dst; }}); 
+
+    // Two frames: the image with its central quarter inverted, then the 
+    // image, whose changed tiles are recomputed; the corners of the second 
+    // frame must be the ones of the whole image. 
+    kernels.push_back({"harris-incremental", false, 16, 
+        [](const Mat& src) {
+            HarrisOptions options; 
+            options.gaussianSize = 3; 
+            IncrementalHarris incremental(1000, options); 
+            Mat previous = src.clone(); 
+            Mat center = previous(Rect(src.cols/4, src.rows/4, src.cols/2, src.rows/2)); 
+            bitwise_not(center, center); 
+            incremental.Update(previous); 
+            return CornersImage(incremental.Update(src)); 
+        },
+        "cv::cornerMinEigenVal", 
+        [](const Mat& src) { Mat dst; cornerMinEigenVal(src, dst, 3, 3); return dst; }, 
+        "harris-corners"}); 
+
+    kernels.push_back({"harris-multiscale", false, 16, 
+        [](const Mat& src) {
+            Mat input = src; 
+            HarrisOptions options; 
+            options.gaussianSize = 3; 
+            options.levels = 3; 
+            return HarrisCornerDetector(input, 1000, options); 
+        },
+        "cv::cornerMinEigenVal", 
+        [](const Mat& src) { Mat dst; cornerMinEigenVal(src, dst, 3, 3); return dst; }}); 
+
+    kernels.push_back({"pyramid", false, 100, 
+        [](const Mat& src) { ImagePyramid pyramid(src, 4); return pyramid.Level(3); },
+        "cv::pyrDown x3", 
+        [](const Mat& src) { Mat dst = src; for(int k = 0; k < 3; k++) { pyrDown(dst, dst); } return dst; }}); 
+
+    kernels.push_back({"average", false, 100, 
+        [](const Mat& src) { Mat input = src; return Average(input); },
+        "cv::blur", 
+        [](const Mat& src) { Mat dst; blur(src, dst, Size(3, 3)); return dst; }}); 
+
+    kernels.push_back({"average25", false, 100, 
+        [](const Mat& src) { Mat input = src; return Average(input, 25); },
+        "cv::blur", 
+        [](const Mat& src) { Mat dst; blur(src, dst, Size(51, 51)); return dst; }}); 
+
+    kernels.push_back({"average-stream", false, 100, 
+        [](const Mat& src) { return StreamedImage(src, {AverageStage(1)}, 64); },
+        "cv::blur", 
+        [](const Mat& src) { Mat dst; blur(src, dst, Size(3, 3)); return dst; }, 
+        "average"}); 
+
+    kernels.push_back({"average25-stream", false, 100, 
+        [](const Mat& src) { return StreamedImage(src, {AverageStage(25)}, 64); },
+        "cv::blur", 
+        [](const Mat& src) { Mat dst; blur(src, dst, Size(51, 51)); return dst; }, 
+        "average25"}); 
+
+    kernels.push_back({"median", false, 100, 
+        [](const Mat& src) { Mat input = src; return Median(input); },
+        "cv::medianBlur", 
+        [](const Mat& src) { Mat dst; medianBlur(src, dst, 3); return dst; }, 
+        "", false, true}); 
+
+    kernels.push_back({"median5", false, 100, 
+        [](const Mat& src) { Mat input = src; return Median(input, 2); },
+        "cv::medianBlur", 
+        [](const Mat& src) { Mat dst; medianBlur(src, dst, 5); return dst; }, 
+        "", false, true}); 
+
+    kernels.push_back({"median-stream", false, 100, 
+        [](const Mat& src) { return StreamedImage(src, {MedianStage(1)}, 64); },
+        "cv::medianBlur", 
+        [](const Mat& src) { Mat dst; medianBlur(src, dst, 3); return dst; }, 
+        "median"}); 
+
+    kernels.push_back({"median25", false, 16, 
+        [](const Mat& src) { Mat input = src; return Median(input, 25); },
+        "cv::medianBlur", 
+        [](const Mat& src) { Mat dst; medianBlur(src, dst, 51); return dst; }, 
+        "", false, true}); 
+
+    kernels.push_back({"median25-stream", false, 16, 
+        [](const Mat& src) { return StreamedImage(src, {MedianStage(25)}, 64); },
+        "cv::medianBlur", 
+        [](const Mat& src) { Mat dst; medianBlur(src, dst, 51); return dst; }, 
+        "median25"}); 
+
+    kernels.push_back({"threshold", false, 100, 
+        [](const Mat& src) { Mat input = src; return Threshold(input, 128); },
+        "cv::threshold", 
+        [](const Mat& src) { Mat dst; threshold(src, dst, 127, 255, THRESH_BINARY); return dst; }}); 
+
+    kernels.push_back({"binarization", false, 100, 
+        [](const Mat& src) { return Binarization(src); },
+        "cv::threshold", 
+        [](const Mat& src) { Mat dst; threshold(src, dst, 128, 255, THRESH_BINARY); return dst; }}); 
+
+    kernels.push_back({"equalization", false, 100, 
+        [](const Mat& src) { return GetEqualization(GetProbabilities(src), src); },
+        "cv::equalizeHist", 
+        [](const Mat& src) { Mat dst; equalizeHist(src, dst); return dst; }}); 
+
+    kernels.push_back({"distance4", false, 100, 
+        [](const Mat& src) { return TransformationDistance4(Binarization(src)); },
+        "cv::distanceTransform(L1)", 
+        [](const Mat& src) { Mat binary, dst; threshold(src, binary, 128, 255, THRESH_BINARY); distanceTransform(binary, dst, DIST_L1, 3); return dst; }}); 
+
+    kernels.push_back({"distance8", false, 100, 
+        [](const Mat& src) { return TransformationDistance8(Binarization(src)); },
+        "cv::distanceTransform(C)", 
+        [](const Mat& src) { Mat binary, dst; threshold(src, binary, 128, 255, THRESH_BINARY); distanceTransform(binary, dst, DIST_C, 3); return dst; }}); 
+
+    kernels.push_back({"kmeans", true, 16, 
+        [](const Mat& src) { return K_Means(src, 8, 5, 1); },
+        "cv::kmeans", 
+        [](const Mat& src) {
+            Mat samples, labels, centers; 
+            src.reshape(1, src.rows*src.cols).convertTo(samples, CV_32F); 
+            kmeans(samples, 8, labels, TermCriteria(TermCriteria::MAX_ITER, 5, 0), 1, KMEANS_RANDOM_CENTERS, centers); 
+            return labels; 
+        }}); 
+
+    kernels.push_back({"kmeans-hamerly", true, 16, 
+        [](const Mat& src) { KMeansOptions options; options.hamerly = true; return K_Means(src, 8, 5, 1, options); },
+        "cv::kmeans", 
+        [](const Mat& src) {
+            Mat samples, labels, centers; 
+            src.reshape(1, src.rows*src.cols).convertTo(samples, CV_32F); 
+            kmeans(samples, 8, labels, TermCriteria(TermCriteria::MAX_ITER, 5, 0), 1, KMEANS_RANDOM_CENTERS, centers); 
+            return labels; 
+        }, 
+        "kmeans"}); 
+
+    kernels.push_back({"kmeans-colors", true, 100, 
+        [](const Mat& src) { KMeansOptions options; options.colorBits = 6; return K_Means(src, 8, 5, 1, options); },
+        "cv::kmeans", 
+        [](const Mat& src) {
+            Mat samples, labels, centers; 
+            src.reshape(1, src.rows*src.cols).convertTo(samples, CV_32F); 
+            kmeans(samples, 8, labels, TermCriteria(TermCriteria::MAX_ITER, 5, 0), 1, KMEANS_RANDOM_CENTERS, centers); 
+            return labels; 
+        }}); 
+
+    kernels.push_back({"kmeans-minibatch", true, 100, 
+        [](const Mat& src) { KMeansOptions options; options.miniBatch = 4096; return K_Means(src, 8, 20, 1, options); },
+        "cv::kmeans", 
+        [](const Mat& src) {
+            Mat samples, labels, centers; 
+            src.reshape(1, src.rows*src.cols).convertTo(samples, CV_32F); 
+            kmeans(samples, 8, labels, TermCriteria(TermCriteria::MAX_ITER, 5, 0), 1, KMEANS_RANDOM_CENTERS, centers); 
+            return labels; 
+        }, 
+        "kmeans", true}); 
+
+    kernels.push_back({"regiongrowing", false, 16, 
+        [](const Mat& src) { Mat input = src; return StartGrow(input, 10); },
+        "", nullptr}); 
+
+    kernels.push_back({"splitmerge", false, 16, 
+        [](const Mat& src) {
+            Mat input = src; 
+            Mat resultImage = src.clone(); 
+            Region regionSplitted = Split(input, Rect(0, 0, input.cols, input.rows), 64); 
+            Merge(input, regionSplitted, 64); 
+            Fill(resultImage, regionSplitted); 
+            return resultImage; 
+        },
+        "", nullptr}); 
+
+    kernels.push_back({"hough-line", false, 4, 
+        [](const Mat& src) { Mat edges, drawn = src.clone(); Canny(src, edges, 60, 160, 3); return HoughTransformation(edges, drawn, 100); },
+        "cv::HoughLines", 
+        [](const Mat& src) { Mat edges; Canny(src, edges, 60, 160, 3); vector<Vec2f> lines; HoughLines(edges, lines, 1, CV_PI/180, 100); return edges; }}); 
+
+    return kernels; 
+}
+
+// A deterministic test pattern: smooth gradients for the filters, noise for 
+// the medians, and rectangles and circles for the edge and corner detectors. 
+static Mat SyntheticImage(Size size) {
+    Mat image(size, CV_8UC3); 
+    RNG rng(0x1badcafe); 
+
+    for(int i = 0; i < image.rows; i++) {
+        Vec3b* row = image.ptr<Vec3b>(i); 
+        for(int j = 0; j < image.cols; j++) {
+            int noise = rng.uniform(-12, 13); 
+            row[j] = Vec3b(saturate_cast<uchar>(j*255/max(1, image.cols-1) + noise), 
+                           saturate_cast<uchar>(i*255/max(1, image.rows-1) + noise), 
+                           saturate_cast<uchar>(((i/32 + j/32) % 2) * 160 + 48 + noise)); 
+        }
+    }
+
+    int shapes = max(8, size.area() / 40000); 
+    for(int s = 0; s < shapes; s++) {
+        Point center(rng.uniform(0, image.cols), rng.uniform(0, image.rows)); 
+        int extent = rng.uniform(4, max(5, min(image.cols, image.rows) / 16)); 
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)); 
+        if(s % 2 == 0) {
+            rectangle(image, Rect(center.x, center.y, extent, extent), color, FILLED); 
+        } else {
+            circle(image, center, extent, color, FILLED); 
+        }
+    }
+
+    return image; 
+}
+
+static Size SizeForMegapixels(double megapixels, double aspect) {
+    int width = max(1, cvRound(sqrt(megapixels*1e6*aspect))); 
+    int height = max(1, cvRound(megapixels*1e6/width)); 
+    return Size(width, height); 
+}
+
+static BenchmarkInput MakeInput(const string& name, const Mat& color) {
+    BenchmarkInput input; 
+    input.name = name; 
+    input.color = color; 
+    cvtColor(color, input.gray, COLOR_BGR2GRAY); 
+    return input; 
+}
+
+// Runs the function until both the minimum number of calls and the minimum 
+// time are reached, after one warm-up call, and returns the median latency 
+// together with the allocations recorded during the timed calls. 
+static Measurement Measure(const function<Mat(const Mat&)>& run, const Mat& input, const Options& options) {
+    run(input); 
+
+    vector<double> latencies; 
+    AllocationCounters before = GlobalAllocations(); 
+    double total = 0; 
+
+    while(static_cast<int>(latencies.size()) < options.repeats || total < options.minSeconds) {
+        auto start = chrono::steady_clock::now(); 
+        Mat result = run(input); 
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count(); 
+
+        latencies.push_back(seconds*1000); 
+        total += seconds; 
+
+        // A single call that already takes longer than the whole budget is 
+        // measured just the minimum number of times. 
+        if(static_cast<int>(latencies.size()) >= options.repeats && seconds > options.minSeconds) {
+            break; 
+        }
+    }
+
+    AllocationCounters after = GlobalAllocations(); 
+
+    Measurement measurement; 
+    measurement.calls = static_cast<int>(latencies.size()); 
+    nth_element(latencies.begin(), latencies.begin() + latencies.size()/2, latencies.end()); 
+    measurement.medianMs = latencies[latencies.size()/2]; 
+    measurement.allocationsPerCall = static_cast<double>(after.allocations - before.allocations) / measurement.calls; 
+    measurement.bytesPerCall = static_cast<double>(after.bytes - before.bytes) / measurement.calls; 
+    return measurement; 
+}
+
+// The sample images shipped in the Images/ directory of every algorithm, 
+// in a stable order. 
+static vector<string> BundledImages() {
+    vector<string> images; 
+    const vector<string> extensions = {".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".ppm", ".pgm"}; 
+
+    for(const filesystem::directory_entry& module : filesystem::directory_iterator(IPA_SOURCE_DIR)) {
+        filesystem::path directory = module.path() / "Images"; 
+        if(!filesystem::is_directory(directory)) {
+            continue; 
+        }
+        for(const filesystem::directory_entry& file : filesystem::directory_iterator(directory)) {
+            string extension = file.path().extension().string(); 
+            transform(extension.begin(), extension.end(), extension.begin(), ::tolower); 
+            if(file.is_regular_file() && find(extensions.begin(), extensions.end(), extension) != extensions.end()) {
+                images.push_back(file.path().string()); 
+            }
+        }
+    }
+
+    sort(images.begin(), images.end()); 
+    return images; 
+}
+
+// True when the two images have the same size, type and pixels. 
+static bool SameImage(const Mat& a, const Mat& b) {
+    if(a.size() != b.size() || a.type() != b.type()) {
+        return false; 
+    }
+    for(int i = 0; i < a.rows; i++) {
+        if(memcmp(a.ptr(i), b.ptr(i), a.cols * a.elemSize()) != 0) {
+            return false; 
+        }
+    }
+    return true; 
+}
+
+// The sum of the squared differences between two images of the same size. 
+static double SquaredError(const Mat& a, const Mat& b) {
+    return norm(a, b, NORM_L2SQR); 
+}
+
+static vector<double> ParseList(const string& text) {
+    vector<double> values; 
+    stringstream stream(text); 
+    string item; 
+    while(getline(stream, item, ',')) {
+        values.push_back(stod(item)); 
+    }
+    return values; 
+}
+
+static string JsonEscape(const string& text) {
+    string escaped; 
+    for(char c : text) {
+        if(c == '"' || c == '\\') {
+            escaped += '\\'; 
+        }
+        escaped += c; 
+    }
+    return escaped; 
+}
+
+static void PrintUsage(const char* program) {
+    cout << "Usage: " << program << " [options]" << endl
+         << "  --sizes LIST      megapixels to run, comma separated (default: 0.25,1,4,16,64,100)" << endl
+         << "  --kernel NAME     run only this kernel, can be repeated (see --list)" << endl
+         << "  --image FILE      also run on this image resized to every size, can be repeated" << endl
+         << "  --bundled         also run on every image of the Images/ directories" << endl
+         << "  --no-synthetic    skip the synthetic images" << endl
+         << "  --no-limits       run the slow kernels on every size too" << endl
+         << "  --repeats N       minimum number of timed calls (default: 5)" << endl
+         << "  --min-time SEC    minimum timed seconds per measurement (default: 0.2)" << endl
+         << "  --json FILE       write the results as JSON" << endl
+         << "  --trace FILE      write a Chrome trace of the stages (needs IPA_ENABLE_TRACING)" << endl
+         << "  --list            list the kernels" << endl; 
+}
+
+int main(int argc, char *argv[]) {
+    Options options; 
+    vector<BenchmarkKernel> kernels = BuildKernels(); 
+
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i]; 
+        bool hasValue = i+1 < argc; 
+
+        if(arg == "--sizes" && hasValue) {
+            options.sizes = ParseList(argv[++i]); 
+        } else if(arg == "--kernel" && hasValue) {
+            options.kernels.push_back(argv[++i]); 
+        } else if(arg == "--image" && hasValue) {
+            options.images.push_back(argv[++i]); 
+        } else if(arg == "--bundled") {
+            vector<string> bundled = BundledImages(); 
+            options.images.insert(options.images.end(), bundled.begin(), bundled.end()); 
+        } else if(arg == "--no-synthetic") {
+            options.synthetic = false; 
+        } else if(arg == "--no-limits") {
+            options.limits = false; 
+        } else if(arg == "--repeats" && hasValue) {
+            options.repeats = max(1, atoi(argv[++i])); 
+        } else if(arg == "--min-time" && hasValue) {
+            options.minSeconds = atof(argv[++i]); 
+        } else if(arg == "--json" && hasValue) {
+            options.jsonFile = argv[++i]; 
+        } else if(arg == "--trace" && hasValue) {
+            options.traceFile = argv[++i]; 
+        } else if(arg == "--list") {
+            for(const BenchmarkKernel& kernel : kernels) {
+                cout << kernel.name << "\t" << (kernel.reference ? kernel.referenceName : "-") << endl; 
+            }
+            return 0; 
+        } else {
+            PrintUsage(argv[0]); 
+            return arg == "-h" || arg == "--help" ? 0 : 2; 
+        }
+    }
+
+    const vector<BenchmarkKernel> allKernels = kernels; 
+    if(!options.kernels.empty()) {
+        vector<BenchmarkKernel> selected; 
+        for(const string& name : options.kernels) {
+            auto it = find_if(kernels.begin(), kernels.end(), [&](const BenchmarkKernel& kernel) { return kernel.name == name; }); 
+            if(it == kernels.end()) {
+                cerr << "Unknown kernel '" << name << "'" << endl; 
+                return 2; 
+            }
+            selected.push_back(*it); 
+        }
+        kernels = selected; 
+    }
+
+    InstallMatAllocationCounting(); 
+
+    if(!options.traceFile.empty()) {
+        if(!TracingAvailable()) {
+            cerr << "Tracing is not compiled in, rebuild with -DIPA_ENABLE_TRACING=ON" << endl; 
+            return 2; 
+        }
+        StartTracing(); 
+    }
+
+    // The bundled images are read once at their original size, and resized 
+    // to every size of the ladder only when they are used. 
+    vector<pair<string, Mat>> sources; 
+    if(options.synthetic) {
+        sources.push_back(make_pair(string("synthetic"), Mat())); 
+    }
+    for(const string& file : options.images) {
+        Mat image = imread(file, IMREAD_COLOR); 
+        if(image.empty()) {
+            cerr << "Cannot read " << file << endl; 
+            return 2; 
+        }
+        sources.push_back(make_pair(file, image)); 
+    }
+
+    ostringstream json; 
+    bool firstResult = true; 
+    int mismatches = 0; 
+    json << "{\n  \"opencv_version\": \"" << CV_VERSION << "\",\n  \"isa\": \"" << IsaName(ActiveIsa()) 
+         << "\",\n  \"results\": [\n"; 
+
+    cout << "pixel kernels: " << IsaName(ActiveIsa()) << " (detected " << IsaName(DetectedIsa()) << ")" << endl; 
+
+    cout << left << setw(14) << "kernel" << setw(12) << "input" << right << setw(12) << "size" 
+         << setw(12) << "median ms" << setw(10) << "Mpix/s" << setw(10) << "allocs" 
+         << setw(12) << "ref ms" << setw(10) << "ratio" << setw(8) << "exact" << endl; 
+
+    for(const pair<string, Mat>& source : sources) {
+        for(double megapixels : options.sizes) {
+            double aspect = source.second.empty() ? 4.0/3.0 : static_cast<double>(source.second.cols)/source.second.rows; 
+            Size size = SizeForMegapixels(megapixels, aspect); 
+
+            Mat color; 
+            if(source.second.empty()) {
+                color = SyntheticImage(size); 
+            } else {
+                resize(source.second, color, size, 0, 0, INTER_LINEAR); 
+            }
+            BenchmarkInput input = MakeInput(source.first, color); 
+            double pixels = static_cast<double>(size.area()); 
+
+            for(const BenchmarkKernel& kernel : kernels) {
+                if(options.limits && megapixels > kernel.maxMegapixels) {
+                    continue; 
+                }
+
+                const Mat& image = kernel.color ? input.color : input.gray; 
+                Measurement custom = Measure(kernel.run, image, options); 
+                Measurement reference; 
+                if(kernel.reference) {
+                    reference = Measure(kernel.reference, image, options); 
+                }
+
+                // The kernels with a baseline are checked once per input. For the 
+                // approximate ones errorRatio is their squared error against the 
+                // input divided by the one of the baseline (1 is the same quality). 
+                bool matchesBaseline = true; 
+                double errorRatio = 0; 
+                if(!kernel.baseline.empty()) {
+                    auto baseline = find_if(allKernels.begin(), allKernels.end(), [&](const BenchmarkKernel& other) { return other.name == kernel.baseline; }); 
+                    if(baseline == allKernels.end()) {
+                        matchesBaseline = false; 
+                    } else if(kernel.approximate) {
+                        double baselineError = SquaredError(baseline->run(image), image); 
+                        errorRatio = baselineError > 0 ? SquaredError(kernel.run(image), image) / baselineError : 1; 
+                    } else {
+                        matchesBaseline = SameImage(kernel.run(image), baseline->run(image)); 
+                    }
+                    mismatches += matchesBaseline ? 0 : 1; 
+                }
+                bool matchesReference = true; 
+                if(kernel.exactReference) {
+                    matchesReference = SameImage(kernel.run(image), kernel.reference(image)); 
+                    mismatches += matchesReference ? 0 : 1; 
+                }
+
+                double mpixPerSecond = pixels / (custom.medianMs/1000) / 1e6; 
+                double ratio = kernel.reference ? custom.medianMs / reference.medianMs : 0; 
+                string inputName = source.second.empty() ? source.first : filesystem::path(source.first).stem().string(); 
+
+                cout << left << setw(14) << kernel.name << setw(12) << inputName.substr(0, 11) << right 
+                     << setw(12) << (to_string(size.width) + "x" + to_string(size.height)) 
+                     << setw(12) << fixed << setprecision(3) << custom.medianMs 
+                     << setw(10) << setprecision(1) << mpixPerSecond 
+                     << setw(10) << setprecision(1) << custom.allocationsPerCall; 
+                if(kernel.reference) {
+                    cout << setw(12) << setprecision(3) << reference.medianMs << setw(10) << setprecision(2) << ratio; 
+                } else {
+                    cout << setw(22) << ""; 
+                }
+                if(!kernel.baseline.empty() && kernel.approximate && matchesBaseline) {
+                    cout << setw(8) << setprecision(3) << errorRatio; 
+                } else if(!kernel.baseline.empty() || kernel.exactReference) {
+                    cout << setw(8) << (matchesBaseline && matchesReference ? "yes" : "NO"); 
+                }
+                cout << endl; 
+
+                json << (firstResult ? "" : ",\n") << "    {" 
+                     << "\"kernel\": \"" << kernel.name << "\", " 
+                     << "\"input\": \"" << JsonEscape(source.first) << "\", " 
+                     << "\"width\": " << size.width << ", \"height\": " << size.height << ", " 
+                     << "\"megapixels\": " << pixels/1e6 << ", " 
+                     << "\"calls\": " << custom.calls << ", " 
+                     << "\"median_ms\": " << custom.medianMs << ", " 
+                     << "\"mpix_per_s\": " << mpixPerSecond << ", " 
+                     << "\"allocations_per_call\": " << custom.allocationsPerCall << ", " 
+                     << "\"bytes_per_call\": " << custom.bytesPerCall; 
+                if(kernel.reference) {
+                    json << ", \"reference\": \"" << kernel.referenceName << "\", " 
+                         << "\"reference_median_ms\": " << reference.medianMs << ", " 
+                         << "\"reference_mpix_per_s\": " << pixels / (reference.medianMs/1000) / 1e6 << ", " 
+                         << "\"ratio_vs_opencv\": " << ratio; 
+                    if(kernel.exactReference) {
+                        json << ", \"matches_reference\": " << (matchesReference ? "true" : "false"); 
+                    }
+                }
+                if(!kernel.baseline.empty()) {
+                    json << ", \"baseline\": \"" << kernel.baseline << "\", " 
+                         << "\"matches_baseline\": " << (matchesBaseline ? "true" : "false"); 
+                    if(kernel.approximate) {
+                        json << ", \"error_vs_baseline\": " << errorRatio; 
+                    }
+                }
+                json << "}"; 
+                firstResult = false; 
+            }
+        }
+    }
+
+    json << "\n  ]\n}\n"; 
+
+    if(!options.traceFile.empty()) {
+        StopTracing(); 
+        PrintTraceSummary(cout); 
+        if(!WriteTrace(options.traceFile)) {
+            cerr << "Cannot write " << options.traceFile << endl; 
+            return 1; 
+        }
+    }
+
+    if(!options.jsonFile.empty()) {
+        ofstream file(options.jsonFile); 
+        file << json.str(); 
+        if(!file) {
+            cerr << "Cannot write " << options.jsonFile << endl; 
+            return 1; 
+        }
+    }
+
+    if(mismatches > 0) {
+        cerr << mismatches << " results differ from their baseline or reference" << endl; 
+        return 1; 
+    }
+
+    return 0; 
+}
@@ -1,192 +1,64 @@
+#include <algorithm>
 #include <iostream>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <math.h>
+#include "CannyEdgeDetector.hpp"
+#include "CpuDispatch.hpp"
+#include "StripStreaming.hpp"
+#include "Trace.hpp"
 
 using namespace std; 
 using namespace cv; 
 
-Mat GaussianFilter(Mat& src, int size, int sigma);
-Mat SobelApplication(Mat& src, int kernelSize);
-Mat Thresholding(Mat& src, int maxG);
-
-// Primo passo per l'algoritmo di Canny: Soppressione del rumore dell'immagine 
-// con un filtro, in questo caso usiamo il filtro Gaussiano. 
-Mat GaussianFilter(Mat& src, int size, int sigma) {
-    // La prima matrice è la maschera Gaussiana da applicare all'immagine 
-    // per mezzo di convoluzione. La seconda matrice è l'immagine risultante
-    // dall'operazione di applicazione del filtro Gaussiano. 
-    Mat kernel = Mat_<double>(size, size);
-    Mat result = Mat(src.rows, src.cols, src.type());
-
-    // Vengono calcolati il limite sinistro e quello di destro per poter 
-    // calcolare il kernel Gaussiano. 
-    int leftLimit = floor((kernel.rows/2)*(-1)); 
-    int rightLimit = floor((kernel.cols/2)*(1));
-
-    double summary = 0.0; 
-    double sum = 0.0; 
-    double pix = 0.0; 
-
-    double multConstant = 1/exp(-(pow(leftLimit, 2) + pow(leftLimit, 2)) / (2*pow(sigma,2)));
-
-    // I due cicli for annidati permettono di calcolare la maschera da
-    // applicare all'immagine e permette di calcolare la somma di tutti 
-    // gli elementi che compongono tale maschera. Il risultato di questa 
-    // operazione non è normalizzato. 
-    for(int i = leftLimit; i <= rightLimit; i++) {
-        for(int j = leftLimit; j <= rightLimit; j++) {
-            pix = exp(-(pow(i, 2) + pow(j, 2)) / (2*pow(sigma,2)));
-            kernel.at<double>(i+rightLimit, j+rightLimit) = cvRound(pix * multConstant);
-            sum += kernel.at<double>(i+rightLimit, j+rightLimit);
-        }
-    }
-
-    // Per poter normalizzare il risultato dell'operazione allora ogni 
-    // elemento che compone il kernel deve essere rapportato alla 
-    // somma di tutti gli elementi della maschera. 
-    for(int i = 0; i < kernel.rows; i++) {
-        for(int j = 0; j < kernel.cols; j++) {
-            kernel.at<double>(i, j) /= sum; 
-        }
-    } 
-
-    // La convoluzione è molto pesante dal punto di vista computazionale, 
-    // per cui di solito si sceglie di operare con degli array piuttosto 
-    // che con una matrice (non è questo il caso). I primi due cicli for 
-    // annidati scorrono sull'immagine di partenza fino ad un limite massimo 
-    // definito dalla grandezza della maschera, questo per non sforare i 
-    // limiti della matrice che definisce l'immagine di partenza. 
-    for(int i = 0; i <= src.rows-kernel.rows; i++) {
-        for(int j = 0; j <= src.cols-kernel.cols; j++) {
-            
-            // I cicli for annidati più interni lavorano sulla maschera (kernel) e 
-            // scorrono dall'inizio fino alla fine della matrice del kernel. 
-            // L'operazione svolta all'interno dei due cicli for è quella di ottenere 
-            // la somma di tutti gli elementi della matrice dell'immagine inquadrati 
-            // nella maschera kernel, moltiplicati con i corrispettivi elementi del 
-            // kernel stesso. 
-            for(int x = 0; x < kernel.rows; x++) {
-                for(int y = 0; y < kernel.cols; y++) {
-                    summary += static_cast<double>(src.at<uchar>(x+i, y+j)) * kernel.at<double>(x, y);  
-                }
-            }
-
-            // Al termine dei due cicli for interni si assegna il valore della sommatoria
-            // al pixel centrale della porzione di immagine inquadrata dalla maschera. Ed 
-            // ovviamente si riporta la sommatoria a 0.  
-            result.at<uchar>(i+1, j+1) = static_cast<uchar>((summary));
-            summary = 0.0; 
-
-        } 
-    }
-
-    // Alla fine si restituisce l'immagine risultante. 
-    return result; 
-}
-
-Mat SobelApplication(Mat& src, int kernelSize) {
-    // Volendo applicare il filtro di Sobel, allora bisogna creare prima di 
-    // tutto le due matrici per poter calcolare il gradiente in ognuno dei 
-    // pixel dell'immagine. 
-    Mat sobelX = (Mat_<int>(3, 3) << -1, 0, 1, -2, 0, 2, -1, 0, 1); 
-    Mat sobelY = (Mat_<int>(3, 3) << 1, 2, 1, 0, 0, 0, -1, -2, -1);
-
-    // Dichiariamo alcune variabili necessarie al corretto funzionamento
-    // dell'algoritmo. 
-    double modG = 0.0; 
-    double arcG = 0.0;  
-    double sumX = 0.0; 
-    double sumY = 0.0; 
-    double dirG = 0.0; 
-    double maxG = 0.0; 
+double SobelGradient(Mat& src, Mat& gradModules, Mat& gradDirections) {
+    IPA_TRACE_SCOPE("Sobel", src.total()); 
 
     // La prima matrice riguarda tutte le direzioni dei gradienti calcolati, 
     // mentre la seconda matrice riguarda la magnitudine di ogni pixel. Ognuna 
     // delle due matrici ha le stesse dimensioni dell'immagine originale, ed 
-    // è dello stesso tipo. 
-    Mat gradDirections = Mat(src.rows, src.cols, src.type());
-    Mat gradModules = Mat(src.rows, src.cols, src.type());
-
-    // Applicare Sobel all'immagine significa applicare la maschera, sia X che 
-    // Y per convoluzione. Cioè, si moltiplicano gli elementi della matrice 
-    // inquadrati dalla maschera con gli elementi della maschera stessi, e poi 
-    // si sommano per ottenere un unico numero. Dobbiamo stare attenti ai bordi
-    // dell'immagine, ed infatti la maschera non deve andare oltre le dimensioni 
-    // dell'immagine stessa. 
-    for(int i = 0; i < src.rows-3; i++) {
-        for(int j = 0; j < src.cols-3; j++) {
-            
-            for(int x = 0; x < sobelX.rows; x++) {
-                for(int y = 0; y < sobelX.rows; y++) {
-                    sumX += static_cast<double>(static_cast<int>(src.at<uchar>(x+i, y+j)) * sobelX.at<int>(x, y));
-                    sumY += static_cast<double>(static_cast<int>(src.at<uchar>(x+i, y+j)) * sobelY.at<int>(x, y));
-                }
-            }
-
-            // L'intensità del pixel viene calcolata come la somma dei 
-            // valori assoluti ottenuti dai cicli for più interni. Mentre
-            // l'angolo della direzione viene calcolato attraverso
-            // l'arcotangente del rapporto tra le due somme.  
-			sumX = abs(sumX);
-			sumY = abs(sumY);
-			modG = sumX + sumY;
-			arcG = atan2(sumY, sumX);
-			dirG = arcG*180/M_PI;
-
-            // Ci occorre conoscere l'intensità massima dei pixel per le successive 
-            // elaborazioni, ed in particolare per la fase finale. 
-			if(modG > maxG) {
-				maxG = modG;
-			}
-			
-            // Dobbiamo stabilizzare il valore del pixel nel caso in cui esso 
-            // eccede il valore 255, oppure contestualmente è minore di 0. 
-			modG = modG > 255? 255: modG < 0? 0: modG;
-
-            // Dobbiamo stabilizzare, e quindi normalizzare anche la direzione 
-            // del gradiente calcolata, nel caso in cui essa superi i 180 gradi o
-            // sia minore di 0. 
-            if(dirG > 180) {
-				while(dirG > 180) dirG -= 180;
-			} else if(dirG < 0) {
-				while(dirG < 0) dirG += 180;
-			}
-
-            // Dobbiamo verificare che la direzione del gradiente rientri in uno di 
-            // questi quattro casi, perchè potrebbe appartenere ad un bordo che va
-            // in orizzontale, uno che va in verticale, uno che va in obliquo positivo
-            // e uno che va in obliquo negativo. Questo è un processo approssimativo.  
-            if((dirG >= 0 && dirG < 22.5) || (dirG >= 157.5 && dirG <= 180)) {
-                // Caso studiato::Orizzontale.  
-                dirG = 0; 
-            } else if(dirG >= 22.5 && dirG < 67.5) {
-                // Caso studiato::Obliguo. 
-                // Da destra verso sinistra. 
-                dirG = 45; 
-            } else if(dirG >= 67.5 && dirG < 112.5) {
-                // Caso studiato::Verticale.
-                dirG = 90; 
-            } else if(dirG >= 112.5 && dirG < 157.5) {
-                // Caso studiato::Obliquo. 
-                // Da sinistra verso destra. 
-                dirG = 135; 
-            } 
-
-            // Gli elementi calcolati vengono poi inseriti all'interno delle matrici
-            // che sono state create appositamente per contenerli. 
-            gradDirections.at<uchar>(i, j) = dirG;
-            gradModules.at<uchar>(i, j) = modG; 
+    // è dello stesso tipo. Le ultime righe e colonne, dove la maschera non 
+    // può essere applicata, restano a 0. 
+    gradDirections = Mat::zeros(src.rows, src.cols, src.type());
+    gradModules = Mat::zeros(src.rows, src.cols, src.type());
+
+    // Applicare Sobel all'immagine significa applicare le maschere X e Y 
+    // 
+    //   -1  0  1        1  2  1 
+    //   -2  0  2        0  0  0 
+    //   -1  0  1       -1 -2 -1 
+    // 
+    // per convoluzione: il pixel (i, j) si calcola dalle righe i..i+2 e dalle 
+    // colonne j..j+2, quindi la maschera non va oltre l'immagine. Per ogni 
+    // riga il kernel sobelRow calcola i valori assoluti delle due derivate, e 
+    // il kernel gradientRow l'intensità (la loro somma, limitata a 255) e la 
+    // direzione del gradiente approssimata a 0, 45 o 90 gradi: orizzontale 
+    // fino a 22.5 gradi, obliqua fino a 67.5, verticale oltre. Con i valori 
+    // assoluti la direzione a 135 gradi non si presenta mai. I kernel sono 
+    // quelli vettoriali scelti all'avvio per la CPU (CpuDispatch.hpp). 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    int count = src.cols-3; 
+    vector<int16_t> gx(max(count, 0)); 
+    vector<int16_t> gy(max(count, 0)); 
+
+    // Ci occorre conoscere l'intensità massima dei pixel per le successive 
+    // elaborazioni, ed in particolare per la fase finale. 
+    int maxG = 0; 
+
+    for(int i = 0; i < src.rows-3 && count > 0; i++) {
+        kernels.sobelRow(src.ptr<uchar>(i), src.ptr<uchar>(i+1), src.ptr<uchar>(i+2), count, gx.data(), gy.data()); 
+        maxG = max(maxG, kernels.gradientRow(gx.data(), gy.data(), count, gradModules.ptr<uchar>(i), gradDirections.ptr<uchar>(i))); 
+    }
 
-            // Si riportano i valori delle variabili a 0 per la prossima iterazione. 
-            sumX = 0.0; 
-            sumY = 0.0; 
-            modG = 0.0; 
-            arcG = 0.0; 
-            dirG = 0.0; 
+    // L'intensità massima serve per le soglie della fase finale. 
+    return maxG; 
+}
 
-        }
-    }
+Mat NonMaximaSuppression(Mat& gradModules, Mat& gradDirections, int kernelSize) {
+    IPA_TRACE_SCOPE("NonMaximaSuppression", gradModules.total()); 
 
     // Un pixel fa parte di un contorno se esso ha intensità massima rispetto ai suoi vicini 
     // più prossimi, quindi i pixel che si trovano a nord, a sud, a est, a ovest, oppure a 
@@ -196,8 +68,8 @@ Mat SobelApplication(Mat& src, int kernelSize) {
     // Le dimensioni delle due nuove matrici quindi saranno pari a quelle delle matrici precedenti 
     // con l'aggiunta del pad. 
     int pad = floor(kernelSize/2);
-    Mat paddedModules = Mat(gradModules.rows+pad, gradModules.cols+pad, gradModules.type());
-    Mat paddedDirections = Mat(gradDirections.rows+pad, gradDirections.cols+pad, gradDirections.type());
+    Mat paddedModules = Mat::zeros(gradModules.rows+pad, gradModules.cols+pad, gradModules.type());
+    Mat paddedDirections = Mat::zeros(gradDirections.rows+pad, gradDirections.cols+pad, gradDirections.type());
 
     // Gli elementi delle due matrici vengono copiati all'interno delle due nuove matrici, facendo 
     // attenzione ad inserirli in modo tale che vi sia un bordo di elementi pari a 0 su ogni lato 
@@ -209,18 +81,30 @@ Mat SobelApplication(Mat& src, int kernelSize) {
         }
     }
 
+    // La soppressione confronta sempre le intensità originali: i pixel soppressi 
+    // vengono azzerati in una copia, cosi il risultato di un pixel non dipende 
+    // dall'ordine in cui sono stati visitati i suoi vicini. I vicini che cadono 
+    // fuori dalla matrice valgono 0. 
+    Mat suppressedModules = paddedModules.clone(); 
+    auto module = [&paddedModules](int i, int j) -> int {
+        if(i < 0 || j < 0 || i >= paddedModules.rows || j >= paddedModules.cols) {
+            return 0; 
+        }
+        return paddedModules.at<uchar>(i, j); 
+    }; 
+
     // I due cicli for procedono sulla matrice con il pad. Ad ogni iterazione del ciclo più interno 
     // si estrapolano i pixel più prossimi al pixel corrente, oltre che la sua direzione. 
     for(int i = (pad-1); i < paddedModules.rows-(pad-1); i++) {
         for(int j = (pad-1); j < paddedModules.cols-(pad-1); j++) {
-            int nord = paddedModules.at<uchar>(i-1, j);
-            int sud = paddedModules.at<uchar>(i+1, j); 
-            int est = paddedModules.at<uchar>(i, j+1);
-            int ovest = paddedModules.at<uchar>(i, j-1);
-            int nest = paddedModules.at<uchar>(i-1, j+1);
-            int sest = paddedModules.at<uchar>(i+1, j+1);
-            int sovest = paddedModules.at<uchar>(i+1, j-1);
-            int novest = paddedModules.at<uchar>(i-1, j-1); 
+            int nord = module(i-1, j);
+            int sud = module(i+1, j); 
+            int est = module(i, j+1);
+            int ovest = module(i, j-1);
+            int nest = module(i-1, j+1);
+            int sest = module(i+1, j+1);
+            int sovest = module(i+1, j-1);
+            int novest = module(i-1, j-1); 
 
             int currentDirection = paddedDirections.at<uchar>(i, j);
             int currentModules = paddedModules.at<uchar>(i, j);
@@ -233,38 +117,49 @@ Mat SobelApplication(Mat& src, int kernelSize) {
             if(currentDirection == 0) {
                 // Caso studiato::Orizzontale. 
                 if(currentModules < est || currentModules < ovest) {
-                    paddedModules.at<uchar>(i, j) = 0; 
+                    suppressedModules.at<uchar>(i, j) = 0; 
                 }
             } else if(currentDirection == 90) {
                 // Caso studiato::Verticale. 
                 if(currentModules < nord || currentModules < sud) {
-                    paddedModules.at<uchar>(i, j) = 0; 
+                    suppressedModules.at<uchar>(i, j) = 0; 
                 }
             } else if(currentDirection == 45) {
                 // Caso studiato::Obliquo. 
                 if(currentModules < novest || currentModules < sest) {
-                    paddedModules.at<uchar>(i, j) = 0; 
+                    suppressedModules.at<uchar>(i, j) = 0; 
                 }
             } else if(currentDirection == 135) {
                 // Caso studiato::Obliquo. 
                 if(currentModules < nest || currentModules < sovest) {
-                    paddedModules.at<uchar>(i, j) = 0; 
+                    suppressedModules.at<uchar>(i, j) = 0; 
                 }
             }
         }
     }
 
+    return suppressedModules; 
+}
+
+Mat SobelApplication(Mat& src, int kernelSize) {
+    Mat gradModules; 
+    Mat gradDirections; 
+    double maxG = SobelGradient(src, gradModules, gradDirections); 
+    Mat suppressedModules = NonMaximaSuppression(gradModules, gradDirections, kernelSize); 
+
     // La fase finale dell'algoritmo consiste nel fare il threshold 
     // sull'immagine ottenuta dall'operazione di Sobel. La funzione 
     // quindi prende in input la matrice delle intensità dei pixel 
     // dell'immagine e l'intensità massima. 
-    Mat thresholding = Thresholding(paddedModules, maxG); 
+    Mat thresholding = Thresholding(suppressedModules, maxG); 
 
     // Si restituisce il risultato finale delle operazioni. 
     return thresholding; 
 }
 
 Mat Thresholding(Mat& src, int maxG) {
+    IPA_TRACE_SCOPE("Thresholding", src.total()); 
+
     Mat resultImage = Mat(src.rows, src.cols, src.type()); 
 
     // Ci occorrono le due soglie per effettuare l'ultima operazione 
@@ -273,6 +168,13 @@ Mat Thresholding(Mat& src, int maxG) {
     int tLow = cvRound(maxG*0.05);
     int tHigh = cvRound(maxG*0.1);
 
+    auto module = [&src](int i, int j) -> int {
+        if(i < 0 || j < 0 || i >= src.rows || j >= src.cols) {
+            return 0; 
+        }
+        return src.at<uchar>(i, j); 
+    }; 
+
     // I cicli for annidati sono scorrono sull'immagine data in input 
     // per poter verificare pixel per pixel se rispettano i vincoli 
     // imposti, ossia che l'intensità del pixel corrente sia maggiore
@@ -302,15 +204,15 @@ Mat Thresholding(Mat& src, int maxG) {
                 */
 
                 // Si devono prendere in considerazione i pixel che circondano il pixel 
-                // che stiamo tenendo in considerazione. 
-                int nord = src.at<uchar>(i-1, j); 
-                int sud = src.at<uchar>(i+1, j); 
-                int est = src.at<uchar>(i, j+1); 
-                int ovest = src.at<uchar>(i, j-1); 
-                int nest = src.at<uchar>(i-1, j+1); 
-                int sest = src.at<uchar>(i+1, j+1); 
-                int sovest = src.at<uchar>(i+1, j-1); 
-                int novest = src.at<uchar>(i-1, j-1); 
+                // che stiamo tenendo in considerazione (0 fuori dall'immagine). 
+                int nord = module(i-1, j); 
+                int sud = module(i+1, j); 
+                int est = module(i, j+1); 
+                int ovest = module(i, j-1); 
+                int nest = module(i-1, j+1); 
+                int sest = module(i+1, j+1); 
+                int sovest = module(i+1, j-1); 
+                int novest = module(i-1, j-1); 
 
                 // Se uno di questi è un pixel che rispetta la prima condizione allora può essere 
                 // considerato come un bordo dell'immagine. 
@@ -333,40 +235,181 @@ Mat Thresholding(Mat& src, int maxG) {
     return resultImage; 
 }
 
-int main(int argc, char *argv[]) {
-    // Si prende in input l'immagine iniziale sulla quale applicare l'algoritmo 
-    // di Canny Edge Detector. 
-    string inputFile = argv[1]; 
-    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
+Mat FusedCanny(Mat& src, int size, int sigma) {
+    IPA_TRACE_SCOPE("FusedCanny", src.total()); 
+
+    int rows = src.rows; 
+    int cols = src.cols; 
+    GaussianKernel kernel = MakeGaussianKernel(size, sigma); 
+    int radius = size/2; 
+    vector<uint16_t> scratch(cols); 
+    vector<const uchar*> sourceRows(size); 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    vector<int16_t> gx(max(cols-3, 0)); 
+    vector<int16_t> gy(max(cols-3, 0)); 
+
+    // Le righe intermedie vivono in anelli di tre righe: le righe filtrate con 
+    // il filtro Gaussiano che servono a Sobel, e le righe di intensità e 
+    // direzione (già con il pad) che servono alla soppressione dei non massimi. 
+    // Le righe del gradiente hanno una colonna in più per lato, sempre a 0, 
+    // cosi i vicini fuori dalla matrice valgono 0 come in NonMaximaSuppression. 
+    Mat blurredRing = Mat::zeros(3, cols, CV_8UC1); 
+    Mat modulesRing = Mat::zeros(3, cols+3, CV_8UC1); 
+    Mat directionsRing = Mat::zeros(3, cols+3, CV_8UC1); 
+    Mat zeroRow = Mat::zeros(1, cols+3, CV_8UC1); 
+
+    // L'unica matrice intera è quella dei moduli dopo la soppressione, perché 
+    // le soglie finali dipendono dall'intensità massima di tutta l'immagine. 
+    Mat suppressedModules = Mat::zeros(rows+1, cols+1, CV_8UC1); 
+    double maxG = 0.0; 
+
+    // La riga r del filtro Gaussiano, calcolata da GaussianFilterRow come in 
+    // GaussianFilter a partire dalle righe r-radius..r+radius; le righe troppo 
+    // vicine al bordo valgono 0. 
+    auto blurRow = [&](int r) {
+        uchar* out = blurredRing.ptr<uchar>(r % 3); 
+
+        if(r < radius || r+radius >= rows) {
+            memset(out, 0, cols); 
+            return; 
+        }
+
+        for(int k = 0; k < size; k++) {
+            sourceRows[k] = src.ptr<uchar>(r-radius+k); 
+        }
+        GaussianFilterRow(kernel, sourceRows.data(), cols, scratch.data(), out); 
+    }; 
+
+    // La riga i del gradiente, cioè la riga i+1 delle matrici con il pad, 
+    // calcolata come SobelGradient dalle righe filtrate i..i+2, con gli stessi 
+    // kernel. 
+    auto gradientRow = [&](int i) {
+        uchar* modules = modulesRing.ptr<uchar>(i % 3); 
+        uchar* directions = directionsRing.ptr<uchar>(i % 3); 
+        memset(modules, 0, cols+3); 
+        memset(directions, 0, cols+3); 
+
+        if(i >= rows-3) {
+            return; 
+        }
+
+        const uchar* r0 = blurredRing.ptr<uchar>(i % 3); 
+        const uchar* r1 = blurredRing.ptr<uchar>((i+1) % 3); 
+        const uchar* r2 = blurredRing.ptr<uchar>((i+2) % 3); 
+
+        // La colonna j del gradiente è la colonna j+1 con il pad, più la 
+        // colonna di guardia. 
+        kernels.sobelRow(r0, r1, r2, cols-3, gx.data(), gy.data()); 
+        int rowMax = kernels.gradientRow(gx.data(), gy.data(), cols-3, modules+2, directions+2); 
+        if(rowMax > maxG) {
+            maxG = rowMax; 
+        }
+    }; 
+
+    int nextBlurred = 0; 
+    for(int r = 0; r <= rows; r++) {
+        // Prima si calcola la riga r+1 con il pad (la riga r del gradiente), 
+        // l'ultima che serve per sopprimere la riga r. 
+        if(r < rows) {
+            if(r < rows-3) {
+                for(; nextBlurred <= r+2; nextBlurred++) {
+                    blurRow(nextBlurred); 
+                }
+            }
+            gradientRow(r); 
+        }
+
+        // Le righe r-1, r e r+1 con il pad; la riga 0 e quelle oltre la fine 
+        // valgono 0. 
+        const uchar* above = r >= 2 ? modulesRing.ptr<uchar>((r-2) % 3) : zeroRow.ptr<uchar>(); 
+        const uchar* current = r >= 1 ? modulesRing.ptr<uchar>((r-1) % 3) : zeroRow.ptr<uchar>(); 
+        const uchar* below = r < rows ? modulesRing.ptr<uchar>(r % 3) : zeroRow.ptr<uchar>(); 
+        const uchar* directions = r >= 1 ? directionsRing.ptr<uchar>((r-1) % 3) : zeroRow.ptr<uchar>(); 
+        uchar* out = suppressedModules.ptr<uchar>(r); 
+
+        // La colonna c con il pad è all'indice c+1 delle righe con la guardia. 
+        for(int c = 0; c <= cols; c++) {
+            int k = c+1; 
+            int currentModule = current[k]; 
+            bool suppressed = false; 
+
+            switch(directions[k]) {
+                case 0: 
+                    suppressed = currentModule < current[k+1] || currentModule < current[k-1]; 
+                    break; 
+                case 90: 
+                    suppressed = currentModule < above[k] || currentModule < below[k]; 
+                    break; 
+                case 45: 
+                    suppressed = currentModule < above[k-1] || currentModule < below[k+1]; 
+                    break; 
+                case 135: 
+                    suppressed = currentModule < above[k+1] || currentModule < below[k-1]; 
+                    break; 
+            }
 
-    // Utilizzo della funzione di soppressione del rumore con filtro 
-    // Gaussiano scritta da capo. 
-    Mat gaussianFilter = GaussianFilter(inputImage, 3, 3); 
+            out[c] = suppressed ? 0 : currentModule; 
+        }
+    }
 
-    // Per un confronto, utilizzo della funzione di soppressione del rumore 
-    // con filtro Gaussiano di OpenCv. 
-    Mat workGBlur = Mat(inputImage);
-    workGBlur = inputImage.clone();
-    cv::GaussianBlur(inputImage, workGBlur, cv::Size(3, 3), 3);
+    return Thresholding(suppressedModules, maxG); 
+}
 
-    // Utilizzo della funzione di applicazione del filtro di Sobel, 
-    // oltre che l'applicazione del threshold sul risultato finale. 
-    Mat sobelApplication = SobelApplication(gaussianFilter, 3);
+// Le fasi dell'algoritmo come fasi della elaborazione a bande. Il filtro 
+// Gaussiano scrive il pixel (i, j) a partire dalle righe i-size/2..i+size/2. 
+StripStage GaussianFilterStage(int size, int sigma) {
+    return {"GaussianFilter", size/2, size/2, 0, [size, sigma](const Mat& band) {
+        Mat input = band; 
+        return GaussianFilter(input, size, sigma); 
+    }}; 
+}
 
-    // Si mostrano i risultati di ogni passo in apposite finestre. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE);
-    imshow("Original Image", inputImage);
+// Sobel scrive il pixel (i, j) a partire dalle righe i..i+2, ma non calcola 
+// le ultime tre righe dell'immagine: con tre righe sotto ogni riga della banda 
+// è calcolata esattamente come sull'immagine intera. Intensità e direzione 
+// passano alla fase successiva come i due canali di una sola matrice, e se 
+// maxG non è nullo vi si accumula l'intensità massima. 
+static StripStage SobelGradientStage(double* maxG) {
+    return {"Sobel", 0, 3, 0, [maxG](const Mat& band) {
+        Mat input = band; 
+        Mat gradModules; 
+        Mat gradDirections; 
+        double bandMax = SobelGradient(input, gradModules, gradDirections); 
+        if(maxG != nullptr) {
+            *maxG = max(*maxG, bandMax); 
+        }
 
-    namedWindow("Custom Gauss", WINDOW_AUTOSIZE);
-    imshow("Custom Gauss", gaussianFilter);
+        Mat gradient; 
+        merge(vector<Mat>{gradModules, gradDirections}, gradient); 
+        return gradient; 
+    }}; 
+}
 
-    namedWindow("OpenCV Gauss", WINDOW_AUTOSIZE);
-    imshow("OpenCV Gauss", workGBlur);
+// La soppressione dei non massimi aggiunge una riga (il pad) in cima: la 
+// riga r del risultato dipende dalle righe r-2..r del gradiente. 
+static StripStage NonMaximaSuppressionStage() {
+    return {"NonMaximaSuppression", 2, 0, 1, [](const Mat& band) {
+        vector<Mat> gradient; 
+        split(band, gradient); 
+        return NonMaximaSuppression(gradient[0], gradient[1], 3); 
+    }}; 
+}
 
-    namedWindow("Custom Sobel Application", WINDOW_AUTOSIZE);
-    imshow("Custom Sobel Application", sobelApplication);
+static StripStage ThresholdingStage(double maxG) {
+    return {"Thresholding", 1, 1, 0, [maxG](const Mat& band) {
+        Mat input = band; 
+        return Thresholding(input, maxG); 
+    }}; 
+}
 
-    waitKey(0); 
+void StreamCanny(RowSource& source, RowSink& sink, int size, int sigma, int bandRows) {
+    // Le soglie dell'ultima fase dipendono dall'intensità massima di tutta 
+    // l'immagine, quindi una prima passata calcola soltanto il filtro Gaussiano 
+    // e Sobel per conoscerla, e la seconda passata esegue tutte le fasi. 
+    double maxG = 0.0; 
+    DiscardRowSink discard; 
+    StreamStrips(source, {GaussianFilterStage(size, sigma), SobelGradientStage(&maxG)}, discard, bandRows); 
 
-    return 0; 
+    source.Rewind(); 
+    StreamStrips(source, {GaussianFilterStage(size, sigma), SobelGradientStage(nullptr), NonMaximaSuppressionStage(), ThresholdingStage(maxG)}, sink, bandRows); 
 }
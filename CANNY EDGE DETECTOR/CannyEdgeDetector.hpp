@@ -0,0 +1,32 @@
+#ifndef CANNY_EDGE_DETECTOR_HPP
+#define CANNY_EDGE_DETECTOR_HPP
+
+#include <opencv2/opencv.hpp>
+#include "GaussianFilter.hpp"
+#include "StripStreaming.hpp"
+
+// I passi dell'algoritmo di Canny Edge Detector: la soppressione del rumore 
+// con il filtro Gaussiano (GaussianFilter, in comune con Harris), 
+// l'applicazione di Sobel con la soppressione dei non massimi, e infine la 
+// sogliatura con isteresi (richiamata da Sobel). 
+cv::Mat SobelApplication(cv::Mat& src, int kernelSize);
+cv::Mat Thresholding(cv::Mat& src, int maxG);
+
+// Le fasi di SobelApplication: il gradiente (restituisce l'intensità massima) 
+// e la soppressione dei non massimi, che aggiunge il pad in alto e a sinistra. 
+double SobelGradient(cv::Mat& src, cv::Mat& gradModules, cv::Mat& gradDirections);
+cv::Mat NonMaximaSuppression(cv::Mat& gradModules, cv::Mat& gradDirections, int kernelSize);
+
+// Canny fuso: il filtro Gaussiano, Sobel e la soppressione dei non massimi 
+// procedono riga per riga su anelli di tre righe, senza le matrici intermedie 
+// dell'immagine intera. Il risultato è identico, bit per bit, a quello di 
+// GaussianFilter seguito da SobelApplication(..., 3). 
+cv::Mat FusedCanny(cv::Mat& src, int size, int sigma);
+
+// Canny a bande di bandRows righe, per le immagini che non stanno in memoria: 
+// il risultato è identico a quello di GaussianFilter seguito da 
+// SobelApplication(..., 3), ma la sorgente viene letta due volte. 
+StripStage GaussianFilterStage(int size, int sigma);
+void StreamCanny(RowSource& source, RowSink& sink, int size, int sigma, int bandRows);
+
+#endif
@@ -0,0 +1,46 @@
+#include <iostream>
+#include <cstdio>
+#include <opencv2/opencv.hpp>
+#include "CannyEdgeDetector.hpp"
+#include <math.h>
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    // Si prende in input l'immagine iniziale sulla quale applicare l'algoritmo 
+    // di Canny Edge Detector. 
+    string inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
+
+    // Utilizzo della funzione di soppressione del rumore con filtro 
+    // Gaussiano scritta da capo. 
+    Mat gaussianFilter = GaussianFilter(inputImage, 3, 3); 
+
+    // Per un confronto, utilizzo della funzione di soppressione del rumore 
+    // con filtro Gaussiano di OpenCv. 
+    Mat workGBlur = Mat(inputImage);
+    workGBlur = inputImage.clone();
+    cv::GaussianBlur(inputImage, workGBlur, cv::Size(3, 3), 3);
+
+    // Utilizzo della funzione di applicazione del filtro di Sobel, 
+    // oltre che l'applicazione del threshold sul risultato finale. 
+    Mat sobelApplication = SobelApplication(gaussianFilter, 3);
+
+    // Si mostrano i risultati di ogni passo in apposite finestre. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE);
+    imshow("Original Image", inputImage);
+
+    namedWindow("Custom Gauss", WINDOW_AUTOSIZE);
+    imshow("Custom Gauss", gaussianFilter);
+
+    namedWindow("OpenCV Gauss", WINDOW_AUTOSIZE);
+    imshow("OpenCV Gauss", workGBlur);
+
+    namedWindow("Custom Sobel Application", WINDOW_AUTOSIZE);
+    imshow("Custom Sobel Application", sobelApplication);
+
+    waitKey(0); 
+
+    return 0; 
+}
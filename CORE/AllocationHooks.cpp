@@ -0,0 +1,48 @@
+#include <cstdlib>
+#include <new>
+#include "MemoryStats.hpp"
+
+// Replacement of the global allocation functions, so that every operator 
+// new of the program is recorded in MemoryStats. It is linked only into the 
+// programs that measure allocations (not into the library), because the 
+// replacement is process-wide. 
+
+static void* CountedAlloc(std::size_t size) {
+    RecordAllocation(size); 
+    void* p = std::malloc(size ? size : 1); 
+    if(p == nullptr) {
+        throw std::bad_alloc(); 
+    }
+    return p; 
+}
+
+static void* CountedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    RecordAllocation(size); 
+    void* p = nullptr; 
+    std::size_t alignment = static_cast<std::size_t>(align); 
+    if(alignment < sizeof(void*)) {
+        alignment = sizeof(void*); 
+    }
+    if(posix_memalign(&p, alignment, size ? size : 1) != 0) {
+        throw std::bad_alloc(); 
+    }
+    return p; 
+}
+
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { try { return CountedAlloc(size); } catch(...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { try { return CountedAlloc(size); } catch(...) { return nullptr; } }
+void* operator new(std::size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
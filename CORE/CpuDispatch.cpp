@@ -0,0 +1,116 @@
+#include <cstdlib>
+#include <iostream>
+#include "CpuDispatch.hpp"
+
+#if defined(IPA_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace std; 
+
+// The tables of PixelKernels*.cpp. Only the scalar one exists on every 
+// platform; CMake defines IPA_X86_KERNELS when it builds the others. 
+extern const PixelKernels pixelKernelsScalar; 
+#if defined(IPA_X86_KERNELS)
+extern const PixelKernels pixelKernelsSSE42; 
+extern const PixelKernels pixelKernelsAVX2; 
+extern const PixelKernels pixelKernelsAVX512BW; 
+#endif
+
+static const char* const isaNames[] = {"scalar", "sse4.2", "avx2", "avx512bw"}; 
+
+const char* IsaName(IsaLevel level) {
+    return isaNames[static_cast<int>(level)]; 
+}
+
+bool ParseIsa(const string& name, IsaLevel& level) {
+    for(int i = 0; i < 4; i++) {
+        if(name == isaNames[i]) {
+            level = static_cast<IsaLevel>(i); 
+            return true; 
+        }
+    }
+    return false; 
+}
+
+IsaLevel DetectedIsa() {
+#if defined(IPA_X86_KERNELS) && defined(_MSC_VER)
+    // The AVX registers can be used only when the operating system saves 
+    // them (XCR0 bits 1-2, and 5-7 for AVX-512). 
+    int info[4]; 
+    __cpuid(info, 0); 
+    int maxLeaf = info[0]; 
+    __cpuid(info, 1); 
+    bool sse42 = (info[2] & (1 << 20)) != 0; 
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6; 
+    bool osAvx512 = osAvx && (_xgetbv(0) & 0xe6) == 0xe6; 
+    bool avx2 = false; 
+    bool avx512bw = false; 
+    if(maxLeaf >= 7) {
+        __cpuidex(info, 7, 0); 
+        avx2 = osAvx && (info[1] & (1 << 5)) != 0; 
+        avx512bw = osAvx512 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0; 
+    }
+#elif defined(IPA_X86_KERNELS)
+    // The builtins check the operating system support of the AVX registers 
+    // too. 
+    __builtin_cpu_init(); 
+    bool sse42 = __builtin_cpu_supports("sse4.2"); 
+    bool avx2 = __builtin_cpu_supports("avx2"); 
+    bool avx512bw = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"); 
+#else
+    bool sse42 = false; 
+    bool avx2 = false; 
+    bool avx512bw = false; 
+#endif
+
+    if(avx512bw) {
+        return IsaLevel::AVX512BW; 
+    }
+    if(avx2) {
+        return IsaLevel::AVX2; 
+    }
+    if(sse42) {
+        return IsaLevel::SSE42; 
+    }
+    return IsaLevel::Scalar; 
+}
+
+// The detected level, lowered to IPA_ISA when it names a lower one. A level 
+// above the detected one cannot run and is ignored. 
+static IsaLevel SelectIsa() {
+    IsaLevel level = DetectedIsa(); 
+    const char* requested = getenv("IPA_ISA"); 
+    if(requested == nullptr || *requested == '\0') {
+        return level; 
+    }
+
+    IsaLevel cap; 
+    if(!ParseIsa(requested, cap)) {
+        cerr << "IPA_ISA: unknown level '" << requested << "' (scalar, sse4.2, avx2, avx512bw), using " << IsaName(level) << endl; 
+        return level; 
+    }
+    return cap < level ? cap : level; 
+}
+
+IsaLevel ActiveIsa() {
+    static const IsaLevel level = SelectIsa(); 
+    return level; 
+}
+
+const PixelKernels& PixelKernelsFor(IsaLevel level) {
+    switch(level) {
+#if defined(IPA_X86_KERNELS)
+        case IsaLevel::AVX512BW: return pixelKernelsAVX512BW; 
+        case IsaLevel::AVX2: return pixelKernelsAVX2; 
+        case IsaLevel::SSE42: return pixelKernelsSSE42; 
+#endif
+        default: return pixelKernelsScalar; 
+    }
+}
+
+const PixelKernels& ActivePixelKernels() {
+    static const PixelKernels& kernels = PixelKernelsFor(ActiveIsa()); 
+    return kernels; 
+}
@@ -0,0 +1,94 @@
+#ifndef CPU_DISPATCH_HPP
+#define CPU_DISPATCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <opencv2/opencv.hpp>
+
+// Runtime dispatch of the hot pixel kernels. Every kernel of PixelKernels is 
+// compiled once per instruction set level (CORE/PixelKernels.inl, included 
+// by one translation unit per level), and the table of the best level the 
+// CPU supports is chosen on first use. The environment variable IPA_ISA 
+// (scalar, sse4.2, avx2, avx512bw) caps the level, so that the benchmark 
+// can compare the levels on the same machine. Every level gives the same 
+// result, bit for bit. 
+
+enum class IsaLevel {
+    Scalar = 0,
+    SSE42 = 1,
+    AVX2 = 2,
+    AVX512BW = 3,
+}; 
+
+// The row kernels. The rows are plain arrays of cols values; the kernels 
+// never read or write past them. 
+struct PixelKernels {
+    // dst[j] = src[j] >= level ? 255 : 0, for any level. 
+    void (*thresholdRow)(const uchar* src, uchar* dst, int cols, int level); 
+
+    // dst[j] = lut[src[j]], with a table of 256 entries. 
+    void (*lookupRow)(const uchar* src, uchar* dst, int cols, const uchar* lut); 
+
+    // The absolute Sobel derivatives of the 3x3 neighbourhoods of three 
+    // consecutive rows: gx[j] and gy[j] come from the columns j..j+2, for 
+    // j < count (the rows have at least count+2 columns). 
+    void (*sobelRow)(const uchar* r0, const uchar* r1, const uchar* r2, int count, int16_t* gx, int16_t* gy); 
+
+    // The Canny gradient of the absolute derivatives: modules[j] is gx+gy 
+    // saturated to 255, directions[j] its direction quantized to 0, 45 or 
+    // 90 degrees. Returns the largest gx+gy of the row (0 when count is 0). 
+    int (*gradientRow)(const int16_t* gx, const int16_t* gy, int count, uchar* modules, uchar* directions); 
+
+    // columnSums[j] += sign*row[j], with sign 1 or -1. 
+    void (*accumulateRow)(int* columnSums, const uchar* row, int cols, int sign); 
+
+    // out[j] = (prefix[j+window] - prefix[j] + area/2) / area, the rounded 
+    // mean of a window of a row of column sums given as prefix sums. 
+    void (*divideRow)(const uint32_t* prefix, int cols, int window, int area, uchar* out); 
+
+    // labels[j] is the index of the centroid nearest (in squared Euclidean 
+    // distance, the first one on ties) to the BGR pixel j of a CV_8UC3 row. 
+    // The k centroids (1 to 256) are stored as three planes: blue values 
+    // in centroids[0..k-1], green in centroids[k..2k-1], red after them. 
+    void (*nearestCentroidRow)(const uchar* bgr, int cols, const int16_t* centroids, int k, uchar* labels); 
+
+    // nearestCentroidRow that also stores the squared distances from the 
+    // nearest centroid and from the second nearest (INT32_MAX when k is 1). 
+    void (*nearestTwoCentroidsRow)(const uchar* bgr, int cols, const int16_t* centroids, int k, uchar* labels, int32_t* nearestDistances, int32_t* secondDistances); 
+
+    // sobelRow with the signed derivatives: gx[j] is the right column minus 
+    // the left one, gy[j] the top row minus the bottom one (-1020 to 1020). 
+    void (*signedSobelRow)(const uchar* r0, const uchar* r1, const uchar* r2, int count, int16_t* gx, int16_t* gy); 
+
+    // The products of the derivatives of the structure tensor: xx[j] = 
+    // gx[j]^2, yy[j] = gy[j]^2, xy[j] = gx[j]*gy[j], exact as floats. 
+    void (*tensorRow)(const int16_t* gx, const int16_t* gy, int count, float* xx, float* yy, float* xy); 
+
+    // out[j] is the median of the window of the pixels [j, j+2*radius] of 
+    // the 2*radius+1 rows padded, with radius 1 or 2 (3x3 or 5x5). 
+    void (*medianNetworkRow)(const uchar* const* padded, int radius, int cols, uchar* out); 
+
+    // The separable Gaussian filter of the output row centred in the size 
+    // rows (size odd, at most cols): the weights sum to 256, scratch holds 
+    // cols 16 bit values, and dst[j] is written for radius <= j < cols-radius. 
+    void (*gaussianRow)(const uint16_t* weights, int size, const uchar* const* rows, int cols, uint16_t* scratch, uchar* dst); 
+}; 
+
+// The best level supported by the CPU (and by the operating system, for the 
+// AVX registers) among those compiled into the library. 
+IsaLevel DetectedIsa(); 
+
+// The level in use: DetectedIsa() capped by IPA_ISA, chosen once. 
+IsaLevel ActiveIsa(); 
+
+// The kernels of ActiveIsa(), and those of a given level (which must not be 
+// above DetectedIsa()). 
+const PixelKernels& ActivePixelKernels(); 
+const PixelKernels& PixelKernelsFor(IsaLevel level); 
+
+// "scalar", "sse4.2", "avx2" or "avx512bw", and back. ParseIsa returns false 
+// for an unknown name. 
+const char* IsaName(IsaLevel level); 
+bool ParseIsa(const std::string& name, IsaLevel& level); 
+
+#endif
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "CpuDispatch.hpp"
+#include "GaussianFilter.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+GaussianKernel MakeGaussianKernel(int size, float sigma) {
+    if(size <= 0 || size % 2 == 0) {
+        throw invalid_argument("the size of the Gaussian mask must be odd and positive: " + to_string(size)); 
+    }
+    if(sigma <= 0) {
+        sigma = 0.3f*((size-1)*0.5f - 1) + 0.8f; 
+    }
+
+    int radius = size/2; 
+    vector<double> values(size); 
+    for(int k = 0; k < size; k++) {
+        values[k] = exp(-double((k-radius)*(k-radius)) / (2.0*sigma*sigma)); 
+    }
+    double sum = accumulate(values.begin(), values.end(), 0.0); 
+
+    // The weights are rounded down, then the units still missing go to the
+    // pairs with the largest remainders, so the mask stays symmetric and
+    // sums to exactly one; an odd unit goes to the centre.
+    GaussianKernel kernel; 
+    kernel.size = size; 
+    kernel.weights.resize(size); 
+    vector<double> remainders(radius); 
+    int missing = GaussianKernel::one; 
+    for(int k = 0; k < size; k++) {
+        double scaled = values[k] / sum * GaussianKernel::one; 
+        kernel.weights[k] = static_cast<uint16_t>(floor(scaled)); 
+        missing -= kernel.weights[k]; 
+        if(k < radius) {
+            remainders[k] = scaled - floor(scaled); 
+        }
+    }
+
+    vector<int> order(radius); 
+    iota(order.begin(), order.end(), 0); 
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return remainders[a] > remainders[b]; }); 
+    for(int k : order) {
+        if(missing < 2) {
+            break; 
+        }
+        kernel.weights[k]++; 
+        kernel.weights[size-1-k]++; 
+        missing -= 2; 
+    }
+    kernel.weights[radius] += missing; 
+
+    return kernel; 
+}
+
+void GaussianFilterRow(const GaussianKernel& kernel, const uchar* const* rows, int cols, uint16_t* scratch, uchar* dst) {
+    int radius = kernel.size/2; 
+    if(cols < kernel.size) {
+        fill(dst, dst + cols, 0); 
+        return; 
+    }
+    fill(dst, dst + radius, 0); 
+    fill(dst + cols-radius, dst + cols, 0); 
+
+    ActivePixelKernels().gaussianRow(kernel.weights.data(), kernel.size, rows, cols, scratch, dst); 
+}
+
+Mat GaussianFilter(Mat& src, int size, float sigma) {
+    IPA_TRACE_SCOPE("GaussianFilter", src.total()); 
+
+    if(src.type() != CV_8UC1) {
+        throw invalid_argument("the Gaussian filter needs a CV_8UC1 image"); 
+    }
+
+    GaussianKernel kernel = MakeGaussianKernel(size, sigma); 
+    int radius = size/2; 
+    Mat result = Mat::zeros(src.rows, src.cols, CV_8UC1); 
+    vector<uint16_t> scratch(src.cols); 
+    vector<const uchar*> rows(size); 
+
+    for(int i = radius; i+radius < src.rows; i++) {
+        for(int k = 0; k < size; k++) {
+            rows[k] = src.ptr<uchar>(i-radius+k); 
+        }
+        GaussianFilterRow(kernel, rows.data(), src.cols, scratch.data(), result.ptr<uchar>(i)); 
+    }
+
+    return result; 
+}
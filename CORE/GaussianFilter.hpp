@@ -0,0 +1,40 @@
+#ifndef GAUSSIAN_FILTER_HPP
+#define GAUSSIAN_FILTER_HPP
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Separable Gaussian filter shared by Canny and Harris. The 2D mask is the
+// product of two 1D fixed-point masks, so a pixel costs 2*size taps instead
+// of size*size, and the whole computation is done on integers: a vertical
+// pass into 16 bit sums, then a horizontal pass rounded back to 8 bits. The
+// sizes 3, 5, 7 and 9 have unrolled specializations; the two passes are
+// the gaussianRow kernel of CpuDispatch.hpp, chosen at run time from the
+// instruction sets of the CPU. All the paths give the same result, bit for
+// bit.
+
+// Weights of a 1D mask, symmetric, in fixed point: they sum to
+// GaussianKernel::one.
+struct GaussianKernel {
+    static const int shift = 8; 
+    static const int one = 1 << shift; 
+
+    int size = 0; 
+    std::vector<uint16_t> weights; 
+}; 
+
+// The mask of an odd size. With sigma <= 0 sigma is derived from the size,
+// as in cv::GaussianBlur. Throws std::invalid_argument for even sizes.
+GaussianKernel MakeGaussianKernel(int size, float sigma); 
+
+// Filters one row: rows points to the kernel.size input rows centred on the
+// output row, scratch to cols 16 bit values. The kernel.size/2 columns at the
+// left and right borders of dst are set to 0.
+void GaussianFilterRow(const GaussianKernel& kernel, const uchar* const* rows, int cols, uint16_t* scratch, uchar* dst); 
+
+// Filters a CV_8UC1 image. The pixels closer than size/2 to the border,
+// where the mask does not fit in the image, are set to 0.
+cv::Mat GaussianFilter(cv::Mat& src, int size, float sigma); 
+
+#endif
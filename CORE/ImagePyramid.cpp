@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "ImagePyramid.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+// The reflected border of cv::pyrDown (BORDER_REFLECT_101): -1 is 1, n is 
+// n-2, reflected again while outside for the images of one or two pixels. 
+static inline int Reflect(int i, int n) {
+    if(n == 1) {
+        return 0; 
+    }
+    while(i < 0 || i >= n) {
+        i = i < 0 ? -i : 2*n - 2 - i; 
+    }
+    return i; 
+}
+
+Mat DownsampleHalf(const Mat& src) {
+    IPA_TRACE_SCOPE("DownsampleHalf", src.total()); 
+
+    if(src.type() != CV_8UC1) {
+        throw invalid_argument("DownsampleHalf needs a CV_8UC1 image: type " + to_string(src.type())); 
+    }
+
+    int rows = (src.rows + 1) / 2; 
+    int cols = (src.cols + 1) / 2; 
+    Mat dst(rows, cols, CV_8UC1); 
+    if(rows == 0 || cols == 0) {
+        return dst; 
+    }
+
+    // The vertical sums have two more columns on each side, reflected, so 
+    // that the horizontal pass needs no test at the borders. A sum is at 
+    // most 16*255, so it fits in 16 bits, and the plain loop over the row 
+    // is vectorized by the compiler. 
+    vector<uint16_t> sums(src.cols + 4); 
+    uint16_t* centre = sums.data() + 2; 
+    for(int i = 0; i < rows; i++) {
+        const uchar* r0 = src.ptr<uchar>(Reflect(2*i-2, src.rows)); 
+        const uchar* r1 = src.ptr<uchar>(Reflect(2*i-1, src.rows)); 
+        const uchar* r2 = src.ptr<uchar>(Reflect(2*i, src.rows)); 
+        const uchar* r3 = src.ptr<uchar>(Reflect(2*i+1, src.rows)); 
+        const uchar* r4 = src.ptr<uchar>(Reflect(2*i+2, src.rows)); 
+        for(int j = 0; j < src.cols; j++) {
+            centre[j] = static_cast<uint16_t>(r0[j] + r4[j] + 4*(r1[j] + r3[j]) + 6*r2[j]); 
+        }
+        for(int j = 1; j <= 2; j++) {
+            centre[-j] = centre[Reflect(-j, src.cols)]; 
+            centre[src.cols-1+j] = centre[Reflect(src.cols-1+j, src.cols)]; 
+        }
+
+        uchar* out = dst.ptr<uchar>(i); 
+        for(int j = 0; j < cols; j++) {
+            const uint16_t* s = centre + 2*j; 
+            int sum = s[-2] + s[2] + 4*(s[-1] + s[1]) + 6*s[0]; 
+            out[j] = static_cast<uchar>((sum + 128) >> 8); 
+        }
+    }
+
+    return dst; 
+}
+
+ImagePyramid::ImagePyramid(const Mat& image, int levels) {
+    if(image.type() != CV_8UC1) {
+        throw invalid_argument("ImagePyramid needs a CV_8UC1 image: type " + to_string(image.type())); 
+    }
+    if(levels < 1) {
+        throw invalid_argument("an image pyramid needs at least one level: " + to_string(levels)); 
+    }
+    this->levels.resize(levels); 
+    this->levels[0] = image; 
+}
+
+int ImagePyramid::Levels() const {
+    return static_cast<int>(this->levels.size()); 
+}
+
+const Mat& ImagePyramid::Level(int k) {
+    if(k < 0 || k >= this->Levels()) {
+        throw out_of_range("the pyramid has no level " + to_string(k)); 
+    }
+
+    lock_guard<mutex> lock(this->guard); 
+    for(; this->built <= k; this->built++) {
+        this->levels[this->built] = DownsampleHalf(this->levels[this->built-1]); 
+    }
+    return this->levels[k]; 
+}
+
+int ImagePyramid::Scale(int k) {
+    return 1 << k; 
+}
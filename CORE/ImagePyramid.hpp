@@ -0,0 +1,45 @@
+#ifndef IMAGE_PYRAMID_HPP
+#define IMAGE_PYRAMID_HPP
+
+#include <mutex>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Halves a CV_8UC1 image with the 5x5 binomial mask ([1 4 6 4 1]/16 in both 
+// directions) and the reflected border of cv::pyrDown: the output has 
+// (rows+1)/2 rows and (cols+1)/2 columns, and pixel (i, j) is the mask 
+// centred on input pixel (2i, 2j). The mask is separable and the work is 
+// done on integers: a vertical pass of the five input rows into 16 bit 
+// sums, then a horizontal pass on the even columns only, rounded back to 
+// 8 bits, so a pixel costs 10 taps instead of 25. 
+cv::Mat DownsampleHalf(const cv::Mat& src); 
+
+// A pyramid of an image: level 0 is the image itself (shared, not copied), 
+// level k is DownsampleHalf of level k-1. The levels are built on first use 
+// and cached, so the algorithms that work at several scales (or run more 
+// than once on the same image) build every level once. Level() can be 
+// called from several threads. 
+class ImagePyramid {
+    public: 
+    // Throws std::invalid_argument if the image is not CV_8UC1 or levels is 
+    // below 1. 
+    ImagePyramid(const cv::Mat& image, int levels); 
+
+    ImagePyramid(const ImagePyramid&) = delete; 
+    ImagePyramid& operator=(const ImagePyramid&) = delete; 
+
+    int Levels() const; 
+
+    // Level k (0 <= k < Levels()), built with the missing levels before it. 
+    const cv::Mat& Level(int k); 
+
+    // The size of a pixel of level k in pixels of level 0: 2^k. 
+    static int Scale(int k); 
+
+    private: 
+    std::vector<cv::Mat> levels; 
+    int built = 1; 
+    std::mutex guard; 
+}; 
+
+#endif
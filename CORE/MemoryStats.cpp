@@ -0,0 +1,64 @@
+#include <atomic>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include "MemoryStats.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+static atomic<uint64_t> globalAllocations(0); 
+static atomic<uint64_t> globalBytes(0); 
+static thread_local AllocationCounters threadCounters; 
+
+void RecordAllocation(size_t bytes) {
+    globalAllocations.fetch_add(1, memory_order_relaxed); 
+    globalBytes.fetch_add(bytes, memory_order_relaxed); 
+    threadCounters.allocations++; 
+    threadCounters.bytes += bytes; 
+}
+
+AllocationCounters GlobalAllocations() {
+    AllocationCounters counters; 
+    counters.allocations = globalAllocations.load(memory_order_relaxed); 
+    counters.bytes = globalBytes.load(memory_order_relaxed); 
+    return counters; 
+}
+
+AllocationCounters ThreadAllocations() {
+    return threadCounters; 
+}
+
+// The buffers are still allocated and released by the wrapped allocator, 
+// which stays the owner (currAllocator) of every UMatData it creates: 
+// this class only records the size of the new buffers. 
+class CountingMatAllocator : public MatAllocator {
+    public: 
+    explicit CountingMatAllocator(const MatAllocator* inner) : inner(inner) {}
+
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, AccessFlag flags, UMatUsageFlags usageFlags) const override {
+        UMatData* u = this->inner->allocate(dims, sizes, type, data, step, flags, usageFlags); 
+        if(u != nullptr && data == nullptr) {
+            RecordAllocation(u->size); 
+        }
+        return u; 
+    }
+
+    bool allocate(UMatData* data, AccessFlag accessFlags, UMatUsageFlags usageFlags) const override {
+        return this->inner->allocate(data, accessFlags, usageFlags); 
+    }
+
+    void deallocate(UMatData* data) const override {
+        this->inner->deallocate(data); 
+    }
+
+    private: 
+    const MatAllocator* inner; 
+}; 
+
+void InstallMatAllocationCounting() {
+    static once_flag installed; 
+    call_once(installed, [] {
+        static CountingMatAllocator allocator(Mat::getDefaultAllocator()); 
+        Mat::setDefaultAllocator(&allocator); 
+    }); 
+}
@@ -0,0 +1,27 @@
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Counters of the heap allocations made by the process. They are fed by 
+// the cv::Mat allocator installed with InstallMatAllocationCounting() and, 
+// in the programs linking AllocationHooks.cpp, by the global operator new. 
+struct AllocationCounters {
+    uint64_t allocations = 0; 
+    uint64_t bytes = 0; 
+}; 
+
+void RecordAllocation(size_t bytes); 
+
+// Totals since the start of the process, over all the threads. 
+AllocationCounters GlobalAllocations(); 
+
+// Totals of the calling thread only. 
+AllocationCounters ThreadAllocations(); 
+
+// Wraps the default cv::Mat allocator so that every new Mat buffer is 
+// recorded. Calling it more than once has no further effect. 
+void InstallMatAllocationCounting(); 
+
+#endif
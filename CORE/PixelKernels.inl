@@ -0,0 +1,894 @@
+// The pixel kernels of CpuDispatch.hpp, compiled once per instruction set 
+// level. The including file defines IPA_KERNEL_LEVEL (the IsaLevel value, 
+// 0 to 3) and IPA_KERNEL_TABLE (the name of the table to define), and is 
+// compiled with the flags of its level. Every level uses the widest vectors 
+// it has and finishes the row with the scalar loop, which is the whole 
+// kernel at level 0, so all the levels give the same result. 
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "CpuDispatch.hpp"
+
+#if IPA_KERNEL_LEVEL > 0
+#include <immintrin.h>
+#endif
+
+using namespace std; 
+using namespace cv; 
+
+namespace {
+
+void ThresholdRow(const uchar* src, uchar* dst, int cols, int level) {
+    if(level <= 0 || level > 255) {
+        memset(dst, level <= 0 ? 255 : 0, cols); 
+        return; 
+    }
+
+    int j = 0; 
+
+    // A byte is at least level when max(byte, level) is the byte itself. 
+#if IPA_KERNEL_LEVEL == 3
+    const __m512i threshold = _mm512_set1_epi8(static_cast<char>(level)); 
+    for(; j+64 <= cols; j += 64) {
+        __m512i values = _mm512_loadu_si512(src + j); 
+        _mm512_storeu_si512(dst + j, _mm512_movm_epi8(_mm512_cmpge_epu8_mask(values, threshold))); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    const __m256i threshold = _mm256_set1_epi8(static_cast<char>(level)); 
+    for(; j+32 <= cols; j += 32) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + j)); 
+        __m256i result = _mm256_cmpeq_epi8(_mm256_max_epu8(values, threshold), values); 
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), result); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    const __m128i threshold = _mm_set1_epi8(static_cast<char>(level)); 
+    for(; j+16 <= cols; j += 16) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j)); 
+        __m128i result = _mm_cmpeq_epi8(_mm_max_epu8(values, threshold), values); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), result); 
+    }
+#endif
+
+    for(; j < cols; j++) {
+        dst[j] = src[j] >= level ? 255 : 0; 
+    }
+}
+
+// The table is split in 16 tables of 16 entries, one per high nibble: the 
+// byte shuffle looks up the low nibble in every table, and each lane keeps 
+// the entry of the table of its high nibble. 
+void LookupRow(const uchar* src, uchar* dst, int cols, const uchar* lut) {
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    __m512i tables[16]; 
+    for(int h = 0; h < 16; h++) {
+        tables[h] = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut + 16*h))); 
+    }
+    const __m512i nibble = _mm512_set1_epi8(0x0F); 
+    for(; j+64 <= cols; j += 64) {
+        __m512i values = _mm512_loadu_si512(src + j); 
+        __m512i low = _mm512_and_si512(values, nibble); 
+        __m512i high = _mm512_and_si512(_mm512_srli_epi16(values, 4), nibble); 
+        __m512i result = _mm512_setzero_si512(); 
+        for(int h = 0; h < 16; h++) {
+            __mmask64 hit = _mm512_cmpeq_epi8_mask(high, _mm512_set1_epi8(static_cast<char>(h))); 
+            result = _mm512_mask_shuffle_epi8(result, hit, tables[h], low); 
+        }
+        _mm512_storeu_si512(dst + j, result); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    __m256i tables[16]; 
+    for(int h = 0; h < 16; h++) {
+        tables[h] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut + 16*h))); 
+    }
+    const __m256i nibble = _mm256_set1_epi8(0x0F); 
+    for(; j+32 <= cols; j += 32) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + j)); 
+        __m256i low = _mm256_and_si256(values, nibble); 
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(values, 4), nibble); 
+        __m256i result = _mm256_setzero_si256(); 
+        for(int h = 0; h < 16; h++) {
+            __m256i hit = _mm256_cmpeq_epi8(high, _mm256_set1_epi8(static_cast<char>(h))); 
+            result = _mm256_or_si256(result, _mm256_and_si256(hit, _mm256_shuffle_epi8(tables[h], low))); 
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), result); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    __m128i tables[16]; 
+    for(int h = 0; h < 16; h++) {
+        tables[h] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut + 16*h)); 
+    }
+    const __m128i nibble = _mm_set1_epi8(0x0F); 
+    for(; j+16 <= cols; j += 16) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j)); 
+        __m128i low = _mm_and_si128(values, nibble); 
+        __m128i high = _mm_and_si128(_mm_srli_epi16(values, 4), nibble); 
+        __m128i result = _mm_setzero_si128(); 
+        for(int h = 0; h < 16; h++) {
+            __m128i hit = _mm_cmpeq_epi8(high, _mm_set1_epi8(static_cast<char>(h))); 
+            result = _mm_or_si128(result, _mm_and_si128(hit, _mm_shuffle_epi8(tables[h], low))); 
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), result); 
+    }
+#endif
+
+    for(; j < cols; j++) {
+        dst[j] = lut[src[j]]; 
+    }
+}
+
+// The derivatives fit in 16 bits (at most 1020 in absolute value); with 
+// absolute they are stored as absolute values, as Canny needs them. 
+template<bool absolute>
+void SobelRows(const uchar* r0, const uchar* r1, const uchar* r2, int count, int16_t* gx, int16_t* gy) {
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    auto load = [](const uchar* p) { return _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }; 
+    for(; j+32 <= count; j += 32) {
+        __m512i a0 = load(r0 + j), b0 = load(r0 + j+1), c0 = load(r0 + j+2); 
+        __m512i a1 = load(r1 + j), c1 = load(r1 + j+2); 
+        __m512i a2 = load(r2 + j), b2 = load(r2 + j+1), c2 = load(r2 + j+2); 
+        __m512i middle = _mm512_sub_epi16(c1, a1); 
+        __m512i x = _mm512_add_epi16(_mm512_add_epi16(_mm512_sub_epi16(c0, a0), _mm512_sub_epi16(c2, a2)), _mm512_add_epi16(middle, middle)); 
+        __m512i top = _mm512_add_epi16(_mm512_add_epi16(a0, c0), _mm512_add_epi16(b0, b0)); 
+        __m512i bottom = _mm512_add_epi16(_mm512_add_epi16(a2, c2), _mm512_add_epi16(b2, b2)); 
+        __m512i y = _mm512_sub_epi16(top, bottom); 
+        if constexpr(absolute) {
+            x = _mm512_abs_epi16(x); 
+            y = _mm512_abs_epi16(y); 
+        }
+        _mm512_storeu_si512(gx + j, x); 
+        _mm512_storeu_si512(gy + j, y); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    auto load = [](const uchar* p) { return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }; 
+    for(; j+16 <= count; j += 16) {
+        __m256i a0 = load(r0 + j), b0 = load(r0 + j+1), c0 = load(r0 + j+2); 
+        __m256i a1 = load(r1 + j), c1 = load(r1 + j+2); 
+        __m256i a2 = load(r2 + j), b2 = load(r2 + j+1), c2 = load(r2 + j+2); 
+        __m256i middle = _mm256_sub_epi16(c1, a1); 
+        __m256i x = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(c0, a0), _mm256_sub_epi16(c2, a2)), _mm256_add_epi16(middle, middle)); 
+        __m256i top = _mm256_add_epi16(_mm256_add_epi16(a0, c0), _mm256_add_epi16(b0, b0)); 
+        __m256i bottom = _mm256_add_epi16(_mm256_add_epi16(a2, c2), _mm256_add_epi16(b2, b2)); 
+        __m256i y = _mm256_sub_epi16(top, bottom); 
+        if constexpr(absolute) {
+            x = _mm256_abs_epi16(x); 
+            y = _mm256_abs_epi16(y); 
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(gx + j), x); 
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(gy + j), y); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    auto load = [](const uchar* p) { return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))); }; 
+    for(; j+8 <= count; j += 8) {
+        __m128i a0 = load(r0 + j), b0 = load(r0 + j+1), c0 = load(r0 + j+2); 
+        __m128i a1 = load(r1 + j), c1 = load(r1 + j+2); 
+        __m128i a2 = load(r2 + j), b2 = load(r2 + j+1), c2 = load(r2 + j+2); 
+        __m128i middle = _mm_sub_epi16(c1, a1); 
+        __m128i x = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(c0, a0), _mm_sub_epi16(c2, a2)), _mm_add_epi16(middle, middle)); 
+        __m128i top = _mm_add_epi16(_mm_add_epi16(a0, c0), _mm_add_epi16(b0, b0)); 
+        __m128i bottom = _mm_add_epi16(_mm_add_epi16(a2, c2), _mm_add_epi16(b2, b2)); 
+        __m128i y = _mm_sub_epi16(top, bottom); 
+        if constexpr(absolute) {
+            x = _mm_abs_epi16(x); 
+            y = _mm_abs_epi16(y); 
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gx + j), x); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gy + j), y); 
+    }
+#endif
+
+    for(; j < count; j++) {
+        int x = -r0[j] + r0[j+2] - 2*r1[j] + 2*r1[j+2] - r2[j] + r2[j+2]; 
+        int y = r0[j] + 2*r0[j+1] + r0[j+2] - r2[j] - 2*r2[j+1] - r2[j+2]; 
+        gx[j] = static_cast<int16_t>(absolute ? abs(x) : x); 
+        gy[j] = static_cast<int16_t>(absolute ? abs(y) : y); 
+    }
+}
+
+void SobelRow(const uchar* r0, const uchar* r1, const uchar* r2, int count, int16_t* gx, int16_t* gy) {
+    SobelRows<true>(r0, r1, r2, count, gx, gy); 
+}
+
+void SignedSobelRow(const uchar* r0, const uchar* r1, const uchar* r2, int count, int16_t* gx, int16_t* gy) {
+    SobelRows<false>(r0, r1, r2, count, gx, gy); 
+}
+
+// The products of two derivatives are at most 1020^2 < 2^24 in absolute 
+// value, so they are computed in 32 bit lanes and are exact as floats. 
+void TensorRow(const int16_t* gx, const int16_t* gy, int count, float* xx, float* yy, float* xy) {
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    for(; j+16 <= count; j += 16) {
+        __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gx + j))); 
+        __m512i y = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gy + j))); 
+        _mm512_storeu_ps(xx + j, _mm512_cvtepi32_ps(_mm512_mullo_epi32(x, x))); 
+        _mm512_storeu_ps(yy + j, _mm512_cvtepi32_ps(_mm512_mullo_epi32(y, y))); 
+        _mm512_storeu_ps(xy + j, _mm512_cvtepi32_ps(_mm512_mullo_epi32(x, y))); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    for(; j+8 <= count; j += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gx + j))); 
+        __m256i y = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gy + j))); 
+        _mm256_storeu_ps(xx + j, _mm256_cvtepi32_ps(_mm256_mullo_epi32(x, x))); 
+        _mm256_storeu_ps(yy + j, _mm256_cvtepi32_ps(_mm256_mullo_epi32(y, y))); 
+        _mm256_storeu_ps(xy + j, _mm256_cvtepi32_ps(_mm256_mullo_epi32(x, y))); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    for(; j+4 <= count; j += 4) {
+        __m128i x = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(gx + j))); 
+        __m128i y = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(gy + j))); 
+        _mm_storeu_ps(xx + j, _mm_cvtepi32_ps(_mm_mullo_epi32(x, x))); 
+        _mm_storeu_ps(yy + j, _mm_cvtepi32_ps(_mm_mullo_epi32(y, y))); 
+        _mm_storeu_ps(xy + j, _mm_cvtepi32_ps(_mm_mullo_epi32(x, y))); 
+    }
+#endif
+
+    for(; j < count; j++) {
+        int x = gx[j]; 
+        int y = gy[j]; 
+        xx[j] = static_cast<float>(x*x); 
+        yy[j] = static_cast<float>(y*y); 
+        xy[j] = static_cast<float>(x*y); 
+    }
+}
+
+// The direction of the gradient without the arctangent. With gx, gy >= 0 
+// the angle is below 22.5 degrees if (gx+gy)^2 < 2*gx^2, and at least 67.5 
+// degrees if gy >= gx and (gy-gx)^2 >= 2*gx^2; the integer thresholds are 
+// never hit exactly, so this is the quantization of atan2. The squares of 
+// the derivatives (up to 1020) need 32 bits. 
+inline uchar QuantizedDirection(int gx, int gy) {
+    int64_t x = gx; 
+    int64_t y = gy; 
+
+    if((x+y)*(x+y) < 2*x*x || (x == 0 && y == 0)) {
+        return 0; 
+    }
+    if(y >= x && (y-x)*(y-x) >= 2*x*x) {
+        return 90; 
+    }
+    return 45; 
+}
+
+#if IPA_KERNEL_LEVEL == 2
+// The directions of eight gradients in 32 bit lanes. 
+inline __m256i Directions8(__m256i x, __m256i y) {
+    __m256i sum = _mm256_add_epi32(x, y); 
+    __m256i difference = _mm256_sub_epi32(y, x); 
+    __m256i twoSquares = _mm256_slli_epi32(_mm256_mullo_epi32(x, x), 1); 
+    __m256i horizontal = _mm256_or_si256(_mm256_cmpgt_epi32(twoSquares, _mm256_mullo_epi32(sum, sum)), _mm256_cmpeq_epi32(sum, _mm256_setzero_si256())); 
+    __m256i notVertical = _mm256_or_si256(_mm256_cmpgt_epi32(x, y), _mm256_cmpgt_epi32(twoSquares, _mm256_mullo_epi32(difference, difference))); 
+    __m256i direction = _mm256_blendv_epi8(_mm256_set1_epi32(90), _mm256_set1_epi32(45), notVertical); 
+    return _mm256_andnot_si256(horizontal, direction); 
+}
+#elif IPA_KERNEL_LEVEL == 1
+inline __m128i Directions4(__m128i x, __m128i y) {
+    __m128i sum = _mm_add_epi32(x, y); 
+    __m128i difference = _mm_sub_epi32(y, x); 
+    __m128i twoSquares = _mm_slli_epi32(_mm_mullo_epi32(x, x), 1); 
+    __m128i horizontal = _mm_or_si128(_mm_cmpgt_epi32(twoSquares, _mm_mullo_epi32(sum, sum)), _mm_cmpeq_epi32(sum, _mm_setzero_si128())); 
+    __m128i notVertical = _mm_or_si128(_mm_cmpgt_epi32(x, y), _mm_cmpgt_epi32(twoSquares, _mm_mullo_epi32(difference, difference))); 
+    __m128i direction = _mm_blendv_epi8(_mm_set1_epi32(90), _mm_set1_epi32(45), notVertical); 
+    return _mm_andnot_si128(horizontal, direction); 
+}
+#endif
+
+int GradientRow(const int16_t* gx, const int16_t* gy, int count, uchar* modules, uchar* directions) {
+    int maxModule = 0; 
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    __m512i maxima = _mm512_setzero_si512(); 
+    for(; j+16 <= count; j += 16) {
+        __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gx + j))); 
+        __m512i y = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(gy + j))); 
+        __m512i sum = _mm512_add_epi32(x, y); 
+        __m512i difference = _mm512_sub_epi32(y, x); 
+        __m512i twoSquares = _mm512_slli_epi32(_mm512_mullo_epi32(x, x), 1); 
+        __mmask16 horizontal = _mm512_cmplt_epi32_mask(_mm512_mullo_epi32(sum, sum), twoSquares) | _mm512_cmpeq_epi32_mask(sum, _mm512_setzero_si512()); 
+        __mmask16 vertical = _mm512_cmpge_epi32_mask(y, x) & _mm512_cmpge_epi32_mask(_mm512_mullo_epi32(difference, difference), twoSquares); 
+        __m512i direction = _mm512_mask_blend_epi32(vertical, _mm512_set1_epi32(45), _mm512_set1_epi32(90)); 
+        direction = _mm512_maskz_mov_epi32(static_cast<__mmask16>(~horizontal), direction); 
+
+        maxima = _mm512_max_epi32(maxima, sum); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(modules + j), _mm512_cvtusepi32_epi8(sum)); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(directions + j), _mm512_cvtepi32_epi8(direction)); 
+    }
+    maxModule = _mm512_reduce_max_epi32(maxima); 
+#elif IPA_KERNEL_LEVEL == 2
+    __m256i maxima = _mm256_setzero_si256(); 
+    for(; j+8 <= count; j += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gx + j))); 
+        __m256i y = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gy + j))); 
+        __m256i sum = _mm256_add_epi32(x, y); 
+        __m256i direction = Directions8(x, y); 
+
+        maxima = _mm256_max_epi32(maxima, sum); 
+        __m128i sums = _mm_packs_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)); 
+        __m128i codes = _mm_packs_epi32(_mm256_castsi256_si128(direction), _mm256_extracti128_si256(direction, 1)); 
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(modules + j), _mm_packus_epi16(sums, sums)); 
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(directions + j), _mm_packus_epi16(codes, codes)); 
+    }
+    __m128i folded = _mm_max_epi32(_mm256_castsi256_si128(maxima), _mm256_extracti128_si256(maxima, 1)); 
+    folded = _mm_max_epi32(folded, _mm_shuffle_epi32(folded, _MM_SHUFFLE(1, 0, 3, 2))); 
+    folded = _mm_max_epi32(folded, _mm_shuffle_epi32(folded, _MM_SHUFFLE(2, 3, 0, 1))); 
+    maxModule = _mm_cvtsi128_si32(folded); 
+#elif IPA_KERNEL_LEVEL == 1
+    __m128i maxima = _mm_setzero_si128(); 
+    for(; j+8 <= count; j += 8) {
+        __m128i x16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gx + j)); 
+        __m128i y16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gy + j)); 
+        __m128i sums = _mm_add_epi16(x16, y16); 
+        __m128i low = Directions4(_mm_cvtepi16_epi32(x16), _mm_cvtepi16_epi32(y16)); 
+        __m128i high = Directions4(_mm_cvtepi16_epi32(_mm_srli_si128(x16, 8)), _mm_cvtepi16_epi32(_mm_srli_si128(y16, 8))); 
+        __m128i codes = _mm_packs_epi32(low, high); 
+
+        maxima = _mm_max_epi16(maxima, sums); 
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(modules + j), _mm_packus_epi16(sums, sums)); 
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(directions + j), _mm_packus_epi16(codes, codes)); 
+    }
+    maxima = _mm_max_epi16(maxima, _mm_srli_si128(maxima, 8)); 
+    maxima = _mm_max_epi16(maxima, _mm_srli_si128(maxima, 4)); 
+    maxima = _mm_max_epi16(maxima, _mm_srli_si128(maxima, 2)); 
+    maxModule = _mm_extract_epi16(maxima, 0); 
+#endif
+
+    for(; j < count; j++) {
+        int module = gx[j] + gy[j]; 
+        maxModule = max(maxModule, module); 
+        modules[j] = static_cast<uchar>(min(module, 255)); 
+        directions[j] = QuantizedDirection(gx[j], gy[j]); 
+    }
+
+    return maxModule; 
+}
+
+void AccumulateRow(int* columnSums, const uchar* row, int cols, int sign) {
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    for(; j+16 <= cols; j += 16) {
+        __m512i values = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j))); 
+        __m512i sums = _mm512_loadu_si512(columnSums + j); 
+        sums = sign > 0 ? _mm512_add_epi32(sums, values) : _mm512_sub_epi32(sums, values); 
+        _mm512_storeu_si512(columnSums + j, sums); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    for(; j+8 <= cols; j += 8) {
+        __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j))); 
+        __m256i sums = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columnSums + j)); 
+        sums = sign > 0 ? _mm256_add_epi32(sums, values) : _mm256_sub_epi32(sums, values); 
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(columnSums + j), sums); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    for(; j+8 <= cols; j += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j)); 
+        __m128i low = _mm_cvtepu8_epi32(bytes); 
+        __m128i high = _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)); 
+        __m128i sumsLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnSums + j)); 
+        __m128i sumsHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnSums + j+4)); 
+        sumsLow = sign > 0 ? _mm_add_epi32(sumsLow, low) : _mm_sub_epi32(sumsLow, low); 
+        sumsHigh = sign > 0 ? _mm_add_epi32(sumsHigh, high) : _mm_sub_epi32(sumsHigh, high); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(columnSums + j), sumsLow); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(columnSums + j+4), sumsHigh); 
+    }
+#endif
+
+    for(; j < cols; j++) {
+        columnSums[j] += sign * row[j]; 
+    }
+}
+
+// While the window sum fits in the 24 bits of the mantissa (area below 
+// 65536) the float division gives the same quotient as the integer one. 
+void DivideRow(const uint32_t* prefix, int cols, int window, int area, uchar* out) {
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    if(area < 65536) {
+        const __m512i half = _mm512_set1_epi32(area/2); 
+        const __m512 divisor = _mm512_set1_ps(static_cast<float>(area)); 
+        for(; j+16 <= cols; j += 16) {
+            __m512i first = _mm512_loadu_si512(prefix + j); 
+            __m512i last = _mm512_loadu_si512(prefix + j+window); 
+            __m512i sums = _mm512_add_epi32(_mm512_sub_epi32(last, first), half); 
+            __m512i means = _mm512_cvttps_epi32(_mm512_div_ps(_mm512_cvtepi32_ps(sums), divisor)); 
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm512_cvtepi32_epi8(means)); 
+        }
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    if(area < 65536) {
+        const __m256i half = _mm256_set1_epi32(area/2); 
+        const __m256 divisor = _mm256_set1_ps(static_cast<float>(area)); 
+        for(; j+8 <= cols; j += 8) {
+            __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prefix + j)); 
+            __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prefix + j+window)); 
+            __m256i sums = _mm256_add_epi32(_mm256_sub_epi32(last, first), half); 
+            __m256i means = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(sums), divisor)); 
+            __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(means), _mm256_extracti128_si256(means, 1)); 
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(words, words)); 
+        }
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    if(area < 65536) {
+        const __m128i half = _mm_set1_epi32(area/2); 
+        const __m128 divisor = _mm_set1_ps(static_cast<float>(area)); 
+        for(; j+8 <= cols; j += 8) {
+            __m128i means[2]; 
+            for(int h = 0; h < 2; h++) {
+                __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prefix + j+4*h)); 
+                __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prefix + j+4*h+window)); 
+                __m128i sums = _mm_add_epi32(_mm_sub_epi32(last, first), half); 
+                means[h] = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(sums), divisor)); 
+            }
+            __m128i words = _mm_packs_epi32(means[0], means[1]); 
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(words, words)); 
+        }
+    }
+#endif
+
+    for(; j < cols; j++) {
+        uint32_t sum = prefix[j+window] - prefix[j]; 
+        out[j] = static_cast<uchar>((sum + area/2) / area); 
+    }
+}
+
+#if IPA_KERNEL_LEVEL > 0
+// Spreads the BGR pixels of every 128 bit lane (the first 12 bytes) in 32 
+// bit lanes: blueGreen holds the blue and the green value as two 16 bit 
+// words, red the red value and a zero word, so that the multiply-add of 
+// the 16 bit differences gives the squared distances. 
+const char blueGreenShuffle[16] = {0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1}; 
+const char redShuffle[16] = {2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1}; 
+#endif
+
+// The squared distance needs 18 bits, so it is computed in 32 bit lanes; 
+// a lane takes a centroid only when it is strictly closer than the best so 
+// far, so ties go to the first centroid, as in the scalar loop. With 
+// keepDistances the lanes also keep the second smallest distance, and both 
+// are stored. 
+template<bool keepDistances>
+void NearestCentroids(const uchar* bgr, int cols, const int16_t* centroids, int k, uchar* labels, int32_t* nearestDistances, int32_t* secondDistances) {
+    const int16_t* blue = centroids; 
+    const int16_t* green = centroids + k; 
+    const int16_t* red = centroids + 2*k; 
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    const __m512i blueGreenMask = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blueGreenShuffle))); 
+    const __m512i redMask = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(redShuffle))); 
+    for(; 3*j+52 <= 3*cols; j += 16) {
+        const uchar* pixels = bgr + 3*j; 
+        __m512i bytes = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels))); 
+        bytes = _mm512_inserti32x4(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 12)), 1); 
+        bytes = _mm512_inserti32x4(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 24)), 2); 
+        bytes = _mm512_inserti32x4(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 36)), 3); 
+        __m512i blueGreen = _mm512_shuffle_epi8(bytes, blueGreenMask); 
+        __m512i reds = _mm512_shuffle_epi8(bytes, redMask); 
+
+        __m512i best = _mm512_set1_epi32(INT32_MAX); 
+        __m512i second = best; 
+        __m512i nearest = _mm512_setzero_si512(); 
+        for(int x = 0; x < k; x++) {
+            __m512i dBlueGreen = _mm512_sub_epi16(blueGreen, _mm512_set1_epi32(static_cast<uint16_t>(blue[x]) | green[x] << 16)); 
+            __m512i dRed = _mm512_sub_epi16(reds, _mm512_set1_epi32(red[x])); 
+            __m512i distance = _mm512_add_epi32(_mm512_madd_epi16(dBlueGreen, dBlueGreen), _mm512_madd_epi16(dRed, dRed)); 
+            __mmask16 closer = _mm512_cmplt_epi32_mask(distance, best); 
+            if(keepDistances) {
+                second = _mm512_min_epi32(second, _mm512_max_epi32(best, distance)); 
+            }
+            best = _mm512_min_epi32(best, distance); 
+            nearest = _mm512_mask_mov_epi32(nearest, closer, _mm512_set1_epi32(x)); 
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(labels + j), _mm512_cvtepi32_epi8(nearest)); 
+        if(keepDistances) {
+            _mm512_storeu_si512(nearestDistances + j, best); 
+            _mm512_storeu_si512(secondDistances + j, second); 
+        }
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    const __m256i blueGreenMask = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blueGreenShuffle))); 
+    const __m256i redMask = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(redShuffle))); 
+    for(; 3*j+28 <= 3*cols; j += 8) {
+        const uchar* pixels = bgr + 3*j; 
+        __m256i bytes = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels))); 
+        bytes = _mm256_inserti128_si256(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 12)), 1); 
+        __m256i blueGreen = _mm256_shuffle_epi8(bytes, blueGreenMask); 
+        __m256i reds = _mm256_shuffle_epi8(bytes, redMask); 
+
+        __m256i best = _mm256_set1_epi32(INT32_MAX); 
+        __m256i second = best; 
+        __m256i nearest = _mm256_setzero_si256(); 
+        for(int x = 0; x < k; x++) {
+            __m256i dBlueGreen = _mm256_sub_epi16(blueGreen, _mm256_set1_epi32(static_cast<uint16_t>(blue[x]) | green[x] << 16)); 
+            __m256i dRed = _mm256_sub_epi16(reds, _mm256_set1_epi32(red[x])); 
+            __m256i distance = _mm256_add_epi32(_mm256_madd_epi16(dBlueGreen, dBlueGreen), _mm256_madd_epi16(dRed, dRed)); 
+            __m256i closer = _mm256_cmpgt_epi32(best, distance); 
+            if(keepDistances) {
+                second = _mm256_min_epi32(second, _mm256_max_epi32(best, distance)); 
+            }
+            best = _mm256_min_epi32(best, distance); 
+            nearest = _mm256_blendv_epi8(nearest, _mm256_set1_epi32(x), closer); 
+        }
+        __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(nearest), _mm256_extracti128_si256(nearest, 1)); 
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(labels + j), _mm_packus_epi16(words, words)); 
+        if(keepDistances) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(nearestDistances + j), best); 
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(secondDistances + j), second); 
+        }
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    const __m128i blueGreenMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blueGreenShuffle)); 
+    const __m128i redMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(redShuffle)); 
+    for(; 3*j+16 <= 3*cols; j += 4) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bgr + 3*j)); 
+        __m128i blueGreen = _mm_shuffle_epi8(bytes, blueGreenMask); 
+        __m128i reds = _mm_shuffle_epi8(bytes, redMask); 
+
+        __m128i best = _mm_set1_epi32(INT32_MAX); 
+        __m128i second = best; 
+        __m128i nearest = _mm_setzero_si128(); 
+        for(int x = 0; x < k; x++) {
+            __m128i dBlueGreen = _mm_sub_epi16(blueGreen, _mm_set1_epi32(static_cast<uint16_t>(blue[x]) | green[x] << 16)); 
+            __m128i dRed = _mm_sub_epi16(reds, _mm_set1_epi32(red[x])); 
+            __m128i distance = _mm_add_epi32(_mm_madd_epi16(dBlueGreen, dBlueGreen), _mm_madd_epi16(dRed, dRed)); 
+            __m128i closer = _mm_cmpgt_epi32(best, distance); 
+            if(keepDistances) {
+                second = _mm_min_epi32(second, _mm_max_epi32(best, distance)); 
+            }
+            best = _mm_min_epi32(best, distance); 
+            nearest = _mm_blendv_epi8(nearest, _mm_set1_epi32(x), closer); 
+        }
+        __m128i words = _mm_packs_epi32(nearest, nearest); 
+        int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words)); 
+        memcpy(labels + j, &packed, 4); 
+        if(keepDistances) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(nearestDistances + j), best); 
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(secondDistances + j), second); 
+        }
+    }
+#endif
+
+    for(; j < cols; j++) {
+        const uchar* pixel = bgr + 3*j; 
+        int best = INT32_MAX; 
+        int second = INT32_MAX; 
+        int nearest = 0; 
+        for(int x = 0; x < k; x++) {
+            int dBlue = pixel[0] - blue[x]; 
+            int dGreen = pixel[1] - green[x]; 
+            int dRed = pixel[2] - red[x]; 
+            int distance = dBlue*dBlue + dGreen*dGreen + dRed*dRed; 
+            nearest = distance < best ? x : nearest; 
+            second = min(second, max(best, distance)); 
+            best = min(best, distance); 
+        }
+        labels[j] = static_cast<uchar>(nearest); 
+        if(keepDistances) {
+            nearestDistances[j] = best; 
+            secondDistances[j] = second; 
+        }
+    }
+}
+
+void NearestCentroidRow(const uchar* bgr, int cols, const int16_t* centroids, int k, uchar* labels) {
+    NearestCentroids<false>(bgr, cols, centroids, k, labels, nullptr, nullptr); 
+}
+
+void NearestTwoCentroidsRow(const uchar* bgr, int cols, const int16_t* centroids, int k, uchar* labels, int32_t* nearestDistances, int32_t* secondDistances) {
+    NearestCentroids<true>(bgr, cols, centroids, k, labels, nearestDistances, secondDistances); 
+}
+
+// The sorting networks of Paeth and Devillard for the 3x3 and 5x5 medians 
+// (19 and 99 exchanges). Every exchange is a min and a max, so the same 
+// network sorts one pixel or a block of consecutive pixels of the row; the 
+// compiler drops the halves of the exchanges whose result is not used. 
+inline void SortPair(uchar& a, uchar& b) {
+    uchar low = min(a, b); 
+    b = max(a, b); 
+    a = low; 
+}
+
+inline uchar LoadPixels(const uchar* p, uchar) {
+    return *p; 
+}
+
+inline void StorePixels(uchar* p, uchar v) {
+    *p = v; 
+}
+
+#if IPA_KERNEL_LEVEL == 3
+typedef __m512i PixelBlock; 
+const int blockPixels = 64; 
+
+inline void SortPair(__m512i& a, __m512i& b) {
+    __m512i low = _mm512_min_epu8(a, b); 
+    b = _mm512_max_epu8(a, b); 
+    a = low; 
+}
+
+inline __m512i LoadPixels(const uchar* p, __m512i) {
+    return _mm512_loadu_si512(p); 
+}
+
+inline void StorePixels(uchar* p, __m512i v) {
+    _mm512_storeu_si512(p, v); 
+}
+#elif IPA_KERNEL_LEVEL == 2
+typedef __m256i PixelBlock; 
+const int blockPixels = 32; 
+
+inline void SortPair(__m256i& a, __m256i& b) {
+    __m256i low = _mm256_min_epu8(a, b); 
+    b = _mm256_max_epu8(a, b); 
+    a = low; 
+}
+
+inline __m256i LoadPixels(const uchar* p, __m256i) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); 
+}
+
+inline void StorePixels(uchar* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); 
+}
+#elif IPA_KERNEL_LEVEL == 1
+typedef __m128i PixelBlock; 
+const int blockPixels = 16; 
+
+inline void SortPair(__m128i& a, __m128i& b) {
+    __m128i low = _mm_min_epu8(a, b); 
+    b = _mm_max_epu8(a, b); 
+    a = low; 
+}
+
+inline __m128i LoadPixels(const uchar* p, __m128i) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); 
+}
+
+inline void StorePixels(uchar* p, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); 
+}
+#endif
+
+template<typename T>
+inline T Median9(T* p) {
+    SortPair(p[1], p[2]); SortPair(p[4], p[5]); SortPair(p[7], p[8]); 
+    SortPair(p[0], p[1]); SortPair(p[3], p[4]); SortPair(p[6], p[7]); 
+    SortPair(p[1], p[2]); SortPair(p[4], p[5]); SortPair(p[7], p[8]); 
+    SortPair(p[0], p[3]); SortPair(p[5], p[8]); SortPair(p[4], p[7]); 
+    SortPair(p[3], p[6]); SortPair(p[1], p[4]); SortPair(p[2], p[5]); 
+    SortPair(p[4], p[7]); SortPair(p[4], p[2]); SortPair(p[6], p[4]); 
+    SortPair(p[4], p[2]); 
+    return p[4]; 
+}
+
+template<typename T>
+inline T Median25(T* p) {
+    SortPair(p[0], p[1]);   SortPair(p[3], p[4]);   SortPair(p[2], p[4]); 
+    SortPair(p[2], p[3]);   SortPair(p[6], p[7]);   SortPair(p[5], p[7]); 
+    SortPair(p[5], p[6]);   SortPair(p[9], p[10]);  SortPair(p[8], p[10]); 
+    SortPair(p[8], p[9]);   SortPair(p[12], p[13]); SortPair(p[11], p[13]); 
+    SortPair(p[11], p[12]); SortPair(p[15], p[16]); SortPair(p[14], p[16]); 
+    SortPair(p[14], p[15]); SortPair(p[18], p[19]); SortPair(p[17], p[19]); 
+    SortPair(p[17], p[18]); SortPair(p[21], p[22]); SortPair(p[20], p[22]); 
+    SortPair(p[20], p[21]); SortPair(p[23], p[24]); SortPair(p[2], p[5]); 
+    SortPair(p[3], p[6]);   SortPair(p[0], p[6]);   SortPair(p[0], p[3]); 
+    SortPair(p[4], p[7]);   SortPair(p[1], p[7]);   SortPair(p[1], p[4]); 
+    SortPair(p[11], p[14]); SortPair(p[8], p[14]);  SortPair(p[8], p[11]); 
+    SortPair(p[12], p[15]); SortPair(p[9], p[15]);  SortPair(p[9], p[12]); 
+    SortPair(p[13], p[16]); SortPair(p[10], p[16]); SortPair(p[10], p[13]); 
+    SortPair(p[20], p[23]); SortPair(p[17], p[23]); SortPair(p[17], p[20]); 
+    SortPair(p[21], p[24]); SortPair(p[18], p[24]); SortPair(p[18], p[21]); 
+    SortPair(p[19], p[22]); SortPair(p[8], p[17]);  SortPair(p[9], p[18]); 
+    SortPair(p[0], p[18]);  SortPair(p[0], p[9]);   SortPair(p[10], p[19]); 
+    SortPair(p[1], p[19]);  SortPair(p[1], p[10]);  SortPair(p[11], p[20]); 
+    SortPair(p[2], p[20]);  SortPair(p[2], p[11]);  SortPair(p[12], p[21]); 
+    SortPair(p[3], p[21]);  SortPair(p[3], p[12]);  SortPair(p[13], p[22]); 
+    SortPair(p[4], p[22]);  SortPair(p[4], p[13]);  SortPair(p[14], p[23]); 
+    SortPair(p[5], p[23]);  SortPair(p[5], p[14]);  SortPair(p[15], p[24]); 
+    SortPair(p[6], p[24]);  SortPair(p[6], p[15]);  SortPair(p[7], p[16]); 
+    SortPair(p[7], p[19]);  SortPair(p[13], p[21]); SortPair(p[15], p[23]); 
+    SortPair(p[7], p[13]);  SortPair(p[7], p[15]);  SortPair(p[1], p[9]); 
+    SortPair(p[3], p[11]);  SortPair(p[5], p[17]);  SortPair(p[11], p[17]); 
+    SortPair(p[9], p[17]);  SortPair(p[4], p[10]);  SortPair(p[6], p[12]); 
+    SortPair(p[7], p[14]);  SortPair(p[4], p[6]);   SortPair(p[4], p[7]); 
+    SortPair(p[12], p[14]); SortPair(p[10], p[14]); SortPair(p[6], p[7]); 
+    SortPair(p[10], p[12]); SortPair(p[6], p[10]);  SortPair(p[6], p[17]); 
+    SortPair(p[12], p[17]); SortPair(p[7], p[17]);  SortPair(p[7], p[10]); 
+    SortPair(p[12], p[18]); SortPair(p[7], p[12]);  SortPair(p[10], p[18]); 
+    SortPair(p[12], p[20]); SortPair(p[10], p[20]); SortPair(p[10], p[12]); 
+    return p[12]; 
+}
+
+// The median of the window of the pixels [j, j+window) of the padded rows, 
+// for one pixel (T = uchar) or for a block of consecutive pixels. 
+template<int radius, typename T>
+inline void MedianNetworkAt(const uchar* const* padded, int j, uchar* out) {
+    const int window = 2*radius+1; 
+    T p[window*window]; 
+    for(int dy = 0; dy < window; dy++) {
+        for(int dx = 0; dx < window; dx++) {
+            p[dy*window + dx] = LoadPixels(padded[dy] + j + dx, T()); 
+        }
+    }
+    StorePixels(out + j, radius == 1 ? Median9(p) : Median25(p)); 
+}
+
+template<int radius>
+void MedianNetworks(const uchar* const* padded, int cols, uchar* out) {
+    int j = 0; 
+#if IPA_KERNEL_LEVEL > 0
+    for(; j+blockPixels <= cols; j += blockPixels) {
+        MedianNetworkAt<radius, PixelBlock>(padded, j, out); 
+    }
+#endif
+    for(; j < cols; j++) {
+        MedianNetworkAt<radius, uchar>(padded, j, out); 
+    }
+}
+
+void MedianNetworkRow(const uchar* const* padded, int radius, int cols, uchar* out) {
+    if(radius == 1) {
+        MedianNetworks<1>(padded, cols, out); 
+    } else {
+        MedianNetworks<2>(padded, cols, out); 
+    }
+}
+
+// The two passes of the separable Gaussian filter (GaussianFilter.hpp). The 
+// vertical pass stores the weighted sums of the columns, which fit in 16 
+// bits because the weights sum to 256; the symmetric rows are added before 
+// the multiplication. Size is 0 for the generic version. 
+template<int Size>
+void GaussianVerticalPass(const uint16_t* weights, int kernelSize, const uchar* const* rows, int cols, uint16_t* out) {
+    const int size = Size > 0 ? Size : kernelSize; 
+    const int radius = size/2; 
+    int j = 0; 
+
+#if IPA_KERNEL_LEVEL == 3
+    for(; j+32 <= cols; j += 32) {
+        auto load = [&](int k) { return _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + j))); }; 
+        __m512i acc = _mm512_mullo_epi16(load(radius), _mm512_set1_epi16(weights[radius])); 
+        for(int k = 0; k < radius; k++) {
+            acc = _mm512_add_epi16(acc, _mm512_mullo_epi16(_mm512_add_epi16(load(k), load(size-1-k)), _mm512_set1_epi16(weights[k]))); 
+        }
+        _mm512_storeu_si512(out + j, acc); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    for(; j+16 <= cols; j += 16) {
+        auto load = [&](int k) { return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + j))); }; 
+        __m256i acc = _mm256_mullo_epi16(load(radius), _mm256_set1_epi16(weights[radius])); 
+        for(int k = 0; k < radius; k++) {
+            acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(_mm256_add_epi16(load(k), load(size-1-k)), _mm256_set1_epi16(weights[k]))); 
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), acc); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    for(; j+8 <= cols; j += 8) {
+        auto load = [&](int k) { return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[k] + j))); }; 
+        __m128i acc = _mm_mullo_epi16(load(radius), _mm_set1_epi16(weights[radius])); 
+        for(int k = 0; k < radius; k++) {
+            acc = _mm_add_epi16(acc, _mm_mullo_epi16(_mm_add_epi16(load(k), load(size-1-k)), _mm_set1_epi16(weights[k]))); 
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), acc); 
+    }
+#endif
+
+    for(; j < cols; j++) {
+        unsigned acc = rows[radius][j] * weights[radius]; 
+        for(int k = 0; k < radius; k++) {
+            acc += (rows[k][j] + rows[size-1-k][j]) * weights[k]; 
+        }
+        out[j] = static_cast<uint16_t>(acc); 
+    }
+}
+
+// The horizontal pass: the weighted sums of the 16 bit values need 32 bits 
+// (the products are split in their low and high halves and interleaved), 
+// and are rounded back to 8 bits, since the two passes scale by 2^16. The 
+// packs undo the order of the unpacks within every 128 bit lane. 
+template<int Size>
+void GaussianHorizontalPass(const uint16_t* weights, int kernelSize, const uint16_t* in, int cols, uchar* dst) {
+    const int size = Size > 0 ? Size : kernelSize; 
+    const int radius = size/2; 
+    const int shift = 16; 
+    int j = radius; 
+
+#if IPA_KERNEL_LEVEL == 3
+    const __m512i half = _mm512_set1_epi32(1 << (shift-1)); 
+    for(; j+32+radius <= cols; j += 32) {
+        __m512i low = half; 
+        __m512i high = half; 
+        for(int k = 0; k < size; k++) {
+            __m512i values = _mm512_loadu_si512(in + j-radius+k); 
+            __m512i weight = _mm512_set1_epi16(weights[k]); 
+            __m512i productLow = _mm512_mullo_epi16(values, weight); 
+            __m512i productHigh = _mm512_mulhi_epu16(values, weight); 
+            low = _mm512_add_epi32(low, _mm512_unpacklo_epi16(productLow, productHigh)); 
+            high = _mm512_add_epi32(high, _mm512_unpackhi_epi16(productLow, productHigh)); 
+        }
+        __m512i packed = _mm512_packs_epi32(_mm512_srli_epi32(low, shift), _mm512_srli_epi32(high, shift)); 
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), _mm512_cvtepi16_epi8(packed)); 
+    }
+#elif IPA_KERNEL_LEVEL == 2
+    const __m256i half = _mm256_set1_epi32(1 << (shift-1)); 
+    for(; j+16+radius <= cols; j += 16) {
+        __m256i low = half; 
+        __m256i high = half; 
+        for(int k = 0; k < size; k++) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + j-radius+k)); 
+            __m256i weight = _mm256_set1_epi16(weights[k]); 
+            __m256i productLow = _mm256_mullo_epi16(values, weight); 
+            __m256i productHigh = _mm256_mulhi_epu16(values, weight); 
+            low = _mm256_add_epi32(low, _mm256_unpacklo_epi16(productLow, productHigh)); 
+            high = _mm256_add_epi32(high, _mm256_unpackhi_epi16(productLow, productHigh)); 
+        }
+        __m256i packed = _mm256_packs_epi32(_mm256_srli_epi32(low, shift), _mm256_srli_epi32(high, shift)); 
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1)); 
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), bytes); 
+    }
+#elif IPA_KERNEL_LEVEL == 1
+    const __m128i half = _mm_set1_epi32(1 << (shift-1)); 
+    for(; j+8+radius <= cols; j += 8) {
+        __m128i low = half; 
+        __m128i high = half; 
+        for(int k = 0; k < size; k++) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + j-radius+k)); 
+            __m128i weight = _mm_set1_epi16(weights[k]); 
+            __m128i productLow = _mm_mullo_epi16(values, weight); 
+            __m128i productHigh = _mm_mulhi_epu16(values, weight); 
+            low = _mm_add_epi32(low, _mm_unpacklo_epi16(productLow, productHigh)); 
+            high = _mm_add_epi32(high, _mm_unpackhi_epi16(productLow, productHigh)); 
+        }
+        __m128i packed = _mm_packs_epi32(_mm_srli_epi32(low, shift), _mm_srli_epi32(high, shift)); 
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + j), _mm_packus_epi16(packed, packed)); 
+    }
+#endif
+
+    for(; j+radius < cols; j++) {
+        uint32_t acc = 1u << (shift-1); 
+        for(int k = 0; k < size; k++) {
+            acc += uint32_t(in[j-radius+k]) * weights[k]; 
+        }
+        dst[j] = static_cast<uchar>(acc >> shift); 
+    }
+}
+
+template<int Size>
+void GaussianPasses(const uint16_t* weights, int size, const uchar* const* rows, int cols, uint16_t* scratch, uchar* dst) {
+    GaussianVerticalPass<Size>(weights, size, rows, cols, scratch); 
+    GaussianHorizontalPass<Size>(weights, size, scratch, cols, dst); 
+}
+
+// The sizes 3, 5, 7 and 9 have unrolled specializations. 
+void GaussianRow(const uint16_t* weights, int size, const uchar* const* rows, int cols, uint16_t* scratch, uchar* dst) {
+    switch(size) {
+        case 3: GaussianPasses<3>(weights, size, rows, cols, scratch, dst); break; 
+        case 5: GaussianPasses<5>(weights, size, rows, cols, scratch, dst); break; 
+        case 7: GaussianPasses<7>(weights, size, rows, cols, scratch, dst); break; 
+        case 9: GaussianPasses<9>(weights, size, rows, cols, scratch, dst); break; 
+        default: GaussianPasses<0>(weights, size, rows, cols, scratch, dst); break; 
+    }
+}
+}
+
+extern const PixelKernels IPA_KERNEL_TABLE; 
+const PixelKernels IPA_KERNEL_TABLE = {
+    ThresholdRow,
+    LookupRow,
+    SobelRow,
+    GradientRow,
+    AccumulateRow,
+    DivideRow,
+    NearestCentroidRow,
+    NearestTwoCentroidsRow,
+    SignedSobelRow,
+    TensorRow,
+    MedianNetworkRow,
+    GaussianRow,
+}; 
@@ -0,0 +1,4 @@
+// The pixel kernels with AVX2. 
+#define IPA_KERNEL_LEVEL 2
+#define IPA_KERNEL_TABLE pixelKernelsAVX2
+#include "PixelKernels.inl"
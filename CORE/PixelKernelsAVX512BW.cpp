@@ -0,0 +1,4 @@
+// The pixel kernels with AVX-512F and AVX-512BW. 
+#define IPA_KERNEL_LEVEL 3
+#define IPA_KERNEL_TABLE pixelKernelsAVX512BW
+#include "PixelKernels.inl"
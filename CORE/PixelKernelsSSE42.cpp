@@ -0,0 +1,4 @@
+// The pixel kernels with SSE4.2, which includes SSSE3 and SSE4.1. 
+#define IPA_KERNEL_LEVEL 1
+#define IPA_KERNEL_TABLE pixelKernelsSSE42
+#include "PixelKernels.inl"
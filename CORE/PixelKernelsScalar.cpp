@@ -0,0 +1,4 @@
+// The pixel kernels in plain C++, the fallback of every CPU. 
+#define IPA_KERNEL_LEVEL 0
+#define IPA_KERNEL_TABLE pixelKernelsScalar
+#include "PixelKernels.inl"
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "CpuDispatch.hpp"
+#include "Sobel.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+static void CheckSource(const Mat& src, const char* function) {
+    if(src.type() != CV_8UC1) {
+        throw invalid_argument(string(function) + " needs a CV_8UC1 image: type " + to_string(src.type())); 
+    }
+}
+
+void SobelDerivatives(const Mat& src, Mat& Ix, Mat& Iy) {
+    IPA_TRACE_SCOPE("SobelDerivatives", src.total()); 
+    CheckSource(src, "SobelDerivatives"); 
+
+    Ix = Mat::zeros(src.rows, src.cols, CV_16SC1); 
+    Iy = Mat::zeros(src.rows, src.cols, CV_16SC1); 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    int count = src.cols-2; 
+    for(int i = 0; i+2 < src.rows && count > 0; i++) {
+        kernels.signedSobelRow(src.ptr<uchar>(i), src.ptr<uchar>(i+1), src.ptr<uchar>(i+2), count, Ix.ptr<int16_t>(i), Iy.ptr<int16_t>(i)); 
+    }
+}
+
+void SobelTensor(const Mat& src, Mat& xx, Mat& yy, Mat& xy) {
+    IPA_TRACE_SCOPE("SobelTensor", src.total()); 
+    CheckSource(src, "SobelTensor"); 
+
+    // The derivatives of a row stay in two buffers of the size of the row, 
+    // which are still in the cache when tensorRow reads them back. 
+    xx = Mat::zeros(src.rows, src.cols, CV_32FC1); 
+    yy = Mat::zeros(src.rows, src.cols, CV_32FC1); 
+    xy = Mat::zeros(src.rows, src.cols, CV_32FC1); 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    int count = src.cols-2; 
+    vector<int16_t> gx(max(count, 0)); 
+    vector<int16_t> gy(max(count, 0)); 
+    for(int i = 0; i+2 < src.rows && count > 0; i++) {
+        kernels.signedSobelRow(src.ptr<uchar>(i), src.ptr<uchar>(i+1), src.ptr<uchar>(i+2), count, gx.data(), gy.data()); 
+        kernels.tensorRow(gx.data(), gy.data(), count, xx.ptr<float>(i), yy.ptr<float>(i), xy.ptr<float>(i)); 
+    }
+}
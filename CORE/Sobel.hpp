@@ -0,0 +1,26 @@
+#ifndef SOBEL_HPP
+#define SOBEL_HPP
+
+#include <opencv2/opencv.hpp>
+
+// Signed Sobel derivatives shared by the detectors that need the sign of the 
+// gradient (the structure tensor of Harris). Every 3x3 neighbourhood is read 
+// once, by the signedSobelRow kernel of CpuDispatch.hpp, and the products of 
+// the derivatives come from the derivatives of the same row (tensorRow), 
+// so there is no second convolution and no 8 bit round trip. 
+// 
+// The value at (i, j) is computed from the rows i..i+2 and the columns 
+// j..j+2, as in the SobelFilter of Harris; the last two rows and columns, 
+// where the mask does not fit in the image, are set to 0. 
+
+// The derivatives of a CV_8UC1 image as two CV_16SC1 images (-1020 to 1020): 
+// Ix is the right column minus the left one, Iy the top row minus the 
+// bottom one. 
+void SobelDerivatives(const cv::Mat& src, cv::Mat& Ix, cv::Mat& Iy); 
+
+// The products Ix^2, Iy^2 and IxIy of a CV_8UC1 image as three CV_32FC1 
+// images (exact, the products are integers below 2^24), without storing the 
+// derivatives. 
+void SobelTensor(const cv::Mat& src, cv::Mat& xx, cv::Mat& yy, cv::Mat& xy); 
+
+#endif
@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "StripStreaming.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+using namespace cv; 
+
+// The input rows of a stage that are still needed: rows [first, first+count) 
+// of the stage input, stored at the top of data. 
+struct StripBuffer {
+    Mat data; 
+    int first = 0; 
+    int count = 0; 
+    int total = 0; 
+
+    void Append(const Mat& rows) {
+        if(this->data.empty() || this->data.cols != rows.cols || this->data.type() != rows.type() || this->count + rows.rows > this->data.rows) {
+            Mat grown(max(this->count + rows.rows, this->data.rows), rows.cols, rows.type()); 
+            if(this->count > 0) {
+                this->data.rowRange(0, this->count).copyTo(grown.rowRange(0, this->count)); 
+            }
+            this->data = grown; 
+        }
+        rows.copyTo(this->data.rowRange(this->count, this->count + rows.rows)); 
+        this->count += rows.rows; 
+    }
+
+    // Forgets the rows before row, moving the others to the top. 
+    void DropBefore(int row) {
+        int dropped = min(max(0, row - this->first), this->count); 
+        if(dropped == 0) {
+            return; 
+        }
+        int kept = this->count - dropped; 
+        for(int i = 0; i < kept; i++) {
+            this->data.row(dropped + i).copyTo(this->data.row(i)); 
+        }
+        this->first += dropped; 
+        this->count = kept; 
+    }
+}; 
+
+class StripChain {
+    public: 
+    StripChain(const vector<StripStage>& stages, RowSink& sink, int inputRows, int bandRows) : stages(stages), sink(sink), bandRows(bandRows) {
+        this->buffers.resize(stages.size()); 
+        this->produced.assign(stages.size(), 0); 
+
+        int rows = inputRows; 
+        for(size_t i = 0; i < stages.size(); i++) {
+            if(stages[i].haloAbove < 0 || stages[i].haloBelow < 0 || stages[i].extraRows < 0) {
+                throw invalid_argument("the halo of stage " + stages[i].name + " is negative"); 
+            }
+            this->buffers[i].total = rows; 
+            rows += stages[i].extraRows; 
+        }
+        this->outputRows = rows; 
+    }
+
+    void Feed(size_t stage, const Mat& rows) {
+        if(stage == this->stages.size()) {
+            if(!this->begun) {
+                this->sink.Begin(this->outputRows, rows.cols, rows.type()); 
+                this->begun = true; 
+            }
+            this->sink.Write(rows); 
+            return; 
+        }
+
+        StripBuffer& buffer = this->buffers[stage]; 
+        buffer.Append(rows); 
+        this->Produce(stage); 
+    }
+
+    private: 
+    // Computes every output row of the stage whose input rows have all 
+    // arrived, band by band, and passes them to the next stage. 
+    void Produce(size_t stage) {
+        const StripStage& current = this->stages[stage]; 
+        StripBuffer& buffer = this->buffers[stage]; 
+        int stageOutputRows = buffer.total + current.extraRows; 
+        int available = buffer.first + buffer.count; 
+        bool complete = available == buffer.total; 
+        int last = complete ? stageOutputRows - 1 : available - 1 - current.haloBelow; 
+
+        int& next = this->produced[stage]; 
+        while(next <= last) {
+            int end = min(last + 1, next + this->bandRows); 
+            int bandFirst = max(0, next - current.haloAbove); 
+            int bandEnd = min(buffer.total, end + current.haloBelow); 
+
+            Mat band = buffer.data.rowRange(bandFirst - buffer.first, bandEnd - buffer.first); 
+            Mat result = current.apply(band); 
+            if(result.rows != band.rows + current.extraRows) {
+                throw runtime_error("stage " + current.name + " returned the wrong number of rows"); 
+            }
+
+            Mat rows = result.rowRange(next - bandFirst, end - bandFirst); 
+            next = end; 
+            this->Feed(stage + 1, rows); 
+        }
+
+        buffer.DropBefore(next - current.haloAbove); 
+    }
+
+    const vector<StripStage>& stages; 
+    RowSink& sink; 
+    int bandRows; 
+    int outputRows = 0; 
+    bool begun = false; 
+    vector<StripBuffer> buffers; 
+    vector<int> produced; 
+}; 
+
+void StreamStrips(RowSource& source, const vector<StripStage>& stages, RowSink& sink, int bandRows) {
+    IPA_TRACE_SCOPE("StreamStrips", static_cast<int64_t>(source.Rows()) * source.Cols()); 
+
+    if(bandRows <= 0) {
+        throw invalid_argument("the band must have at least one row"); 
+    }
+
+    StripChain chain(stages, sink, source.Rows(), bandRows); 
+    Mat band(bandRows, source.Cols(), source.Type()); 
+
+    for(int row = 0; row < source.Rows(); row += bandRows) {
+        Mat rows = band.rowRange(0, min(bandRows, source.Rows() - row)); 
+        source.Read(rows); 
+        chain.Feed(0, rows); 
+    }
+
+    sink.End(); 
+}
+
+MatRowSource::MatRowSource(const Mat& image) : image(image) {}
+
+int MatRowSource::Rows() const {
+    return this->image.rows; 
+}
+
+int MatRowSource::Cols() const {
+    return this->image.cols; 
+}
+
+int MatRowSource::Type() const {
+    return this->image.type(); 
+}
+
+void MatRowSource::Read(Mat& rows) {
+    this->image.rowRange(this->next, this->next + rows.rows).copyTo(rows); 
+    this->next += rows.rows; 
+}
+
+void MatRowSource::Rewind() {
+    this->next = 0; 
+}
+
+void MatRowSink::Begin(int rows, int cols, int type) {
+    this->result.create(rows, cols, type); 
+    this->next = 0; 
+}
+
+void MatRowSink::Write(const Mat& rows) {
+    rows.copyTo(this->result.rowRange(this->next, this->next + rows.rows)); 
+    this->next += rows.rows; 
+}
+
+const Mat& MatRowSink::Result() const {
+    return this->result; 
+}
+
+bool IsPnmFile(const string& file) {
+    size_t dot = file.find_last_of('.'); 
+    if(dot == string::npos) {
+        return false; 
+    }
+    string extension = file.substr(dot); 
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower); 
+    return extension == ".pgm" || extension == ".ppm" || extension == ".pnm"; 
+}
+
+// Reads the next number of a PNM header, skipping blanks and comments. 
+static int ReadHeaderNumber(ifstream& stream) {
+    int c = stream.get(); 
+    while(c != EOF && (isspace(c) || c == '#')) {
+        if(c == '#') {
+            while(c != EOF && c != '\n') {
+                c = stream.get(); 
+            }
+        }
+        c = stream.get(); 
+    }
+
+    int value = 0; 
+    bool digits = false; 
+    while(c != EOF && isdigit(c)) {
+        value = value*10 + (c - '0'); 
+        digits = true; 
+        c = stream.get(); 
+    }
+
+    // The single blank after the number is part of the header. 
+    if(!digits || (c != EOF && !isspace(c))) {
+        throw runtime_error("invalid PNM header"); 
+    }
+    return value; 
+}
+
+PnmRowSource::PnmRowSource(const string& file, int readFlags) : file(file), stream(file, ios::binary) {
+    if(!this->stream) {
+        throw runtime_error("cannot open " + file); 
+    }
+
+    char magic[2] = {0, 0}; 
+    this->stream.read(magic, 2); 
+    if(magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) {
+        throw runtime_error(file + " is not a binary PGM or PPM file"); 
+    }
+
+    this->channels = magic[1] == '5' ? 1 : 3; 
+    this->cols = ReadHeaderNumber(this->stream); 
+    this->rows = ReadHeaderNumber(this->stream); 
+    if(ReadHeaderNumber(this->stream) != 255) {
+        throw runtime_error(file + " does not have 8 bit samples"); 
+    }
+    this->dataStart = this->stream.tellg(); 
+
+    this->outputChannels = this->channels; 
+    if(readFlags == IMREAD_GRAYSCALE) {
+        this->outputChannels = 1; 
+    } else if(readFlags == IMREAD_COLOR) {
+        this->outputChannels = 3; 
+    }
+}
+
+int PnmRowSource::Rows() const {
+    return this->rows; 
+}
+
+int PnmRowSource::Cols() const {
+    return this->cols; 
+}
+
+int PnmRowSource::Type() const {
+    return CV_8UC(this->outputChannels); 
+}
+
+void PnmRowSource::Read(Mat& rows) {
+    Mat& target = this->channels == this->outputChannels && this->channels == 1 ? rows : this->fileRows; 
+    target.create(rows.rows, this->cols, CV_8UC(this->channels)); 
+
+    for(int i = 0; i < target.rows; i++) {
+        this->stream.read(reinterpret_cast<char*>(target.ptr(i)), static_cast<streamsize>(this->cols) * this->channels); 
+    }
+    if(!this->stream) {
+        throw runtime_error("unexpected end of " + this->file); 
+    }
+
+    // The samples of a PPM are in RGB order, the rows are returned in the 
+    // BGR order of imread. 
+    if(this->channels == 3) {
+        cvtColor(target, rows, this->outputChannels == 3 ? COLOR_RGB2BGR : COLOR_RGB2GRAY); 
+    } else if(this->outputChannels == 3) {
+        cvtColor(target, rows, COLOR_GRAY2BGR); 
+    }
+}
+
+void PnmRowSource::Rewind() {
+    this->stream.clear(); 
+    this->stream.seekg(this->dataStart); 
+}
+
+RawRowSource::RawRowSource(const string& file, int rows, int cols, int type, size_t offset) 
+    : file(file), rows(rows), cols(cols), type(type), offset(offset) {
+    if(rows < 0 || cols < 0) {
+        throw invalid_argument("invalid size of " + file + ": " + to_string(cols) + "x" + to_string(rows)); 
+    }
+    size_t required = offset + static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type); 
+
+#ifndef _WIN32
+    int descriptor = open(file.c_str(), O_RDONLY); 
+    if(descriptor < 0) {
+        throw runtime_error("cannot open " + file); 
+    }
+    struct stat status; 
+    if(fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < required) {
+        close(descriptor); 
+        throw runtime_error(file + " is shorter than " + to_string(required) + " bytes"); 
+    }
+
+    // An empty mapping is not allowed, and an empty image needs no data. 
+    if(required > offset) {
+        void* address = mmap(nullptr, required, PROT_READ, MAP_PRIVATE, descriptor, 0); 
+        if(address == MAP_FAILED) {
+            close(descriptor); 
+            throw runtime_error("cannot map " + file); 
+        }
+        madvise(address, required, MADV_SEQUENTIAL); 
+        this->mapping = static_cast<const unsigned char*>(address); 
+        this->mappingSize = required; 
+    }
+    close(descriptor); 
+#else
+    this->stream.open(file, ios::binary | ios::ate); 
+    if(!this->stream) {
+        throw runtime_error("cannot open " + file); 
+    }
+    if(static_cast<size_t>(this->stream.tellg()) < required) {
+        throw runtime_error(file + " is shorter than " + to_string(required) + " bytes"); 
+    }
+    this->stream.seekg(offset); 
+#endif
+}
+
+RawRowSource::~RawRowSource() {
+#ifndef _WIN32
+    if(this->mapping) {
+        munmap(const_cast<unsigned char*>(this->mapping), this->mappingSize); 
+    }
+#endif
+}
+
+int RawRowSource::Rows() const {
+    return this->rows; 
+}
+
+int RawRowSource::Cols() const {
+    return this->cols; 
+}
+
+int RawRowSource::Type() const {
+    return this->type; 
+}
+
+void RawRowSource::Read(Mat& rows) {
+    if(this->next + rows.rows > this->rows) {
+        throw runtime_error("read past the end of " + this->file); 
+    }
+
+    size_t rowBytes = static_cast<size_t>(this->cols) * CV_ELEM_SIZE(this->type); 
+    for(int i = 0; i < rows.rows; i++) {
+        if(this->mapping) {
+            memcpy(rows.ptr(i), this->mapping + this->offset + (this->next + i) * rowBytes, rowBytes); 
+        } else if(rowBytes > 0) {
+            this->stream.read(reinterpret_cast<char*>(rows.ptr(i)), static_cast<streamsize>(rowBytes)); 
+        }
+    }
+    if(!this->mapping && rowBytes > 0 && !this->stream) {
+        throw runtime_error("unexpected end of " + this->file); 
+    }
+    this->next += rows.rows; 
+}
+
+void RawRowSource::Rewind() {
+    this->next = 0; 
+    if(!this->mapping && this->stream.is_open()) {
+        this->stream.clear(); 
+        this->stream.seekg(this->offset); 
+    }
+}
+
+PnmRowSink::PnmRowSink(const string& file) : file(file) {}
+
+void PnmRowSink::Begin(int rows, int cols, int type) {
+    if(type != CV_8UC1 && type != CV_8UC3) {
+        throw runtime_error("only 8 bit gray or BGR images can be written to " + this->file); 
+    }
+
+    this->stream.open(this->file, ios::binary); 
+    if(!this->stream) {
+        throw runtime_error("cannot write " + this->file); 
+    }
+    this->stream << (type == CV_8UC1 ? "P5" : "P6") << "\n" << cols << " " << rows << "\n255\n"; 
+}
+
+void PnmRowSink::Write(const Mat& rows) {
+    const Mat* samples = &rows; 
+    if(rows.channels() == 3) {
+        cvtColor(rows, this->fileRows, COLOR_BGR2RGB); 
+        samples = &this->fileRows; 
+    }
+
+    for(int i = 0; i < samples->rows; i++) {
+        this->stream.write(reinterpret_cast<const char*>(samples->ptr(i)), static_cast<streamsize>(samples->cols) * samples->channels()); 
+    }
+    if(!this->stream) {
+        throw runtime_error("cannot write " + this->file); 
+    }
+}
+
+void PnmRowSink::End() {
+    this->stream.close(); 
+    if(this->stream.fail()) {
+        throw runtime_error("cannot write " + this->file); 
+    }
+}
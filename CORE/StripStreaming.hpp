@@ -0,0 +1,175 @@
+#ifndef STRIP_STREAMING_HPP
+#define STRIP_STREAMING_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Streaming of images in horizontal bands (strips), for the images that do 
+// not fit in memory. The rows flow from a RowSource through a chain of 
+// StripStage to a RowSink; every stage only keeps the rows of the current 
+// band plus its halo, so the peak memory depends on the band height and on 
+// the image width, never on the image height. 
+
+// Rows of an image read from top to bottom. 
+class RowSource {
+    public: 
+    virtual ~RowSource() = default; 
+
+    virtual int Rows() const = 0; 
+    virtual int Cols() const = 0; 
+    virtual int Type() const = 0; 
+
+    // Reads the next rows.rows rows into rows, which has already been 
+    // allocated with Cols() columns and Type() type. 
+    virtual void Read(cv::Mat& rows) = 0; 
+
+    // Starts again from the first row, for the algorithms with more passes. 
+    virtual void Rewind() = 0; 
+}; 
+
+// Receives the rows of the result from top to bottom. Begin() is called 
+// once, before the first rows, with the size and the type of the result. 
+class RowSink {
+    public: 
+    virtual ~RowSink() = default; 
+
+    virtual void Begin(int rows, int cols, int type) = 0; 
+    virtual void Write(const cv::Mat& rows) = 0; 
+    virtual void End() {}
+}; 
+
+// One neighbourhood operation of a chain. Output row r is computed from the 
+// input rows [r - haloAbove, r + haloBelow] only, and the output has 
+// extraRows more rows than the input. apply receives a band of consecutive 
+// input rows and must return the operation applied to the band as if it 
+// were a whole image: the engine keeps only the rows whose halo lies inside 
+// the band (or is cut by the border of the image, as for the whole image). 
+struct StripStage {
+    std::string name; 
+    int haloAbove; 
+    int haloBelow; 
+    int extraRows; 
+    std::function<cv::Mat(const cv::Mat& band)> apply; 
+}; 
+
+// Streams the whole source through the stages into the sink, with bands of 
+// at most bandRows output rows. Throws std::runtime_error on read or write 
+// errors. 
+void StreamStrips(RowSource& source, const std::vector<StripStage>& stages, RowSink& sink, int bandRows); 
+
+// An image already in memory. 
+class MatRowSource : public RowSource {
+    public: 
+    explicit MatRowSource(const cv::Mat& image); 
+
+    int Rows() const override; 
+    int Cols() const override; 
+    int Type() const override; 
+    void Read(cv::Mat& rows) override; 
+    void Rewind() override; 
+
+    private: 
+    cv::Mat image; 
+    int next = 0; 
+}; 
+
+// Collects the result in memory, mostly to compare it with the whole-image 
+// functions. 
+class MatRowSink : public RowSink {
+    public: 
+    void Begin(int rows, int cols, int type) override; 
+    void Write(const cv::Mat& rows) override; 
+
+    const cv::Mat& Result() const; 
+
+    private: 
+    cv::Mat result; 
+    int next = 0; 
+}; 
+
+// Drops the rows, for the passes that only gather statistics. 
+class DiscardRowSink : public RowSink {
+    public: 
+    void Begin(int, int, int) override {}
+    void Write(const cv::Mat&) override {}
+}; 
+
+// Binary PGM (P5) and PPM (P6) files with 8 bit samples, read row by row. 
+// readFlags follows imread: IMREAD_GRAYSCALE converts a PPM to gray, 
+// IMREAD_COLOR converts a PGM to BGR, anything else keeps the channels. 
+class PnmRowSource : public RowSource {
+    public: 
+    explicit PnmRowSource(const std::string& file, int readFlags = cv::IMREAD_UNCHANGED); 
+
+    int Rows() const override; 
+    int Cols() const override; 
+    int Type() const override; 
+    void Read(cv::Mat& rows) override; 
+    void Rewind() override; 
+
+    private: 
+    std::string file; 
+    std::ifstream stream; 
+    std::streampos dataStart; 
+    int rows = 0; 
+    int cols = 0; 
+    int channels = 0; 
+    int outputChannels = 0; 
+    cv::Mat fileRows; 
+}; 
+
+// A raw file of rows x cols pixels of the given type (for instance the BGR 
+// frames dumped by a video decoder), stored row after row without padding 
+// from offset bytes on. On POSIX systems the file is memory-mapped, so Read 
+// only copies the rows out of the page cache and the kernel reads ahead of 
+// the rows in use; elsewhere it is read with a stream. 
+class RawRowSource : public RowSource {
+    public: 
+    RawRowSource(const std::string& file, int rows, int cols, int type, std::size_t offset = 0); 
+    ~RawRowSource() override; 
+
+    RawRowSource(const RawRowSource&) = delete; 
+    RawRowSource& operator=(const RawRowSource&) = delete; 
+
+    int Rows() const override; 
+    int Cols() const override; 
+    int Type() const override; 
+    void Read(cv::Mat& rows) override; 
+    void Rewind() override; 
+
+    private: 
+    std::string file; 
+    int rows = 0; 
+    int cols = 0; 
+    int type = 0; 
+    std::size_t offset = 0; 
+    int next = 0; 
+    const unsigned char* mapping = nullptr; 
+    std::size_t mappingSize = 0; 
+    std::ifstream stream; 
+}; 
+
+// Writes the rows as they arrive to a binary PGM or PPM file (one or three 
+// channels, 8 bit). 
+class PnmRowSink : public RowSink {
+    public: 
+    explicit PnmRowSink(const std::string& file); 
+
+    void Begin(int rows, int cols, int type) override; 
+    void Write(const cv::Mat& rows) override; 
+    void End() override; 
+
+    private: 
+    std::string file; 
+    std::ofstream stream; 
+    cv::Mat fileRows; 
+}; 
+
+// True for the .pgm, .ppm and .pnm extensions. 
+bool IsPnmFile(const std::string& file); 
+
+#endif
@@ -0,0 +1,93 @@
+#include "ThreadPool.hpp"
+
+using namespace std; 
+
+int DefaultThreadCount() {
+    int threads = static_cast<int>(thread::hardware_concurrency()); 
+    return threads > 0 ? threads : 1; 
+}
+
+ThreadPool::ThreadPool(int threads) {
+    if(threads <= 0) {
+        threads = DefaultThreadCount(); 
+    }
+
+    for(int i = 0; i < threads; i++) {
+        this->workers.emplace_back(&ThreadPool::WorkerLoop, this); 
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<std::mutex> lock(this->mutex); 
+        this->stopping = true; 
+    }
+    this->jobAvailable.notify_all(); 
+
+    for(thread& worker : this->workers) {
+        worker.join(); 
+    }
+}
+
+void ThreadPool::Submit(function<void()> job) {
+    {
+        lock_guard<std::mutex> lock(this->mutex); 
+        this->jobs.push(move(job)); 
+        this->pending++; 
+    }
+    this->jobAvailable.notify_one(); 
+}
+
+void ThreadPool::Wait() {
+    unique_lock<std::mutex> lock(this->mutex); 
+    this->jobsDone.wait(lock, [this] { return this->pending == 0; }); 
+
+    // The error is consumed, so that the pool can be reused for 
+    // other jobs after the caller has handled it. 
+    if(this->firstError) {
+        exception_ptr error = this->firstError; 
+        this->firstError = nullptr; 
+        rethrow_exception(error); 
+    }
+}
+
+int ThreadPool::Size() const {
+    return static_cast<int>(this->workers.size()); 
+}
+
+void ThreadPool::WorkerLoop() {
+    while(true) {
+        function<void()> job; 
+
+        {
+            unique_lock<std::mutex> lock(this->mutex); 
+            this->jobAvailable.wait(lock, [this] { return this->stopping || !this->jobs.empty(); }); 
+
+            // Pending jobs are drained before the workers exit, so the 
+            // destructor never drops work that was already submitted. 
+            if(this->jobs.empty()) {
+                return; 
+            }
+
+            job = move(this->jobs.front()); 
+            this->jobs.pop(); 
+        }
+
+        exception_ptr error; 
+        try {
+            job(); 
+        } catch(...) {
+            error = current_exception(); 
+        }
+
+        {
+            lock_guard<std::mutex> lock(this->mutex); 
+            if(error && !this->firstError) {
+                this->firstError = error; 
+            }
+            if(--this->pending == 0) {
+                this->jobsDone.notify_all(); 
+            }
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that execute the submitted jobs in FIFO 
+// order. Wait() blocks until every job submitted so far has completed, and 
+// rethrows the first exception that escaped from one of them. 
+class ThreadPool {
+    public: 
+    // With threads <= 0 the pool uses one worker per hardware thread. 
+    explicit ThreadPool(int threads = 0); 
+    ~ThreadPool(); 
+
+    ThreadPool(const ThreadPool&) = delete; 
+    ThreadPool& operator=(const ThreadPool&) = delete; 
+
+    void Submit(std::function<void()> job); 
+    void Wait(); 
+    int Size() const; 
+
+    private: 
+    void WorkerLoop(); 
+
+    std::vector<std::thread> workers; 
+    std::queue<std::function<void()>> jobs; 
+    std::mutex mutex; 
+    std::condition_variable jobAvailable; 
+    std::condition_variable jobsDone; 
+    std::exception_ptr firstError; 
+    int pending = 0; 
+    bool stopping = false; 
+}; 
+
+// Number of hardware threads, never less than one. 
+int DefaultThreadCount(); 
+
+#endif
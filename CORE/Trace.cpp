@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "MemoryStats.hpp"
+#include "Trace.hpp"
+
+using namespace std; 
+
+// One complete event ("ph": "X" in the Chrome trace format). 
+struct TraceEvent {
+    const char* name; 
+    int64_t start; 
+    int64_t duration; 
+    int64_t pixels; 
+    uint64_t allocations; 
+    uint64_t bytes; 
+}; 
+
+// Every thread appends to its own buffer, so recording an event only takes 
+// the (uncontended) lock of the thread's buffer. The buffers are owned by 
+// the registry too, so their events survive the end of their thread. 
+struct ThreadTrace {
+    int id; 
+    mutex bufferMutex; 
+    vector<TraceEvent> events; 
+}; 
+
+static mutex registryMutex; 
+static vector<shared_ptr<ThreadTrace>> registry; 
+static atomic<bool> recording(false); 
+static atomic<int64_t> traceOrigin(0); 
+
+static int64_t NowNanoseconds() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count(); 
+}
+
+static ThreadTrace& CurrentThreadTrace() {
+    static thread_local shared_ptr<ThreadTrace> trace; 
+    if(!trace) {
+        trace = make_shared<ThreadTrace>(); 
+        lock_guard<mutex> lock(registryMutex); 
+        trace->id = static_cast<int>(registry.size()) + 1; 
+        registry.push_back(trace); 
+    }
+    return *trace; 
+}
+
+void StartTracing() {
+    InstallMatAllocationCounting(); 
+
+    lock_guard<mutex> lock(registryMutex); 
+    for(const shared_ptr<ThreadTrace>& trace : registry) {
+        lock_guard<mutex> bufferLock(trace->bufferMutex); 
+        trace->events.clear(); 
+    }
+    traceOrigin = NowNanoseconds(); 
+    recording = true; 
+}
+
+void StopTracing() {
+    recording = false; 
+}
+
+bool TracingAvailable() {
+#ifdef IPA_ENABLE_TRACING
+    return true; 
+#else
+    return false; 
+#endif
+}
+
+// A consistent copy of the events of every thread, with the id of the thread. 
+static vector<pair<int, TraceEvent>> CollectEvents() {
+    vector<pair<int, TraceEvent>> events; 
+
+    lock_guard<mutex> lock(registryMutex); 
+    for(const shared_ptr<ThreadTrace>& trace : registry) {
+        lock_guard<mutex> bufferLock(trace->bufferMutex); 
+        for(const TraceEvent& event : trace->events) {
+            events.push_back(make_pair(trace->id, event)); 
+        }
+    }
+
+    return events; 
+}
+
+static string JsonEscape(const char* text) {
+    string escaped; 
+    for(; *text != '\0'; text++) {
+        if(*text == '"' || *text == '\\') {
+            escaped += '\\'; 
+        }
+        escaped += *text; 
+    }
+    return escaped; 
+}
+
+bool WriteTrace(const string& file) {
+    vector<pair<int, TraceEvent>> events = CollectEvents(); 
+    int64_t origin = traceOrigin; 
+
+    ofstream stream(file); 
+    stream << fixed << setprecision(3); 
+    stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"; 
+
+    bool first = true; 
+    for(const pair<int, TraceEvent>& entry : events) {
+        const TraceEvent& event = entry.second; 
+        stream << (first ? "" : ",\n") 
+               << "{\"name\": \"" << JsonEscape(event.name) << "\", \"cat\": \"ipa\", \"ph\": \"X\", " 
+               << "\"pid\": 1, \"tid\": " << entry.first << ", " 
+               << "\"ts\": " << (event.start - origin)/1000.0 << ", \"dur\": " << event.duration/1000.0 << ", " 
+               << "\"args\": {\"pixels\": " << event.pixels << ", \"allocations\": " << event.allocations 
+               << ", \"bytes\": " << event.bytes << "}}"; 
+        first = false; 
+    }
+
+    stream << "\n]}\n"; 
+    return static_cast<bool>(stream); 
+}
+
+void PrintTraceSummary(ostream& stream) {
+    struct StageTotals {
+        int calls = 0; 
+        int64_t duration = 0; 
+        int64_t pixels = 0; 
+        uint64_t bytes = 0; 
+    }; 
+
+    map<string, StageTotals> stages; 
+    for(const pair<int, TraceEvent>& entry : CollectEvents()) {
+        StageTotals& totals = stages[entry.second.name]; 
+        totals.calls++; 
+        totals.duration += entry.second.duration; 
+        totals.pixels += entry.second.pixels; 
+        totals.bytes += entry.second.bytes; 
+    }
+
+    vector<pair<string, StageTotals>> sorted(stages.begin(), stages.end()); 
+    sort(sorted.begin(), sorted.end(), [](const pair<string, StageTotals>& a, const pair<string, StageTotals>& b) { 
+        return a.second.duration > b.second.duration; 
+    }); 
+
+    ios::fmtflags flags = stream.flags(); 
+    stream << left << setw(28) << "stage" << right << setw(8) << "calls" << setw(12) << "total ms" 
+           << setw(12) << "Mpix/s" << setw(14) << "MB allocated" << endl; 
+    for(const pair<string, StageTotals>& stage : sorted) {
+        double seconds = stage.second.duration / 1e9; 
+        stream << left << setw(28) << stage.first << right << setw(8) << stage.second.calls 
+               << fixed << setprecision(3) << setw(12) << seconds*1000 
+               << setprecision(1) << setw(12) << (seconds > 0 ? stage.second.pixels/seconds/1e6 : 0.0) 
+               << setw(14) << stage.second.bytes/1e6 << endl; 
+    }
+    stream.flags(flags); 
+}
+
+#ifdef IPA_ENABLE_TRACING
+
+TraceScope::TraceScope(const char* name, int64_t pixels) : name(name), pixels(pixels), active(recording) {
+    if(this->active) {
+        AllocationCounters counters = ThreadAllocations(); 
+        this->startAllocations = counters.allocations; 
+        this->startBytes = counters.bytes; 
+        this->start = NowNanoseconds(); 
+    }
+}
+
+TraceScope::~TraceScope() {
+    this->Stop(); 
+}
+
+void TraceScope::Stop() {
+    if(!this->active) {
+        return; 
+    }
+    this->active = false; 
+
+    TraceEvent event; 
+    event.name = this->name; 
+    event.start = this->start; 
+    event.duration = NowNanoseconds() - this->start; 
+    event.pixels = this->pixels; 
+
+    AllocationCounters counters = ThreadAllocations(); 
+    event.allocations = counters.allocations - this->startAllocations; 
+    event.bytes = counters.bytes - this->startBytes; 
+
+    ThreadTrace& trace = CurrentThreadTrace(); 
+    lock_guard<mutex> lock(trace.bufferMutex); 
+    trace.events.push_back(event); 
+}
+
+#endif
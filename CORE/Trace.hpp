@@ -0,0 +1,77 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Per-stage tracing of the algorithms. Every stage opens a scope with 
+// IPA_TRACE_SCOPE(name, pixels), which records its wall time, the pixels it 
+// processes and the bytes allocated by the calling thread while it is open. 
+// The events of all the threads are exported in the Chrome trace format, 
+// which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing. 
+// 
+// The scopes are compiled only when IPA_ENABLE_TRACING is defined (CMake 
+// option of the same name); otherwise the macros expand to nothing and the 
+// pixel count is not even evaluated. Even when compiled in, nothing is 
+// recorded until StartTracing() is called. 
+
+// Starts recording: clears the previous events and installs the cv::Mat 
+// allocation counting used for the bytes of every stage. 
+void StartTracing(); 
+void StopTracing(); 
+
+// True when the library has been compiled with IPA_ENABLE_TRACING. 
+bool TracingAvailable(); 
+
+// Writes the recorded events as Chrome trace JSON. Returns false when the 
+// file cannot be written. 
+bool WriteTrace(const std::string& file); 
+
+// Prints, for every stage name, the number of calls, the total time, the 
+// throughput and the bytes allocated, the most expensive stage first. 
+void PrintTraceSummary(std::ostream& stream); 
+
+#ifdef IPA_ENABLE_TRACING
+
+// Records one event from its construction to Stop() or to its destruction. 
+// The name must outlive the trace (a string literal or a static string). 
+class TraceScope {
+    public: 
+    TraceScope(const char* name, int64_t pixels); 
+    ~TraceScope(); 
+
+    TraceScope(const TraceScope&) = delete; 
+    TraceScope& operator=(const TraceScope&) = delete; 
+
+    void Stop(); 
+
+    private: 
+    const char* name; 
+    int64_t pixels; 
+    int64_t start; 
+    uint64_t startAllocations; 
+    uint64_t startBytes; 
+    bool active; 
+}; 
+
+#define IPA_TRACE_CONCAT_(a, b) a##b
+#define IPA_TRACE_CONCAT(a, b) IPA_TRACE_CONCAT_(a, b)
+
+// An anonymous scope that lasts until the end of the enclosing block. 
+#define IPA_TRACE_SCOPE(name, pixels) TraceScope IPA_TRACE_CONCAT(traceScope, __LINE__)((name), static_cast<int64_t>(pixels))
+
+// A named scope, for the stages that end before their block does: the 
+// event is closed by IPA_TRACE_STOP(variable). 
+#define IPA_TRACE_BEGIN(variable, name, pixels) TraceScope variable((name), static_cast<int64_t>(pixels))
+#define IPA_TRACE_STOP(variable) (variable).Stop()
+
+#else
+
+#define IPA_TRACE_SCOPE(name, pixels) ((void)0)
+#define IPA_TRACE_BEGIN(variable, name, pixels) ((void)0)
+#define IPA_TRACE_STOP(variable) ((void)0)
+
+#endif
+
+#endif
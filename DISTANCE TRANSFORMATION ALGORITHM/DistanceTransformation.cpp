@@ -1,25 +1,24 @@
 #include <cstdio>
 #include <iostream>
 #include <opencv2/opencv.hpp>
+#include "CpuDispatch.hpp"
+#include "DistanceTransformation.hpp"
+#include "Trace.hpp"
 
 using namespace cv; 
 using namespace std; 
 
-Mat Binarization(Mat); 
-Mat TransformationDistance4(Mat);
-Mat TransformationDistance8(Mat);  
-
 Mat Binarization(Mat src) {
-    Mat outputSrc = Mat(src.size(), src.type(), Scalar::all(0)); 
+    IPA_TRACE_SCOPE("Binarization", src.total()); 
+
+    Mat outputSrc = Mat(src.size(), src.type()); 
 
     // We need to binarize the image. All the pixel's value that is greater 
-    // than 128 is set to 255, otherwise is set to 0.
+    // than 128 (at least 129) is set to 255, otherwise is set to 0. Every 
+    // row goes through the vector kernel chosen for the CPU (CpuDispatch.hpp). 
+    const PixelKernels& kernels = ActivePixelKernels(); 
     for(int i = 0; i < src.rows; i++) {
-        for(int j = 0; j < src.cols; j++) {
-            if(src.at<uchar>(i, j) > 128) {
-                outputSrc.at<uchar>(i, j) = 255; 
-            }
-        }
+        kernels.thresholdRow(src.ptr<uchar>(i), outputSrc.ptr<uchar>(i), src.cols, 129); 
     }
 
     // At the end we return the output.
@@ -27,6 +26,8 @@ Mat Binarization(Mat src) {
 }
 
 Mat TransformationDistance4(Mat src) {
+    IPA_TRACE_SCOPE("TransformationDistance4", src.total()); 
+
     Mat outputSrc;  
 
     // The algorithm is based on two scans, the first from top to bottom and 
@@ -75,6 +76,8 @@ Mat TransformationDistance4(Mat src) {
 // take only two elements, in this case we take four elements, and of these we 
 // found the minimum element bewtween these plus one, in the direct scan.
 Mat TransformationDistance8(Mat src) {
+    IPA_TRACE_SCOPE("TransformationDistance8", src.total()); 
+
     Mat outputSrc; 
 
     for(int i = 1; i < src.rows; i++) {
@@ -116,39 +119,3 @@ Mat TransformationDistance8(Mat src) {
 
     return outputSrc; 
 }
-
-int main(int argc, char *argv[]) {
-    // Get the image from command line, in particular the name of the image, 
-    // that is the input of imread() function. The image is read in grayscale
-    // because we need to binarize it. 
-    String inputName = argv[1]; 
-    Mat inputImage = imread(inputName, IMREAD_GRAYSCALE); 
-    
-    // These istructions show image in a window. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE); 
-    imshow("Original Image", inputImage); 
-
-    // We need to binarize the input image. 
-    Mat binarizedImage = Binarization(inputImage); 
-
-    // These istructions show image in a window.
-    namedWindow("Binarized Image", WINDOW_AUTOSIZE); 
-    imshow("Binarized Image", binarizedImage); 
-
-    // This function is for the transformation distance with 4-connected element.  
-    Mat transformationImage4 = TransformationDistance4(binarizedImage); 
-
-    // These istructions show image in a window.
-    namedWindow("Transformation Image 4-Connected", WINDOW_AUTOSIZE); 
-    imshow("Transformation Image 4-Connected", transformationImage4); 
-
-    // This function is for the transformation distance with 8-connected element.  
-    Mat transformationImage8 = TransformationDistance8(binarizedImage); 
-
-    // These istructions show image in a window.
-    namedWindow("Transformation Image 8-Connected", WINDOW_AUTOSIZE); 
-    imshow("Transformation Image 8-Connected", transformationImage8);
-
-    waitKey(0); 
-    return 0; 
-}
\ No newline at end of file
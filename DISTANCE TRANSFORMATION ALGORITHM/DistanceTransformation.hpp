@@ -0,0 +1,12 @@
+#ifndef DISTANCE_TRANSFORMATION_HPP
+#define DISTANCE_TRANSFORMATION_HPP
+
+#include <opencv2/opencv.hpp>
+
+// The input of the transformations must be a binarized image. Note that 
+// the two transformations work directly on the data of the given image. 
+cv::Mat Binarization(cv::Mat); 
+cv::Mat TransformationDistance4(cv::Mat);
+cv::Mat TransformationDistance8(cv::Mat);  
+
+#endif
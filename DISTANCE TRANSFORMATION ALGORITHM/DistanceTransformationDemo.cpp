@@ -0,0 +1,43 @@
+#include <cstdio>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "DistanceTransformation.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    // Get the image from command line, in particular the name of the image, 
+    // that is the input of imread() function. The image is read in grayscale
+    // because we need to binarize it. 
+    String inputName = argv[1]; 
+    Mat inputImage = imread(inputName, IMREAD_GRAYSCALE); 
+    
+    // These istructions show image in a window. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage); 
+
+    // We need to binarize the input image. 
+    Mat binarizedImage = Binarization(inputImage); 
+
+    // These istructions show image in a window.
+    namedWindow("Binarized Image", WINDOW_AUTOSIZE); 
+    imshow("Binarized Image", binarizedImage); 
+
+    // This function is for the transformation distance with 4-connected element.  
+    Mat transformationImage4 = TransformationDistance4(binarizedImage); 
+
+    // These istructions show image in a window.
+    namedWindow("Transformation Image 4-Connected", WINDOW_AUTOSIZE); 
+    imshow("Transformation Image 4-Connected", transformationImage4); 
+
+    // This function is for the transformation distance with 8-connected element.  
+    Mat transformationImage8 = TransformationDistance8(binarizedImage); 
+
+    // These istructions show image in a window.
+    namedWindow("Transformation Image 8-Connected", WINDOW_AUTOSIZE); 
+    imshow("Transformation Image 8-Connected", transformationImage8);
+
+    waitKey(0); 
+    return 0; 
+}
\ No newline at end of file
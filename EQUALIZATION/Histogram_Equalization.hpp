@@ -0,0 +1,13 @@
+#ifndef HISTOGRAM_EQUALIZATION_HPP
+#define HISTOGRAM_EQUALIZATION_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Definiamo i prototipi delle funzioni che saranno utilizzati nei 
+// vari passaggi per l'equalizzazione di un istogramma. 
+cv::Mat             GetHistoImg(cv::Mat src);
+std::vector<double> GetProbabilities(cv::Mat src); 
+cv::Mat             GetEqualization(std::vector<double> probs, cv::Mat src);
+
+#endif
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <opencv2/opencv.hpp>
+#include "Histogram_Equalization.hpp"
+#include <iostream>
+#include <vector>
+
+#define L 256
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    // In questo modo leggiamo da riga di comando nel momento del lancio
+    // le due immagini di partenza, quella di input e quella di output.
+    string in_file = argv[1];
+    string out_file = argv[2];
+    
+    // Assegniamo a due stringhe i nomi delle immagini date in input
+    // con il prefisso hist_, per una migliore comprensione dei risultati.
+    string in_hist_file = "hist_" + in_file;
+    string out_hist_file = "hist_" + out_file;
+    
+    // Leggiamo l'immagine che ci è stata data in input.
+    Mat in_img = imread(in_file, IMREAD_GRAYSCALE);
+    
+    // Istanziamo un nuovo oggetto di tipo Mat, per l'immagine dell'istogramma.
+    Mat in_hist_img;
+    in_hist_img = GetHistoImg(in_img);
+    
+    // Alla fine scriviamo l'immagine in un nuovo file, che riposta il nome
+    // definito dalla stringa in_hist_file.
+    imwrite(in_hist_file, in_hist_img);
+    
+    // Il vettore dichiarato conterrà ciò che sarà restituito dalla funzione
+    // GetProbabilities che prende in input l'immagine data da riga di comando. 
+    vector<double> probs(L-1); 
+    probs = GetProbabilities(in_img); 
+
+    // L'immagine equalizzata sarà restituita dalla funzione GetEqualization che 
+    // prende in input il vettore delle probabilità (calcolato in precedenza) e 
+    // l'immagine data in input. 
+    Mat equalizedImg; 
+    equalizedImg = GetEqualization(probs, in_img); 
+
+    // Possiamo confrontare il risultato con ciò che è restituito dalla funzione che 
+    // si occupa di equalizzare l'immagine direttamente grazie alla libreria OpenCV. 
+    Mat equalizedImageOpenCV = Mat::zeros(in_img.rows, in_img.cols, in_img.type());
+    equalizeHist(in_img, equalizedImageOpenCV);
+
+    // Visualizziamo l'immagine dell'equalizzazione in una finestra apposita. 
+    namedWindow("OpenCV Equalization", WINDOW_AUTOSIZE);
+    imshow("OpenCV Equalization", equalizedImageOpenCV);
+
+    // Visualizziamo l'immagine dell'equalizzazione in una finestra apposita. 
+    namedWindow("Custom Equalization", WINDOW_AUTOSIZE);
+    imshow("Custom Equalization", equalizedImg);
+    
+    // Visualizziamo l'immagine dell'istogramma in una finestra apposita.
+    namedWindow("Histogram", WINDOW_AUTOSIZE);
+    imshow("Histogram", in_hist_img);
+
+    // Visualizziamo l'immagine originale. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE);
+    imshow("Original Image", in_img);
+    
+    waitKey(0);
+    
+    return 0;
+}
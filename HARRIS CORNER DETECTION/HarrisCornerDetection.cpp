@@ -3,151 +3,472 @@
 #include <math.h>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <functional>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdint>
 #include <opencv2/opencv.hpp>
+#include "CpuDispatch.hpp"
+#include "HarrisCornerDetection.hpp"
+#include "ImagePyramid.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
 
 using namespace std; 
 using namespace cv; 
 
-Mat GaussianFilter(Mat& src, int size, float sigma); 
-pair<Mat, Mat> SobelFilter(Mat& src);
-Mat HarrisCornerDetector(Mat& src, Mat& Ix, Mat& Iy, int upper);
-
-// Definiamo una struct per gestire una struttura dati per i punti che hanno come 
-// informazioni le coordinate x, y e l'autovalore l, tale struttura sarà utilizzata 
-// per la dichiarazione dei punti e del vettore di questi ultimi. 
-struct PPoint {
-    int x; 
-    int y; 
-    int l; 
-}; 
+// Le righe [first, last) delle derivate di SobelFilter, nelle righe 
+// 0..last-first-1 di Ix e Iy. 
+static void AbsoluteSobelRows(const Mat& src, int first, int last, Mat& Ix, Mat& Iy) {
+    // Le due matrici sono quelle che salveranno le derivate parziali calcolate 
+    // con l'operatore Sobel di ogni pixel dell'immagine; dove la maschera non 
+    // sta nell'immagine le derivate valgono 0. 
+    Ix = Mat::zeros(last-first, src.cols, CV_8UC1); 
+    Iy = Mat::zeros(last-first, src.cols, CV_8UC1); 
+
+    // Si scorre tutta l'immagine dall'inizio fino alla fine facendo attenzione 
+    // a non sforare i bordi dell'immagine con la maschera 3x3 che deve essere 
+    // applicata sull'immagine stessa: il pixel (i, j) si calcola dalle righe 
+    // i..i+2 e dalle colonne j..j+2. Il kernel sobelRow (quello vettoriale 
+    // scelto all'avvio per la CPU, CpuDispatch.hpp) calcola per ogni riga i 
+    // valori assoluti delle derivate parziali rispetto ad x e rispetto ad y, 
+    // che vengono poi troncati a 8 bit come in precedenza. 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    int count = src.cols-3; 
+    vector<int16_t> gx(max(count, 0)); 
+    vector<int16_t> gy(max(count, 0)); 
+
+    for(int i = first; i < min(last, src.rows-3) && count > 0; i++) {
+        kernels.sobelRow(src.ptr<uchar>(i), src.ptr<uchar>(i+1), src.ptr<uchar>(i+2), count, gx.data(), gy.data()); 
+
+        uchar* rowX = Ix.ptr<uchar>(i-first); 
+        uchar* rowY = Iy.ptr<uchar>(i-first); 
+        for(int j = 0; j < count; j++) {
+            rowX[j] = static_cast<uchar>(gx[j]); 
+            rowY[j] = static_cast<uchar>(gy[j]); 
+        }
+    }
+}
+
+pair<Mat, Mat> SobelFilter(Mat& src) {
+    IPA_TRACE_SCOPE("SobelFilter", src.total()); 
+
+    Mat Ix, Iy; 
+    AbsoluteSobelRows(src, 0, src.rows, Ix, Iy); 
+
+    // Quello che vogliamo restituire è una struttura che è composta dalle due matrici 
+    // ottenute dalle derivate parziali rispetto ad x e rispetto ad y dei pixel.  
+    pair<Mat, Mat> derivates = make_pair(Ix, Iy);
+    return derivates; 
+}
 
-Mat GaussianFilter(Mat& src, int size, float sigma) {
-    // La prima matrice è la maschera Gaussiana da applicare all'immagine 
-    // per mezzo di convoluzione. La seconda matrice è l'immagine risultante
-    // dall'operazione di applicazione del filtro Gaussiano. 
-    Mat kernel = Mat_<double>(size, size);
-    Mat result = Mat(src.rows, src.cols, src.type());
-
-    // Vengono calcolati il limite sinistro e quello di destro per poter 
-    // calcolare il kernel Gaussiano. 
-    int leftLimit = floor((kernel.rows/2)*(-1)); 
-    int rightLimit = floor((kernel.cols/2)*(1));
-
-    double summary = 0.0; 
-    double sum = 0.0; 
-    double pix = 0.0; 
-
-    double multConstant = 1/exp(-(pow(leftLimit, 2) + pow(leftLimit, 2)) / (2*pow(sigma, 2)));
-
-    // I due cicli for annidati permettono di calcolare la maschera da
-    // applicare all'immagine e permette di calcolare la somma di tutti 
-    // gli elementi che compongono tale maschera. Il risultato di questa 
-    // operazione non è normalizzato. 
-    for(int i = leftLimit; i <= rightLimit; i++) {
-        for(int j = leftLimit; j <= rightLimit; j++) {
-            pix = exp(-(pow(i, 2) + pow(j, 2)) / (2*pow(sigma, 2)));
-            kernel.at<double>(i+rightLimit, j+rightLimit) = cvRound(pix * multConstant);
-            sum += kernel.at<double>(i+rightLimit, j+rightLimit);
+// La risposta di un pixel dagli elementi della matrice M = [a b; b c]: gli 
+// autovalori di una matrice simmetrica 2x2 sono (a+c)/2 -+ sqrt(((a-c)/2)^2 + b^2), 
+// quindi non serve un risolutore generale. 
+static inline double PixelResponse(double a, double b, double c, const HarrisOptions& options) {
+    if(options.measure == HarrisMeasure::Harris) {
+        return a*c - b*b - options.harrisK * (a+c) * (a+c); 
+    }
+    double half = (a - c) / 2; 
+    return (a + c) / 2 - sqrt(half*half + b*b); 
+}
+
+// Le righe [first, last) dei prodotti delle derivate (Ix^2, Iy^2 e IxIy), 
+// scritte nelle righe 0..last-first-1 di tre piani CV_32FC1 allocati dalla 
+// funzione. 
+typedef function<void(int first, int last, Mat& xx, Mat& yy, Mat& xy)> ProductRows; 
+
+// I prodotti delle derivate a 8 bit di una banda. 
+static void AbsoluteProducts(const Mat& dX, const Mat& dY, Mat& xx, Mat& yy, Mat& xy) {
+    xx.create(dX.rows, dX.cols, CV_32FC1); 
+    yy.create(dX.rows, dX.cols, CV_32FC1); 
+    xy.create(dX.rows, dX.cols, CV_32FC1); 
+    for(int i = 0; i < dX.rows; i++) {
+        const uchar* dx = dX.ptr<uchar>(i); 
+        const uchar* dy = dY.ptr<uchar>(i); 
+        float* rowXX = xx.ptr<float>(i); 
+        float* rowYY = yy.ptr<float>(i); 
+        float* rowXY = xy.ptr<float>(i); 
+        for(int j = 0; j < dX.cols; j++) {
+            rowXX[j] = static_cast<float>(dx[j] * dx[j]); 
+            rowYY[j] = static_cast<float>(dy[j] * dy[j]); 
+            rowXY[j] = static_cast<float>(dx[j] * dy[j]); 
         }
     }
+}
 
-    // Per poter normalizzare il risultato dell'operazione allora ogni 
-    // elemento che compone il kernel deve essere rapportato alla 
-    // somma di tutti gli elementi della maschera. 
-    for(int i = 0; i < kernel.rows; i++) {
-        for(int j = 0; j < kernel.cols; j++) {
-            kernel.at<double>(i, j) /= sum; 
+// Le righe [first, last) dell'immagine filtrata da GaussianFilter (nulle 
+// dove la maschera non sta nelle imageRows righe dell'immagine), nelle righe 
+// 0..last-first-1 di dst; la riga 0 di src è la riga srcFirst dell'immagine. 
+static void GaussianRows(const GaussianKernel& kernel, const Mat& src, int srcFirst, int imageRows, int first, int last, Mat& dst) {
+    int radius = kernel.size/2; 
+    dst = Mat::zeros(last-first, src.cols, CV_8UC1); 
+    vector<uint16_t> scratch(src.cols); 
+    vector<const uchar*> rows(kernel.size); 
+    for(int i = max(first, radius); i < min(last, imageRows-radius); i++) {
+        for(int k = 0; k < kernel.size; k++) {
+            rows[k] = src.ptr<uchar>(i-radius+k-srcFirst); 
         }
-    } 
-
-    // La convoluzione è molto pesante dal punto di vista computazionale, 
-    // per cui di solito si sceglie di operare con degli array piuttosto 
-    // che con una matrice (non è questo il caso). I primi due cicli for 
-    // annidati scorrono sull'immagine di partenza fino ad un limite massimo 
-    // definito dalla grandezza della maschera, questo per non sforare i 
-    // limiti della matrice che definisce l'immagine di partenza. 
-    for(int i = 0; i <= src.rows-kernel.rows; i++) {
-        for(int j = 0; j <= src.cols-kernel.cols; j++) {
-            
-            // I cicli for annidati più interni lavorano sulla maschera (kernel) e 
-            // scorrono dall'inizio fino alla fine della matrice del kernel. 
-            // L'operazione svolta all'interno dei due cicli for è quella di ottenere 
-            // la somma di tutti gli elementi della matrice dell'immagine inquadrati 
-            // nella maschera kernel, moltiplicati con i corrispettivi elementi del 
-            // kernel stesso. 
-            for(int x = 0; x < kernel.rows; x++) {
-                for(int y = 0; y < kernel.cols; y++) {
-                    summary += static_cast<double>(src.at<uchar>(x+i, y+j)) * kernel.at<double>(x, y);  
-                }
+        GaussianFilterRow(kernel, rows.data(), src.cols, scratch.data(), dst.ptr<uchar>(i-first)); 
+    }
+}
+
+// Le righe [first, last) della mappa delle risposte (in response, se non è 
+// nullo) ed i loro candidati, i punti con risposta maggiore di upper (in 
+// candidates, se non è nullo). La risposta della riga i usa le righe 
+// i..i+windowSize-1 dei prodotti, quindi la banda ne calcola windowSize-1 
+// in più delle sue. 
+static void ResponseBand(const ProductRows& products, int rows, int cols, int first, int last, const HarrisOptions& options, Mat* response, int upper, vector<HarrisCorner>* candidates) {
+    IPA_TRACE_SCOPE("HarrisBand", static_cast<size_t>(last-first) * cols); 
+
+    int wSize = options.windowSize; 
+    int end = min(last, rows-wSize); 
+    if(end <= first || cols <= wSize) {
+        return; 
+    }
+
+    Mat xx, yy, xy; 
+    products(first, end+wSize-1, xx, yy, xy); 
+
+    // Le somme della finestra vengono calcolate come nel filtro di media: 
+    // per ogni colonna la somma delle wSize righe della finestra, aggiornata 
+    // aggiungendo la riga che entra e togliendo quella che esce, e lungo la 
+    // riga la somma di wSize di queste colonne, aggiornata allo stesso modo. 
+    // I prodotti sono interi e le somme in double restano esatte, quindi il 
+    // costo per pixel è costante qualunque sia la dimensione della finestra. 
+    vector<double> columnXX(cols, 0), columnYY(cols, 0), columnXY(cols, 0); 
+    auto addRow = [&](int i, double sign) {
+        const float* rowXX = xx.ptr<float>(i); 
+        const float* rowYY = yy.ptr<float>(i); 
+        const float* rowXY = xy.ptr<float>(i); 
+        for(int j = 0; j < cols; j++) {
+            columnXX[j] += sign * rowXX[j]; 
+            columnYY[j] += sign * rowYY[j]; 
+            columnXY[j] += sign * rowXY[j]; 
+        }
+    }; 
+    for(int i = 0; i < wSize; i++) {
+        addRow(i, 1); 
+    }
+
+    vector<float> rowBuffer(response ? 0 : cols); 
+    for(int i = first; i < end; i++) {
+        int local = i - first; 
+        if(local > 0) {
+            addRow(local+wSize-1, 1); 
+            addRow(local-1, -1); 
+        }
+
+        double a = 0, b = 0, c = 0; 
+        for(int x = 0; x < wSize; x++) {
+            a += columnXX[x]; 
+            b += columnXY[x]; 
+            c += columnYY[x]; 
+        }
+
+        float* out = response ? response->ptr<float>(i) : rowBuffer.data(); 
+        for(int j = 0; j < cols-wSize; j++) {
+            out[j] = static_cast<float>(PixelResponse(a, b, c, options)); 
+            a += columnXX[j+wSize] - columnXX[j]; 
+            b += columnXY[j+wSize] - columnXY[j]; 
+            c += columnYY[j+wSize] - columnYY[j]; 
+        }
+
+        // Se la risposta (il più piccolo autovalore) è più grande di un certo 
+        // valore che è il valore di threshold, allora il pixel viene inserito 
+        // con le sue coordinate ed il suo autovalore nei candidati della banda. 
+        for(int j = 0; candidates && j < cols-wSize; j++) {
+            if(out[j] > upper) {
+                HarrisCorner point; 
+                point.x = i; 
+                point.y = j; 
+                point.response = out[j]; 
+                candidates->push_back(point); 
             }
+        }
+    }
+}
 
-            // Al termine dei due cicli for interni si assegna il valore della sommatoria
-            // al pixel centrale della porzione di immagine inquadrata dalla maschera. Ed 
-            // ovviamente si riporta la sommatoria a 0.  
-            result.at<uchar>(i+1, j+1) = static_cast<uchar>((summary));
-            summary = 0.0; 
+// Un livello su cui vengono calcolate le risposte: i prodotti delle derivate 
+// della sua immagine, la sua dimensione ed il suo indice nella piramide 
+// (0 per l'immagine intera). 
+struct ResponseLevel {
+    ProductRows products; 
+    int rows; 
+    int cols; 
+    int level; 
+}; 
 
-        } 
+// Divide le righe della mappa delle risposte di ogni livello in bande, 
+// elaborate in parallelo (tutte insieme, di tutti i livelli) su 
+// options.threads thread: ogni banda calcola dall'inizio le derivate ed i 
+// prodotti delle sue righe e di quelle dell'alone che le servono, ed ha la sua 
+// lista di candidati; le liste vengono unite nell'ordine dei livelli e delle 
+// bande, quindi i candidati sono quelli (e nello stesso ordine) del calcolo 
+// su una banda sola. Le coordinate dei candidati del livello k vengono 
+// moltiplicate per 2^k; la mappa response è quella dell'unico livello. 
+static void BandedResponse(const vector<ResponseLevel>& levels, const HarrisOptions& options, Mat* response, int upper, vector<HarrisCorner>* candidates) {
+    int maxThreads = options.threads > 0 ? options.threads : DefaultThreadCount(); 
+    int minBandRows = max(32, 4*options.windowSize); 
+
+    struct Band {
+        int level; 
+        int first; 
+        int last; 
+    }; 
+    vector<Band> jobs; 
+    for(int l = 0; l < static_cast<int>(levels.size()); l++) {
+        int rows = levels[l].rows; 
+        int bands = max(1, min(maxThreads, rows / minBandRows)); 
+        for(int b = 0; b < bands; b++) {
+            int first = static_cast<int>(static_cast<int64_t>(rows) * b / bands); 
+            int last = static_cast<int>(static_cast<int64_t>(rows) * (b+1) / bands); 
+            jobs.push_back({l, first, last}); 
+        }
     }
 
-    // Alla fine si restituisce l'immagine risultante. 
-    return result; 
+    vector<vector<HarrisCorner>> bandCandidates(jobs.size()); 
+    auto band = [&](size_t b) {
+        const ResponseLevel& level = levels[jobs[b].level]; 
+        vector<HarrisCorner>* list = candidates ? &bandCandidates[b] : nullptr; 
+        ResponseBand(level.products, level.rows, level.cols, jobs[b].first, jobs[b].last, options, response, upper, list); 
+        for(size_t k = 0; list && level.level > 0 && k < list->size(); k++) {
+            (*list)[k].x <<= level.level; 
+            (*list)[k].y <<= level.level; 
+            (*list)[k].level = level.level; 
+        }
+    }; 
+
+    int workers = min(maxThreads, static_cast<int>(jobs.size())); 
+    if(workers <= 1) {
+        for(size_t b = 0; b < jobs.size(); b++) {
+            band(b); 
+        }
+    } else {
+        ThreadPool pool(workers); 
+        for(size_t b = 0; b < jobs.size(); b++) {
+            pool.Submit([&band, b] {
+                band(b); 
+            }); 
+        }
+        pool.Wait(); 
+    }
+
+    if(candidates) {
+        for(vector<HarrisCorner>& list : bandCandidates) {
+            candidates->insert(candidates->end(), list.begin(), list.end()); 
+        }
+    }
 }
 
-pair<Mat, Mat> SobelFilter(Mat& src) {
-    // Le due matrici riguardano le maschere di Sobel da applicare all'immagine 
-    // per mezzo di convoluzione.
-    Mat sobelX = (Mat_<int>(3, 3) << -1, 0, 1, -2, 0, 2, -1, 0, 1);
-    Mat sobelY = (Mat_<int>(3, 3) << 1, 2, 1, 0, 0, 0, -1, -2, -1);
+static void CheckWindow(const HarrisOptions& options) {
+    if(options.windowSize < 1) {
+        throw invalid_argument("the window of the Harris detector must be at least 1: " + to_string(options.windowSize)); 
+    }
+    if(options.levels < 1) {
+        throw invalid_argument("the Harris detector needs at least one level: " + to_string(options.levels)); 
+    }
+}
 
-    // Le due matrici sono quelle che salveranno le derivate parziali calcolate 
-    // con l'operatore Sobel di ogni pixel dell'immagine. 
-    Mat Ix = Mat(src.rows, src.cols, src.type()); 
-    Mat Iy = Mat(src.rows, src.cols, src.type());
+// I prodotti delle derivate date Ix e Iy; quelli delle derivate con segno 
+// vengono calcolati dal kernel tensorRow (CpuDispatch.hpp). 
+static ProductRows DerivativeProducts(const Mat& Ix, const Mat& Iy) {
+    bool signedDerivatives = Ix.type() == CV_16SC1; 
+    if((Ix.type() != CV_8UC1 && !signedDerivatives) || Iy.type() != Ix.type() || Ix.size() != Iy.size()) {
+        throw invalid_argument("the Harris detector needs two CV_8UC1 or CV_16SC1 derivatives of the same type and size"); 
+    }
 
-    double sumX = 0.0; 
-    double sumY = 0.0; 
+    return [Ix, Iy, signedDerivatives](int first, int last, Mat& xx, Mat& yy, Mat& xy) {
+        if(!signedDerivatives) {
+            AbsoluteProducts(Ix.rowRange(first, last), Iy.rowRange(first, last), xx, yy, xy); 
+            return; 
+        }
 
-    // Si scorre tutta l'immagine dall'inizio fino alla fine facendo attenzione 
-    // a non sforare i bordi dell'immagine con la maschera che deve essere applicata 
-    // sull'immagine stessa.  
-    for(int i = 0; i < src.rows-sobelX.rows; i++) {
-        for(int j = 0; j < src.cols-sobelY.cols; j++) {
-
-            // I due cicli for più interni applicano il processo di convoluzione all'immagine, 
-            // calcolando la derivata parziale rispetto ad x e rispetto ad y. Ricordiamo che 
-            // questa viene calcolata in base alla sommatoria di tutti gli elementi che sono 
-            // compresi all'interno della maschera moltiplicati con i corrispettivi elementi 
-            // che compongono la maschera stessa. 
-            for(int x = 0; x < sobelX.rows; x++) {
-                for(int y = 0; y < sobelX.cols; y++) {
-                    sumX += static_cast<double>(static_cast<int>(src.at<uchar>(x+i, y+j)) * sobelX.at<int>(x, y));
-                    sumY += static_cast<double>(static_cast<int>(src.at<uchar>(x+i, y+j)) * sobelY.at<int>(x, y));
-                }
+        const PixelKernels& kernels = ActivePixelKernels(); 
+        xx.create(last-first, Ix.cols, CV_32FC1); 
+        yy.create(last-first, Ix.cols, CV_32FC1); 
+        xy.create(last-first, Ix.cols, CV_32FC1); 
+        for(int i = first; i < last; i++) {
+            kernels.tensorRow(Ix.ptr<int16_t>(i), Iy.ptr<int16_t>(i), Ix.cols, xx.ptr<float>(i-first), yy.ptr<float>(i-first), xy.ptr<float>(i-first)); 
+        }
+    }; 
+}
+
+// I prodotti delle derivate calcolate dall'immagine, come indicato da 
+// options.derivatives. 
+static ProductRows ImageProducts(const Mat& src, const HarrisOptions& options) {
+    if(src.type() != CV_8UC1) {
+        throw invalid_argument("the Harris detector needs a CV_8UC1 image: type " + to_string(src.type())); 
+    }
+    bool smooth = options.gaussianSize > 0; 
+    GaussianKernel kernel; 
+    if(smooth) {
+        kernel = MakeGaussianKernel(options.gaussianSize, options.gaussianSigma); 
+    }
+    int radius = kernel.size/2; 
+    int rows = src.rows; 
+
+    if(options.derivatives == HarrisDerivatives::Absolute) {
+        // Come SobelFilter seguito da GaussianFilter su Ix e Iy: le righe 
+        // filtrate [first, last) usano le derivate delle righe 
+        // first-radius..last+radius-1. 
+        return [src, kernel, smooth, radius, rows](int first, int last, Mat& xx, Mat& yy, Mat& xy) {
+            Mat dX, dY; 
+            if(smooth) {
+                int sobelFirst = max(0, first-radius); 
+                Mat sobelX, sobelY; 
+                AbsoluteSobelRows(src, sobelFirst, min(rows, last+radius), sobelX, sobelY); 
+                GaussianRows(kernel, sobelX, sobelFirst, rows, first, last, dX); 
+                GaussianRows(kernel, sobelY, sobelFirst, rows, first, last, dY); 
+            } else {
+                AbsoluteSobelRows(src, first, last, dX, dY); 
             }
+            AbsoluteProducts(dX, dY, xx, yy, xy); 
+        }; 
+    }
 
-            sumX = abs(sumX); 
-            sumY = abs(sumY); 
+    // L'immagine viene smussata (se richiesto) prima delle derivate, e per 
+    // ogni riga le derivate con segno (signedSobelRow) ed i loro prodotti 
+    // (tensorRow) vengono calcolati insieme, come in SobelTensor: la riga i 
+    // dei prodotti usa le righe i..i+2 dell'immagine smussata. 
+    return [src, kernel, smooth, radius, rows](int first, int last, Mat& xx, Mat& yy, Mat& xy) {
+        int smoothLast = min(rows, last+2); 
+        Mat smoothed; 
+        if(smooth) {
+            int srcFirst = max(0, first-radius); 
+            GaussianRows(kernel, src.rowRange(srcFirst, min(rows, smoothLast+radius)), srcFirst, rows, first, smoothLast, smoothed); 
+        } else {
+            smoothed = src.rowRange(first, smoothLast); 
+        }
 
-            // I risultati che otteniamo li inseriamo all'interno delle due matrici che 
-            // conservano le derivate parziali rispetto ad x e rispetto ad y di ogni 
-            // pixel che viene considerato. 
-            Ix.at<uchar>(i, j) = static_cast<uchar>(sumX); 
-            Iy.at<uchar>(i, j) = static_cast<uchar>(sumY); 
+        const PixelKernels& kernels = ActivePixelKernels(); 
+        xx = Mat::zeros(last-first, src.cols, CV_32FC1); 
+        yy = Mat::zeros(last-first, src.cols, CV_32FC1); 
+        xy = Mat::zeros(last-first, src.cols, CV_32FC1); 
+        int count = src.cols-2; 
+        vector<int16_t> gx(max(count, 0)); 
+        vector<int16_t> gy(max(count, 0)); 
+        for(int i = first; i < min(last, rows-2) && count > 0; i++) {
+            int local = i - first; 
+            kernels.signedSobelRow(smoothed.ptr<uchar>(local), smoothed.ptr<uchar>(local+1), smoothed.ptr<uchar>(local+2), count, gx.data(), gy.data()); 
+            kernels.tensorRow(gx.data(), gy.data(), count, xx.ptr<float>(local), yy.ptr<float>(local), xy.ptr<float>(local)); 
+        }
+    }; 
+}
+
+Mat HarrisResponse(const Mat& Ix, const Mat& Iy, const HarrisOptions& options) {
+    IPA_TRACE_SCOPE("HarrisResponse", Ix.total()); 
 
-            sumX = 0; 
-            sumY = 0; 
+    // I prodotti delle derivate (Ix^2, Iy^2 e IxIy) vengono calcolati una 
+    // volta sola per pixel, in tre piani float, banda per banda. 
+    CheckWindow(options); 
+    ProductRows products = DerivativeProducts(Ix, Iy); 
+    Mat response = Mat::zeros(Ix.rows, Ix.cols, CV_32FC1); 
+    BandedResponse({{products, Ix.rows, Ix.cols, 0}}, options, &response, 0, nullptr); 
+    return response; 
+}
+
+Mat HarrisResponse(const Mat& src, const HarrisOptions& options) {
+    IPA_TRACE_SCOPE("HarrisResponse", src.total()); 
 
+    CheckWindow(options); 
+    ProductRows products = ImageProducts(src, options); 
+    Mat response = Mat::zeros(src.rows, src.cols, CV_32FC1); 
+    BandedResponse({{products, src.rows, src.cols, 0}}, options, &response, 0, nullptr); 
+    return response; 
+}
+
+// La soppressione dei non massimi: i punti vengono considerati in ordine di 
+// autovalore decrescente (a parità, per coordinate e per livello), e un punto 
+// viene tenuto solo se nessuno dei punti già tenuti è entro R righe e R 
+// colonne da lui, con R = radius * 2^k e k il più grosso dei due livelli: un 
+// punto trovato su un livello più piccolo della piramide copre un'area più 
+// grande dell'immagine. I punti tenuti del livello l vengono inseriti in una 
+// griglia di celle di lato radius*2^l+1, così che basta controllare le poche 
+// celle intorno al punto (3x3 sul livello del punto): in ogni cella ci sono 
+// al più quattro punti tenuti, e il costo è lineare nel numero dei punti 
+// (oltre all'ordinamento). Con maxCorners > 0 si tengono al più maxCorners 
+// punti, e invece di ordinare tutti i punti si estraggono da uno heap solo 
+// quelli che servono. 
+static vector<HarrisCorner> SuppressCorners(vector<HarrisCorner>& L, int rows, int cols, int radius, int maxCorners) {
+    auto stronger = [](const HarrisCorner& point1, const HarrisCorner& point2) {
+        if(point1.response != point2.response) {
+            return point1.response > point2.response; 
+        }
+        if(point1.x != point2.x) {
+            return point1.x < point2.x; 
         }
+        return point1.y != point2.y ? point1.y < point2.y : point1.level < point2.level; 
+    }; 
+    auto weaker = [&stronger](const HarrisCorner& point1, const HarrisCorner& point2) {
+        return stronger(point2, point1); 
+    }; 
+
+    struct Grid {
+        int side; 
+        int gridRows; 
+        int gridCols; 
+        vector<int> cellHead; 
+    }; 
+    int levels = 1; 
+    for(const HarrisCorner& point : L) {
+        levels = max(levels, point.level + 1); 
+    }
+    vector<Grid> grids(levels); 
+    for(int l = 0; l < levels; l++) {
+        grids[l].side = (radius << l) + 1; 
+        grids[l].gridRows = rows / grids[l].side + 1; 
+        grids[l].gridCols = cols / grids[l].side + 1; 
+        grids[l].cellHead.assign(static_cast<size_t>(grids[l].gridRows) * grids[l].gridCols, -1); 
     }
+    vector<int> nextInCell; 
+    vector<HarrisCorner> corners; 
+
+    auto keep = [&](const HarrisCorner& point) {
+        for(int l = 0; l < levels; l++) {
+            const Grid& grid = grids[l]; 
+            int R = radius << max(l, point.level); 
+            int lastRow = min(grid.gridRows-1, (point.x + R) / grid.side); 
+            int lastCol = min(grid.gridCols-1, (point.y + R) / grid.side); 
+            for(int r = max(0, point.x - R) / grid.side; r <= lastRow; r++) {
+                for(int c = max(0, point.y - R) / grid.side; c <= lastCol; c++) {
+                    for(int k = grid.cellHead[static_cast<size_t>(r) * grid.gridCols + c]; k >= 0; k = nextInCell[k]) {
+                        if(abs(corners[k].x - point.x) <= R && abs(corners[k].y - point.y) <= R) {
+                            return; 
+                        }
+                    }
+                }
+            }
+        }
 
-    // Quello che vogliamo restituire è una struttura che è composta dalle due matrici 
-    // ottenute dalle derivate parziali rispetto ad x e rispetto ad y dei pixel.  
-    pair<Mat, Mat> derivates = make_pair(Ix, Iy);
-    return derivates; 
+        Grid& grid = grids[point.level]; 
+        int& head = grid.cellHead[static_cast<size_t>(point.x / grid.side) * grid.gridCols + point.y / grid.side]; 
+        nextInCell.push_back(head); 
+        head = static_cast<int>(corners.size()); 
+        corners.push_back(point); 
+    }; 
+
+    if(maxCorners > 0) {
+        make_heap(L.begin(), L.end(), weaker); 
+        for(auto end = L.end(); end != L.begin() && static_cast<int>(corners.size()) < maxCorners; --end) {
+            pop_heap(L.begin(), end, weaker); 
+            keep(*(end - 1)); 
+        }
+    } else {
+        sort(L.begin(), L.end(), stronger); 
+        for(const HarrisCorner& point : L) {
+            keep(point); 
+        }
+    }
+
+    return corners; 
 }
 
-Mat HarrisCornerDetector(Mat& src, Mat& Ix, Mat& Iy, int upper) {
+// I punti dei prodotti delle derivate dei livelli e la loro soppressione. 
+static vector<HarrisCorner> DetectCorners(const vector<ResponseLevel>& levels, int upper, const HarrisOptions& options) {
     // Abbiamo calcolato l'immagine gradiente di ogni pixel attraverso l'operatore di Sobel, 
     // e sono state salvate le derivate parziali rispetto ad x e rispetto ad y in due matrici 
     // che sono chiamate Ix e Iy, che di conseguenza sono state date in input alla funzione. 
@@ -157,121 +478,324 @@ Mat HarrisCornerDetector(Mat& src, Mat& Ix, Mat& Iy, int upper) {
     // La matrice M è una matrice composta dalle derivate parziali che sono state calcolate 
     // con Sobel (in questo caso) di quello specifico pixel. Tale matrice è moltiplicata ad 
     // una maschera w(x, y) che è una finestra che assegna peso unitario al pixel che si trova 
-    // al suo interno. la dimensione di tale finestra è pari a 3(x3) ed è data dalla variabile wSize.  
-    int wSize = 3; 
-
-    // Il vettore L che andiamo a creare è del tipo EidenPoint, una classe che conserva specifiche 
-    // informazioni, quali le coordinate x, y e l'autovalore di quel pixel in quella posizione. 
-    vector<PPoint> L;
-
-    for(int i = 0; i < src.rows-wSize; i++) {
-        for(int j = 0; j < src.cols-wSize; j++) {
-
-            // La matrice M è di dimensioni 2x2, e conterrà quelle che sono le derivate parziali 
-            // rispetto ad x e rispetto ad y (ed il loro prodotto) per ogni pixel. La seconda 
-            // matrice invece è di dimensione pari a 1 colonna e 2 righe e conserva gli autovalori 
-            // calcolati della matrice M. 
-            Mat M = Mat::zeros(2, 2, CV_32FC1);
-            Mat eigenVal = Mat::zeros(1, 2, CV_32FC1);
-            
-            // I cicli for più interni servono per poter calcolare gli elementi della matrice M, e
-            // quindi scorrono sulle dimensioni della matrice M stessa. Utilizziamo la sommatoria 
-            // per poter calcolare le somme dei prodotti delle derivate rispetto ad x e rispetto ad 
-            // y dei pixel che sono inquadrati dalla finestra che assegna ad essi peso unitario. 
-            for(int x = 0; x < wSize; x++) {
-                for(int y = 0; y < wSize; y++) {
-                    M.at<float>(0, 0) += static_cast<float>(pow(Ix.at<uchar>(i+x, j+y), 2)); 
-                    M.at<float>(0, 1) += static_cast<float>(Ix.at<uchar>(i+x, j+y) * Iy.at<uchar>(i+x, j+y));
-                    M.at<float>(1, 0) += static_cast<float>(Ix.at<uchar>(i+x, j+y) * Iy.at<uchar>(i+x, j+y)); 
-                    M.at<float>(1, 1) += static_cast<float>(pow(Iy.at<uchar>(i+x, j+y), 2));
-                }
-            }
+    // al suo interno. la dimensione di tale finestra è data dalla variabile wSize (3 se non 
+    // indicata nelle opzioni). Entrambi i passi sono calcolati banda per banda da 
+    // BandedResponse, senza salvare la mappa delle risposte. 
+    int wSize = options.windowSize; 
 
-            // La funzione va direttamente a calcolare gli autovalori della matrice M, e li va 
-            // ad inserire all'interno della matrice eigenVal, che è un vettore. 
-            eigen(M, eigenVal); 
-
-            // Dobbiamo estrapolare da questo il più piccolo autovalore, che andiamo a salvare
-            // all'interno della variabile minEigen (sfruttiamo la funzione min). 
-            float minEigen = min(eigenVal.at<float>(0, 0), eigenVal.at<float>(0, 1));
-            
-            // Se questo autovalore è più grande di un certo valore che è il valore di threshold, 
-            // e se lo è allora il pixel viene inserito con le sue coordinate ed il suo autovalore 
-            // all'interno del vettore L. 
-            if(minEigen > upper) {
-                // Definiamo una variabile di tipo PPoint per poter salvare le informazioni del punto. 
-                PPoint point;
-
-                // Inseriamo le informazioni all'interno della struttura dati per il punto. 
-                point.x = i; 
-                point.y = j; 
-                point.l = minEigen; 
+    // Il vettore L che andiamo a creare è del tipo HarrisCorner, una struttura che conserva 
+    // specifiche informazioni, quali le coordinate x, y e la risposta di quel pixel in quella 
+    // posizione; ogni banda di ogni livello riempie la sua parte. 
+    vector<HarrisCorner> L;
+    BandedResponse(levels, options, nullptr, upper, &L); 
 
-                // Poi inseriamo il punto all'interno del vettore dei punti. 
-                L.push_back(point); 
-            }
-        }
+    IPA_TRACE_SCOPE("HarrisSuppression", L.size()); 
+
+    // Andiamo a sfoltire i punti che si trovano in un intorno ben preciso, 
+    // quello cioè definito dalla grandezza della finestra (wSize) utilizzata 
+    // per il calcolo degli elementi della matrice M, se nelle opzioni non è 
+    // indicato un altro raggio. 
+    int radius = options.suppressionRadius >= 0 ? options.suppressionRadius : wSize; 
+    return SuppressCorners(L, levels[0].rows, levels[0].cols, radius, options.maxCorners); 
+}
+
+vector<HarrisCorner> DetectHarrisCorners(const Mat& src, const Mat& Ix, const Mat& Iy, int upper, const HarrisOptions& options) {
+    IPA_TRACE_SCOPE("HarrisCornerDetector", src.total()); 
+    CheckWindow(options); 
+    if(src.size() != Ix.size()) {
+        throw invalid_argument("the derivatives of the Harris detector must have the size of the image"); 
+    }
+    return DetectCorners({{DerivativeProducts(Ix, Iy), Ix.rows, Ix.cols, 0}}, upper, options); 
+}
+
+vector<HarrisCorner> DetectHarrisCorners(const Mat& src, int upper, const HarrisOptions& options) {
+    CheckWindow(options); 
+    if(options.levels > 1) {
+        ImagePyramid pyramid(src, options.levels); 
+        return DetectHarrisCorners(pyramid, upper, options); 
     }
 
-    // Si deve ordinare il vettore in modo decrescente in base all'autovalore, in modo che si possa 
-    // scandagliare la lista dall'inizio alla fine. 
-    sort(L.begin(), L.end(), [](const PPoint& point1, const PPoint& point2) { return point1.l > point2.l; }); 
+    IPA_TRACE_SCOPE("HarrisCornerDetector", src.total()); 
+    return DetectCorners({{ImageProducts(src, options), src.rows, src.cols, 0}}, upper, options); 
+}
+
+vector<HarrisCorner> DetectHarrisCorners(ImagePyramid& pyramid, int upper, const HarrisOptions& options) {
+    IPA_TRACE_SCOPE("HarrisCornerDetector", pyramid.Level(0).total()); 
+    CheckWindow(options); 
+
+    // I livelli vengono costruiti (o presi dalla piramide, se ci sono già) 
+    // prima di dividerli in bande. 
+    vector<ResponseLevel> levels; 
+    for(int k = 0; k < pyramid.Levels(); k++) {
+        const Mat& level = pyramid.Level(k); 
+        levels.push_back({ImageProducts(level, options), level.rows, level.cols, k}); 
+    }
+    return DetectCorners(levels, upper, options); 
+}
+
+Mat DrawHarrisCorners(const Mat& src, const vector<HarrisCorner>& corners) {
+    IPA_TRACE_SCOPE("DrawHarrisCorners", src.total()); 
 
     // Cloniamo l'immagine iniziale per poter restituire l'immagine di destinazione con i 
     // contorni evidenziati con dei cerchi. 
     Mat dest = src.clone();
 	
     // Ci occorre per convertire l'immagine di destinazione a colori. 
-    cvtColor(dest, dest, COLOR_GRAY2BGR);
+    if(dest.channels() == 1) {
+        cvtColor(dest, dest, COLOR_GRAY2BGR);
+    }
 
-    // Andiamo a sfoltire i punti che si trovano in un intorno ben preciso, 
-    // quello cioè definito dalla grandezza della finestra (wSize) utilizzata 
-    // per il calcolo degli elementi della matrice M. 
-	for(int i = 0; i < L.size(); i++) {
-        for(int j = i+1; j < L.size(); j++) {
-            if(L.at(j).x <= L.at(i).x+wSize && L.at(j).x >= L.at(i).x-wSize && L.at(j).y <= L.at(i).y+wSize && L.at(j).y >= L.at(i).y-wSize) {
-                // Impostiamo a zero tutti i parametri del punto nel caso in cui si trovi all'interno 
-                // del range che abbiamo definito di dimensione pari a wSize. 
-                L.at(j).x = 0; 
-                L.at(j).y = 0; 
-                L.at(j).l = 0; 
-            }
-        }
-	}
-
-    // Andiamo a selezionare i punti dalla lista per poter cerchiare gli 
-    // angoli dell'immagine, se i parametri del punto sono diversi da 0, 
-    // allora quello è un punto da disegnare. 
-    for(int i = 0; i < L.size(); i++) {
-        if(L.at(i).x != 0 && L.at(i).y != 0 && L.at(i).l != 0) {
-            circle(dest, Point(L.at(i).y, L.at(i).x), 5, Scalar(0, 0, 255), 1, 4, 0);
-        }
+    // Andiamo a cerchiare gli angoli dell'immagine rimasti dopo la soppressione, con 
+    // un cerchio più grande per quelli trovati sui livelli più piccoli della piramide. 
+    for(const HarrisCorner& corner : corners) {
+        circle(dest, Point(corner.y, corner.x), 5 << corner.level, Scalar(0, 0, 255), 1, 4, 0);
     }
 
     // Alla fine restituiamo l'immagine finale. 
     return dest; 
 }
 
-int main(int argc, char *argv[]) {
-    // Leggiamo l'immagine da riga di comando. 
-    string inputFile = argv[1];
-    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE); 
+Mat HarrisCornerDetector(Mat& src, Mat& Ix, Mat& Iy, int upper, const HarrisOptions& options) {
+    return DrawHarrisCorners(src, DetectHarrisCorners(src, Ix, Iy, upper, options)); 
+}
+
+Mat HarrisCornerDetector(Mat& src, int upper, const HarrisOptions& options) {
+    return DrawHarrisCorners(src, DetectHarrisCorners(src, upper, options)); 
+}
+
+// Il file binario è composto dall'intestazione "HRSC", dal numero dei punti 
+// (uint32) e dai punti, ognuno con x e y (int32), la risposta (float) ed il 
+// livello (int32), nell'ordine dei byte della CPU. 
+static const char cornerMagic[4] = {'H', 'R', 'S', 'C'}; 
+
+void WriteHarrisCorners(const string& file, const vector<HarrisCorner>& corners, CornerFileFormat format) {
+    ofstream stream(file, format == CornerFileFormat::Binary ? ios::binary : ios::out); 
+    if(!stream) {
+        throw runtime_error("cannot write " + file); 
+    }
+
+    if(format == CornerFileFormat::Csv) {
+        stream << "x,y,response,level\n" << setprecision(9); 
+        for(const HarrisCorner& corner : corners) {
+            stream << corner.x << ',' << corner.y << ',' << corner.response << ',' << corner.level << '\n'; 
+        }
+    } else {
+        uint32_t count = static_cast<uint32_t>(corners.size()); 
+        stream.write(cornerMagic, sizeof(cornerMagic)); 
+        stream.write(reinterpret_cast<const char*>(&count), sizeof(count)); 
+        for(const HarrisCorner& corner : corners) {
+            int32_t position[2] = {corner.x, corner.y}; 
+            stream.write(reinterpret_cast<const char*>(position), sizeof(position)); 
+            int32_t level = corner.level; 
+            stream.write(reinterpret_cast<const char*>(&corner.response), sizeof(corner.response)); 
+            stream.write(reinterpret_cast<const char*>(&level), sizeof(level)); 
+        }
+    }
 
-    // Visualizziamo l'immagine originale. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE); 
-    imshow("Original Image", inputImage); 
+    if(!stream.flush()) {
+        throw runtime_error("cannot write " + file); 
+    }
+}
 
-    // Applichiamo il filtro di Sobel per poter calcolare le derivate parziali. 
-    pair<Mat, Mat> sobelFilter = SobelFilter(inputImage);
-    Mat Ix = GaussianFilter(sobelFilter.first, atoi(argv[2]), atoi(argv[3])); 
-    Mat Iy = GaussianFilter(sobelFilter.second, atoi(argv[2]), atoi(argv[3]));  
+vector<HarrisCorner> ReadHarrisCorners(const string& file) {
+    ifstream stream(file, ios::binary); 
+    char magic[4]; 
+    uint32_t count = 0; 
+    if(!stream.read(magic, sizeof(magic)) || memcmp(magic, cornerMagic, sizeof(magic)) != 0 || !stream.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        throw runtime_error(file + " is not a binary file of Harris corners"); 
+    }
 
-    // Applichiamo l'algoritmo di Harris per trovare gli spigoli dell'immagine.  
-    Mat harrisCornerDetector = HarrisCornerDetector(inputImage, Ix, Iy, atoi(argv[4])); 
-    namedWindow("Harris Image", WINDOW_AUTOSIZE); 
-    imshow("Harris Image", harrisCornerDetector); 
+    vector<HarrisCorner> corners; 
+    for(uint32_t k = 0; k < count; k++) {
+        int32_t position[2]; 
+        int32_t level; 
+        HarrisCorner corner; 
+        if(!stream.read(reinterpret_cast<char*>(position), sizeof(position)) || !stream.read(reinterpret_cast<char*>(&corner.response), sizeof(corner.response)) || !stream.read(reinterpret_cast<char*>(&level), sizeof(level))) {
+            throw runtime_error(file + " is truncated after " + to_string(k) + " corners"); 
+        }
+        corner.x = position[0]; 
+        corner.y = position[1]; 
+        corner.level = level; 
+        corners.push_back(corner); 
+    }
+    return corners; 
+}
 
-    waitKey(0); 
+// La risposta della riga i usa le righe i-radius..i+windowSize+1+radius 
+// dell'immagine (radius è quello del filtro Gaussiano), più una per le righe 
+// che SobelFilter lascia a 0 in fondo all'immagine: una riga cambiata cambia 
+// quindi le risposte delle haloBefore righe sopra di lei e delle haloAfter 
+// righe sotto, e lo stesso vale per le colonne. 
+IncrementalHarris::IncrementalHarris(int upper, const HarrisOptions& options, int tileSize, int changeThreshold) : upper(upper), options(options), tileSize(tileSize), changeThreshold(changeThreshold) {
+    CheckWindow(options); 
+    if(options.levels != 1) {
+        throw invalid_argument("IncrementalHarris works on one level only: " + to_string(options.levels)); 
+    }
+    if(tileSize < 1) {
+        throw invalid_argument("the tiles of IncrementalHarris must be at least 1 pixel: " + to_string(tileSize)); 
+    }
+    int radius = 0; 
+    if(options.gaussianSize > 0) {
+        radius = MakeGaussianKernel(options.gaussianSize, options.gaussianSigma).size/2; 
+    }
+    this->haloBefore = options.windowSize + 2 + radius; 
+    this->haloAfter = radius; 
+
+    // I tile vengono ricalcolati in parallelo, ognuno su un thread solo. 
+    int maxThreads = options.threads > 0 ? options.threads : DefaultThreadCount(); 
+    if(maxThreads > 1) {
+        this->pool.reset(new ThreadPool(maxThreads)); 
+    }
+    this->options.threads = 1; 
+}
+
+const vector<HarrisCorner>& IncrementalHarris::Update(const Mat& frame) {
+    IPA_TRACE_SCOPE("IncrementalHarris", frame.total()); 
+
+    if(frame.type() != CV_8UC1) {
+        throw invalid_argument("IncrementalHarris needs CV_8UC1 frames: type " + to_string(frame.type())); 
+    }
+
+    int rows = frame.rows; 
+    int cols = frame.cols; 
+    int T = this->tileSize; 
+    bool first = this->reference.size() != frame.size() || this->reference.empty(); 
+    if(first) {
+        this->reference = frame.clone(); 
+        this->response = Mat::zeros(rows, cols, CV_32FC1); 
+        this->tileRows = (rows + T - 1) / T; 
+        this->tileCols = (cols + T - 1) / T; 
+        this->tileCandidates.assign(static_cast<size_t>(this->tileRows) * this->tileCols, vector<HarrisCorner>()); 
+    }
+
+    // La maschera dei tile cambiati, che vengono copiati nel frame di 
+    // riferimento, e quella dei tile da ricalcolare: quelli che si 
+    // sovrappongono alle righe e alle colonne delle risposte che dipendono 
+    // da un tile cambiato. 
+    vector<char> recompute(this->tileCandidates.size(), first ? 1 : 0); 
+    for(int ty = 0; ty < this->tileRows && !first; ty++) {
+        for(int tx = 0; tx < this->tileCols; tx++) {
+            int r0 = ty*T, r1 = min(rows, r0+T); 
+            int c0 = tx*T, c1 = min(cols, c0+T); 
+            bool changed = false; 
+            for(int i = r0; i < r1 && !changed; i++) {
+                const uchar* now = frame.ptr<uchar>(i) + c0; 
+                const uchar* before = this->reference.ptr<uchar>(i) + c0; 
+                if(this->changeThreshold <= 0) {
+                    changed = memcmp(now, before, c1-c0) != 0; 
+                    continue; 
+                }
+                for(int j = 0; j < c1-c0 && !changed; j++) {
+                    changed = abs(now[j] - before[j]) > this->changeThreshold; 
+                }
+            }
+            if(!changed) {
+                continue; 
+            }
+
+            frame(Range(r0, r1), Range(c0, c1)).copyTo(this->reference(Range(r0, r1), Range(c0, c1))); 
+            int fromY = max(0, r0 - this->haloBefore) / T; 
+            int toY = min(rows-1, r1-1 + this->haloAfter) / T; 
+            int fromX = max(0, c0 - this->haloBefore) / T; 
+            int toX = min(cols-1, c1-1 + this->haloAfter) / T; 
+            for(int y = fromY; y <= toY; y++) {
+                for(int x = fromX; x <= toX; x++) {
+                    recompute[static_cast<size_t>(y) * this->tileCols + x] = 1; 
+                }
+            }
+        }
+    }
+
+    vector<int> dirty; 
+    for(size_t t = 0; t < recompute.size(); t++) {
+        if(recompute[t]) {
+            dirty.push_back(static_cast<int>(t)); 
+        }
+    }
+    this->recomputedFraction = recompute.empty() ? 0 : static_cast<double>(dirty.size()) / recompute.size(); 
+    if(dirty.empty() && !first) {
+        return this->corners; 
+    }
+
+    int parts = this->pool ? min(this->pool->Size(), static_cast<int>(dirty.size())) : 1; 
+    for(int b = 0; b < parts; b++) {
+        auto job = [this, &dirty, b, parts] {
+            for(size_t k = b; k < dirty.size(); k += parts) {
+                this->RecomputeTile(dirty[k]); 
+            }
+        }; 
+        if(parts > 1) {
+            this->pool->Submit(job); 
+        } else {
+            job(); 
+        }
+    }
+    if(parts > 1) {
+        this->pool->Wait(); 
+    }
+
+    // La soppressione è globale (un punto tenuto può scartarne altri in una 
+    // catena che esce dall'alone), quindi viene rieseguita sui candidati di 
+    // tutti i tile, che non richiedono di rileggere l'immagine. 
+    IPA_TRACE_SCOPE("HarrisSuppression", rows); 
+    vector<HarrisCorner> L; 
+    for(const vector<HarrisCorner>& candidates : this->tileCandidates) {
+        L.insert(L.end(), candidates.begin(), candidates.end()); 
+    }
+    int radius = this->options.suppressionRadius >= 0 ? this->options.suppressionRadius : this->options.windowSize; 
+    this->corners = SuppressCorners(L, rows, cols, radius, this->options.maxCorners); 
+    return this->corners; 
+}
+
+// Ricalcola le risposte ed i candidati di un tile dal ritaglio del frame di 
+// riferimento con l'alone: ai bordi del ritaglio le derivate ed il filtro 
+// Gaussiano valgono 0 come ai bordi dell'immagine, ma solo nelle righe e 
+// nelle colonne dell'alone, che le risposte del tile non usano. 
+void IncrementalHarris::RecomputeTile(int tile) {
+    int rows = this->reference.rows; 
+    int cols = this->reference.cols; 
+    int wSize = this->options.windowSize; 
+    int T = this->tileSize; 
+    int r0 = (tile / this->tileCols) * T, r1 = min(rows, r0+T); 
+    int c0 = (tile % this->tileCols) * T, c1 = min(cols, c0+T); 
+    int cropRow = max(0, r0 - this->haloAfter); 
+    int cropCol = max(0, c0 - this->haloAfter); 
+    Mat crop = this->reference(Range(cropRow, min(rows, r1 + this->haloBefore)), Range(cropCol, min(cols, c1 + this->haloBefore))); 
+    Mat local = HarrisResponse(crop, this->options); 
+    local(Range(r0-cropRow, r1-cropRow), Range(c0-cropCol, c1-cropCol)).copyTo(this->response(Range(r0, r1), Range(c0, c1))); 
+
+    vector<HarrisCorner>& candidates = this->tileCandidates[tile]; 
+    candidates.clear(); 
+    for(int i = r0; i < min(r1, rows-wSize); i++) {
+        const float* row = this->response.ptr<float>(i); 
+        for(int j = c0; j < min(c1, cols-wSize); j++) {
+            if(row[j] > this->upper) {
+                HarrisCorner point; 
+                point.x = i; 
+                point.y = j; 
+                point.response = row[j]; 
+                candidates.push_back(point); 
+            }
+        }
+    }
+}
+
+const vector<HarrisCorner>& IncrementalHarris::Corners() const {
+    return this->corners; 
+}
+
+const Mat& IncrementalHarris::Response() const {
+    return this->response; 
+}
+
+double IncrementalHarris::RecomputedFraction() const {
+    return this->recomputedFraction; 
+}
 
-    return 0; 
+void IncrementalHarris::Reset() {
+    this->reference.release(); 
+    this->response.release(); 
+    this->tileCandidates.clear(); 
+    this->corners.clear(); 
+    this->recomputedFraction = 0; 
 }
@@ -0,0 +1,192 @@
+#ifndef HARRIS_CORNER_DETECTION_HPP
+#define HARRIS_CORNER_DETECTION_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "GaussianFilter.hpp"
+#include "ImagePyramid.hpp"
+#include "ThreadPool.hpp"
+
+// I passi dell'algoritmo di Harris: le derivate parziali vengono calcolate 
+// con Sobel, poi sono smussate con il filtro Gaussiano (GaussianFilter, in 
+// comune con Canny), ed infine vengono date in input al detector che 
+// restituisce l'immagine con gli spigoli. 
+std::pair<cv::Mat, cv::Mat> SobelFilter(cv::Mat& src);
+
+// La misura della risposta di un pixel, calcolata dalla matrice M delle 
+// derivate nella finestra: 
+// MinEigenvalue: il più piccolo autovalore di M (Shi-Tomasi); 
+// Harris:        det(M) - harrisK * trace(M)^2. 
+enum class HarrisMeasure {
+    MinEigenvalue, 
+    Harris, 
+}; 
+
+// Le derivate delle funzioni che partono dall'immagine: 
+// Absolute: i valori assoluti a 8 bit di SobelFilter, smussati con il 
+//           filtro Gaussiano (come nel programma di Harris); 
+// Signed:   le derivate con segno a 16 bit dell'immagine smussata con il 
+//           filtro Gaussiano (come SobelTensor di Sobel.hpp). 
+enum class HarrisDerivatives {
+    Absolute, 
+    Signed, 
+}; 
+
+// Le opzioni del detector: 
+// windowSize: il lato della finestra (a peso unitario) su cui vengono 
+//             sommati i prodotti delle derivate; il costo per pixel non 
+//             dipende dalla dimensione della finestra; 
+// measure:    la misura della risposta, con harrisK per quella di Harris; 
+// suppressionRadius: 
+//             un punto viene scartato se un punto con risposta maggiore è 
+//             entro questo numero di righe e di colonne (se negativo, 
+//             windowSize); 
+// maxCorners: se positivo, il numero massimo di punti restituiti, quelli 
+//             con la risposta più alta dopo la soppressione; 
+// derivatives, gaussianSize, gaussianSigma: 
+//             solo per le funzioni che partono dall'immagine, le derivate ed 
+//             il filtro Gaussiano (nessuno se gaussianSize è 0); 
+// levels:     solo per DetectHarrisCorners dall'immagine, il numero dei 
+//             livelli di una ImagePyramid su cui cercare i punti (1, solo 
+//             l'immagine, se non indicato): le risposte di tutti i livelli 
+//             vengono calcolate in parallelo con la stessa finestra e lo 
+//             stesso upper, ed i punti di tutti i livelli vengono soppressi 
+//             insieme, con un raggio che raddoppia ad ogni livello; 
+// threads:    le bande di righe vengono elaborate su threads thread (con 
+//             threads <= 0 uno per thread hardware); ogni banda calcola 
+//             tutti i passi sulle sue righe e su quelle dell'alone che le 
+//             servono, e il risultato non dipende dal numero dei thread. 
+struct HarrisOptions {
+    int windowSize = 3; 
+    HarrisMeasure measure = HarrisMeasure::MinEigenvalue; 
+    float harrisK = 0.04f; 
+    int suppressionRadius = -1; 
+    int maxCorners = 0; 
+    HarrisDerivatives derivatives = HarrisDerivatives::Signed; 
+    int gaussianSize = 0; 
+    float gaussianSigma = 1.0f; 
+    int levels = 1; 
+    int threads = 0; 
+}; 
+
+// La mappa delle risposte (CV_32FC1, della dimensione di Ix) delle derivate 
+// Ix e Iy (CV_8UC1, come quelle di SobelFilter, o CV_16SC1 con il segno, 
+// come quelle di SobelDerivatives in Sobel.hpp): il valore del pixel (i, j) è calcolato sulla finestra 
+// delle righe i..i+windowSize-1 e delle colonne j..j+windowSize-1, e vale 0 
+// dove la finestra non sta nell'immagine (per i >= rows-windowSize o 
+// j >= cols-windowSize). 
+cv::Mat HarrisResponse(const cv::Mat& Ix, const cv::Mat& Iy, const HarrisOptions& options = HarrisOptions()); 
+
+// La mappa delle risposte calcolata direttamente dall'immagine (CV_8UC1), con 
+// le derivate di options.derivatives: con Signed le derivate con segno ed i 
+// loro prodotti vengono calcolati in un solo passaggio, senza troncarli a 
+// 8 bit, e il pixel (i, j) usa le righe i..i+windowSize+1 dell'immagine 
+// smussata. 
+cv::Mat HarrisResponse(const cv::Mat& src, const HarrisOptions& options = HarrisOptions()); 
+
+// Un punto trovato dal detector: la riga x, la colonna y (del vertice in 
+// alto a sinistra della finestra, come nella mappa delle risposte, sempre in 
+// pixel dell'immagine intera), la risposta ed il livello della piramide su 
+// cui è stato trovato (0 per l'immagine intera; le coordinate di un punto 
+// del livello k sono quelle del livello moltiplicate per 2^k). 
+struct HarrisCorner {
+    int x; 
+    int y; 
+    float response; 
+    int level = 0; 
+}; 
+
+// I punti con risposta maggiore di upper rimasti dopo la soppressione, in 
+// ordine di risposta decrescente, senza disegnarli: dalle derivate Ix e Iy, 
+// come HarrisResponse (della dimensione di src, altrimenti viene lanciata 
+// std::invalid_argument), o dall'immagine src. 
+std::vector<HarrisCorner> DetectHarrisCorners(const cv::Mat& src, const cv::Mat& Ix, const cv::Mat& Iy, int upper, const HarrisOptions& options = HarrisOptions()); 
+std::vector<HarrisCorner> DetectHarrisCorners(const cv::Mat& src, int upper, const HarrisOptions& options = HarrisOptions()); 
+
+// I punti di tutti i livelli di una piramide (options.levels non viene 
+// usato): i livelli già costruiti vengono riusati, quindi la stessa 
+// piramide può servire a più ricerche. 
+std::vector<HarrisCorner> DetectHarrisCorners(ImagePyramid& pyramid, int upper, const HarrisOptions& options = HarrisOptions()); 
+
+// Una copia a colori di src con un cerchio rosso intorno ad ogni punto, di 
+// raggio 5*2^level. 
+cv::Mat DrawHarrisCorners(const cv::Mat& src, const std::vector<HarrisCorner>& corners); 
+
+// I formati dei file dei punti: 
+// Binary: l'intestazione "HRSC", il numero dei punti (uint32), poi per ogni 
+//         punto x e y (int32), la risposta (float) ed il livello (int32), 
+//         nell'ordine dei byte della CPU (little endian su x86); 
+// Csv:    una riga "x,y,response,level" seguita da una riga per punto, con le 
+//         risposte scritte con le 9 cifre che bastano a rileggerle esatte. 
+enum class CornerFileFormat {
+    Binary, 
+    Csv, 
+}; 
+
+// Scrive i punti nel file, e legge quelli di un file binario; lanciano 
+// std::runtime_error se il file non può essere scritto o letto. 
+void WriteHarrisCorners(const std::string& file, const std::vector<HarrisCorner>& corners, CornerFileFormat format); 
+std::vector<HarrisCorner> ReadHarrisCorners(const std::string& file); 
+
+// I punti di DetectHarrisCorners disegnati con DrawHarrisCorners. 
+cv::Mat HarrisCornerDetector(cv::Mat& src, cv::Mat& Ix, cv::Mat& Iy, int upper, const HarrisOptions& options = HarrisOptions());
+
+// Il detector sulle derivate dell'immagine src (come HarrisResponse 
+// dall'immagine): con HarrisDerivatives::Absolute dà gli stessi punti di 
+// SobelFilter e GaussianFilter seguiti dall'altro HarrisCornerDetector, ma 
+// tutti i passi vengono eseguiti in parallelo sulle bande. 
+cv::Mat HarrisCornerDetector(cv::Mat& src, int upper, const HarrisOptions& options = HarrisOptions()); 
+
+// Il detector per una sequenza di frame della stessa dimensione (ad esempio 
+// di una telecamera fissa), che ricalcola solo le parti cambiate. Tiene il 
+// frame precedente, la sua mappa delle risposte ed i suoi candidati, divisi 
+// in tile di tileSize x tileSize pixel: per ogni nuovo frame un tile è 
+// cambiato se almeno un suo pixel differisce di più di changeThreshold da 
+// quello del frame precedente, e vengono ricalcolati (derivate, filtro 
+// Gaussiano, risposte e candidati, in parallelo su options.threads thread) 
+// solo i tile le cui risposte dipendono da un tile cambiato, con il loro 
+// alone. La soppressione viene rieseguita sui candidati di tutti i tile, 
+// quindi i punti sono quelli di DetectHarrisCorners sul frame, in cui i tile 
+// non cambiati (con changeThreshold > 0) restano quelli dei frame precedenti. 
+// Un frame di dimensione diversa ricomincia da capo. Lavora su un livello 
+// solo (options.levels deve essere 1). 
+class IncrementalHarris {
+    public: 
+    IncrementalHarris(int upper, const HarrisOptions& options = HarrisOptions(), int tileSize = 64, int changeThreshold = 0); 
+
+    // Elabora un frame (CV_8UC1) e restituisce i suoi punti. 
+    const std::vector<HarrisCorner>& Update(const cv::Mat& frame); 
+
+    // I punti e la mappa delle risposte dell'ultimo frame. 
+    const std::vector<HarrisCorner>& Corners() const; 
+    const cv::Mat& Response() const; 
+
+    // La frazione dei tile ricalcolati per l'ultimo frame (1 per il primo). 
+    double RecomputedFraction() const; 
+
+    // Dimentica il frame precedente. 
+    void Reset(); 
+
+    private: 
+    void RecomputeTile(int tile); 
+
+    int upper; 
+    HarrisOptions options; 
+    int tileSize; 
+    int changeThreshold; 
+    int haloBefore = 0; 
+    int haloAfter = 0; 
+    int tileRows = 0; 
+    int tileCols = 0; 
+    double recomputedFraction = 0; 
+    cv::Mat reference; 
+    cv::Mat response; 
+    std::vector<std::vector<HarrisCorner>> tileCandidates; 
+    std::vector<HarrisCorner> corners; 
+    std::unique_ptr<ThreadPool> pool; 
+}; 
+
+#endif
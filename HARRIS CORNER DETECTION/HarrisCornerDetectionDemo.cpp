@@ -0,0 +1,34 @@
+#include <iostream>
+#include <cstdio>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "HarrisCornerDetection.hpp"
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    // Leggiamo l'immagine da riga di comando. 
+    string inputFile = argv[1];
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE); 
+
+    // Visualizziamo l'immagine originale. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage); 
+
+    // Applichiamo il filtro di Sobel per poter calcolare le derivate parziali. 
+    pair<Mat, Mat> sobelFilter = SobelFilter(inputImage);
+    Mat Ix = GaussianFilter(sobelFilter.first, atoi(argv[2]), atoi(argv[3])); 
+    Mat Iy = GaussianFilter(sobelFilter.second, atoi(argv[2]), atoi(argv[3]));  
+
+    // Applichiamo l'algoritmo di Harris per trovare gli spigoli dell'immagine.  
+    Mat harrisCornerDetector = HarrisCornerDetector(inputImage, Ix, Iy, atoi(argv[4])); 
+    namedWindow("Harris Image", WINDOW_AUTOSIZE); 
+    imshow("Harris Image", harrisCornerDetector); 
+
+    waitKey(0); 
+
+    return 0; 
+}
@@ -0,0 +1,11 @@
+#ifndef HOUGH_TRANSFORMATION_CIRCLE_HPP
+#define HOUGH_TRANSFORMATION_CIRCLE_HPP
+
+#include <opencv2/opencv.hpp>
+
+// La trasformata di Hough per i cerchi prende in input l'immagine dei 
+// contorni (ottenuta con Canny), l'immagine sulla quale disegnare i 
+// cerchi trovati, il threshold e il range dei raggi da considerare. 
+cv::Mat HoughTransformation(cv::Mat src, cv::Mat rst, int thr, int rmax, int rmin); 
+
+#endif
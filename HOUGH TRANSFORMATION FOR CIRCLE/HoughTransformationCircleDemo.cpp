@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "HoughTransformationCircle.hpp"
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    // Si prende in input il nome dell'immagine da riga di comando, 
+    // e la si legge con i colori. In seguito la cloniamo per darla 
+    // in input alla funzione. 
+    String inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_ANYCOLOR); 
+    Mat clonedImage = inputImage.clone(); 
+
+    // Si mostra l'immagine all'interno di un'apposita finestra. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE);
+    imshow("Original Image", inputImage); 
+
+    // Prima di dare in pasto l'immagine all'algoritmo di Hough per 
+    // la ricerca di cerchi, applichiamo uno smoothing per migliorare 
+    // la ricerca delle circonferenze. In questo caso applichiamo il 
+    // filtro Gaussiano con una maschera di dimensioni 5x5 e una 
+    // deviazione standard pari a 1.5. Poi applichiamo su di essa 
+    // l'algoritmo di Canny per trovare i bordi degli oggetti all'interno 
+    // dell'immagine in modo tale che risulti essere più semplice trovare 
+    // le circonferenze all'interno dell'immagine dato che ci soffermiamo 
+    // solo su punti salienti che hanno un particolare valore. 
+    Mat cannyImage = inputImage.clone(); 
+    GaussianBlur(inputImage, inputImage, Size(5, 5), 1.5, 1.5); 
+    Canny(inputImage, cannyImage, 80, 150, 3); 
+
+    // Mostriamo il risultato dell'algoritmo di Canny in un'apposita finestra. 
+    namedWindow("Canny Image", WINDOW_AUTOSIZE);
+    imshow("Canny Image", cannyImage);
+
+    // Prendiamo in input il threshold e i due raggi, uno massimo e uno minimo.
+    int threshold = atoi(argv[2]); 
+    int rmax = atoi(argv[3]); 
+    int rmin = atoi(argv[4]); 
+
+    // Applichiamo sull'immagine risultante da Canny l'algoritmo di Hough per la 
+    // ricerca di cerchi, dando in input anche l'immagine originale clonata 
+    // ed il valore di threshold e quello dei due raggi. 
+    Mat resultImage = HoughTransformation(cannyImage, clonedImage, threshold, rmax, rmin); 
+
+    // Alla fine si mostra il risultato dell'algoritmo in un'apposita immagine. 
+    namedWindow("Hough Image", WINDOW_AUTOSIZE);
+    imshow("Hough Image", resultImage);
+
+    waitKey(0); 
+
+    return 0; 
+}
\ No newline at end of file
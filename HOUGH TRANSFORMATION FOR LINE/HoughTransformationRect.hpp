@@ -0,0 +1,11 @@
+#ifndef HOUGH_TRANSFORMATION_RECT_HPP
+#define HOUGH_TRANSFORMATION_RECT_HPP
+
+#include <opencv2/opencv.hpp>
+
+// La trasformata di Hough per le rette prende in input l'immagine dei 
+// contorni (ottenuta con Canny), l'immagine sulla quale disegnare le 
+// rette trovate ed il threshold per la matrice dei voti. 
+cv::Mat HoughTransformation(cv::Mat src, cv::Mat rst, int thr); 
+
+#endif
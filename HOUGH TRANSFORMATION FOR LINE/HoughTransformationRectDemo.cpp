@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "HoughTransformationRect.hpp"
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    // Si prende in input da riga di comando l'immagine sulla quale 
+    // applicare l'algoritmo. Questa immagine originale viene clonata 
+    // in una nuova immagine sulla quale saranno disegnate le rette.
+    String inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE); 
+    Mat clonedImage = inputImage.clone(); 
+
+    // Si mostra l'immagine originale in una apposita finestra. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage); 
+
+    // Per poter ottenere un risultato ottimale bisogna applicare un filtro 
+    // di smoothing all'immagine, come quello di Gauss, che in questo caso è 
+    // applicato con una maschera di dimensione 5x5 e con una deviazione 1.4. 
+    // Sul risultato del blurring applichiamo l'algoritmo di Canny per poter 
+    // trovare i contorni dell'immagine, facilitando il nostro algoritmo. 
+    Mat cannyImage = inputImage.clone(); 
+    GaussianBlur(inputImage, inputImage, Size(5, 5), 1.4, 1.4); 
+    Canny(inputImage, cannyImage, 60, 160, 3); 
+
+    // L'immagine risultante dall'applicazione di Canny viene mostrata in 
+    // una finestra apposita. 
+    namedWindow("Canny Edge Detector Image", WINDOW_AUTOSIZE); 
+    imshow("Canny Edge Detector Image", cannyImage); 
+    
+    // Alla fine si applica l'algoritmo di Hough per poter trovare le 
+    // rette all'interno dell'immagine derivata da Canny. 
+    int threshold = atoi(argv[2]);
+    Mat resultImage = HoughTransformation(cannyImage, clonedImage, threshold); 
+
+    // Viene mostrato il risultato finale. 
+    namedWindow("Hough Transformation Image", WINDOW_AUTOSIZE); 
+    imshow("Hough Transformation Image", resultImage);  
+
+    waitKey(0); 
+
+    return 0; 
+}
\ No newline at end of file
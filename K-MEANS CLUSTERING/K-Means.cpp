@@ -1,165 +1,934 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <math.h>
 #include <opencv2/opencv.hpp>
+#include "CpuDispatch.hpp"
+#include "K-Means.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
 
 using namespace std; 
 using namespace cv; 
 
+// Le somme delle componenti dei pixel assegnati ad un Cluster, dei loro 
+// quadrati (per l'inerzia) e il loro numero. Ogni banda di righe dell'immagine accumula le proprie somme 
+// parziali, che vengono poi sommate a quelle del Cluster alla fine 
+// dell'iterazione; servono 64 bit per le immagini più grandi. 
+struct ClusterSums {
+    int64_t sumB = 0; 
+    int64_t sumG = 0; 
+    int64_t sumR = 0; 
+    int64_t sumSquares = 0; 
+    int64_t pixelNum = 0; 
+}; 
+
 // La classe Cluster tiene traccia di tutte le informazioni relative ad 
 // un particolare Cluster, in particolare: 
-// 1. La lista dei pixel che sono in esso contenuti; 
-// 2. Il centroide attuale del Cluster; 
-// 3. Il numero dei pixel che sono in esso inseriti; 
-// 4. Le variabili intere per la sommatoria delle componenti dell'oggetto 
+// 1. Il centroide attuale del Cluster; 
+// 2. Il numero dei pixel che sono in esso inseriti; 
+// 3. Le variabili intere per la sommatoria delle componenti dell'oggetto 
 //    Vec3b per il calcolo del nuovo centroide; 
+// I pixel del Cluster non vengono elencati: l'etichetta di ogni pixel è 
+// nella mappa delle etichette di K_Means. 
 class Cluster {
     public: 
-    vector<Point> pixelsCoordsList;
     Vec3b clusterCentroyd;  
-    int pixelNum = 1;
+    int64_t pixelNum = 0;
 
-    int sumB = 0; 
-    int sumG = 0; 
-    int sumR = 0; 
+    int64_t sumB = 0; 
+    int64_t sumG = 0; 
+    int64_t sumR = 0; 
 
     Cluster() {} 
 
-    // Il metodo InsertPixel(...) prende in input le coordinate del punto da 
-    // inserire all'interno del Cluster e l'oggetto Vec3b dello stesso pixel
-    // in modo tale da poter sommare le sue componenti con quelle degli altri 
-    // pixel ivi contenuti. Le coordinate dei pixel che compongono il Cluster 
-    // sono gestiti in una apposita lista, e contestualmente si aumenta il 
-    // contatore dei pixel che sono contenuti nella regione. 
-    void InsertPixel(int x, int y, Vec3b currentPixel3b) {
-        this->pixelsCoordsList.push_back(Point(x, y));
-
-        this->sumB += currentPixel3b.val[0]; 
-        this->sumG += currentPixel3b.val[1]; 
-        this->sumR += currentPixel3b.val[2]; 
+    // Il metodo InsertPixels(...) somma alle componenti del Cluster quelle 
+    // dei pixel di una banda dell'immagine, e aumenta il contatore dei pixel 
+    // che sono contenuti nella regione. 
+    void InsertPixels(const ClusterSums& sums) {
+        this->sumB += sums.sumB; 
+        this->sumG += sums.sumG; 
+        this->sumR += sums.sumR; 
 
-        this->pixelNum++; 
+        this->pixelNum += sums.pixelNum; 
     }
 
     // Il metodo SetCentroyd(...) ricalcola il centroide della regione che è dato 
     // dalla media ottenuta semplicemente come la somma di tutte le componenti dei 
     // pixel diviso il numero di pixel, e questo per tutte e tre i canali del punto. 
+    // Un Cluster senza pixel tiene il centroide che aveva. 
     void SetCentroyd() {
-        Vec3b newCentroyd;
+        if(this->pixelNum > 0) {
+            Vec3b newCentroyd;
 
-        newCentroyd.val[0] = this->sumB/this->pixelNum;
-        newCentroyd.val[1] = this->sumG/this->pixelNum;
-        newCentroyd.val[2] = this->sumR/this->pixelNum;
+            newCentroyd.val[0] = static_cast<uchar>(this->sumB/this->pixelNum);
+            newCentroyd.val[1] = static_cast<uchar>(this->sumG/this->pixelNum);
+            newCentroyd.val[2] = static_cast<uchar>(this->sumR/this->pixelNum);
 
-        // Il nuovo centroide va a sostituire il precedente centroide della regione. 
-        this->clusterCentroyd = newCentroyd;
+            // Il nuovo centroide va a sostituire il precedente centroide della regione. 
+            this->clusterCentroyd = newCentroyd;
+        }
 
         // Tutte le variabili di lavoro vengono resettate per le successive iterazioni. 
-        this->pixelNum = 1; 
+        this->pixelNum = 0; 
         this->sumB = 0; 
         this->sumG = 0; 
         this->sumR = 0; 
     }
 };
 
-Mat K_Means(Mat src, int k, int iterations, int thr); 
+// Gli spostamenti dei centroidi tra due iterazioni e le loro distanze, che 
+// servono ai limiti di Hamerly: shift è lo spostamento di ogni centroide, 
+// halfGap metà della distanza dal centroide più vicino, e maxShift e 
+// secondMaxShift i due spostamenti più grandi (il primo del centroide 
+// maxShiftIndex). I limiti sono float: il margine boundMargin, aggiunto 
+// agli spostamenti e tolto alle distanze, li tiene validi nonostante gli 
+// arrotondamenti. 
+struct CentroydGeometry {
+    vector<float> shift; 
+    vector<float> halfGap; 
+    int maxShiftIndex = 0; 
+    float maxShift = 0; 
+    float secondMaxShift = 0; 
+}; 
 
-// Gli input della funzione K_Means sono l'immagine originale, il numero 
-// di Cluster da creare, il numero di iterazioni da effettuare ed il numero 
-// relativo al threshold con il quale confrontare la distanza tra il vecchio 
-// centroide della regione ed il nuovo ricalcolato nell'iterazione attuale. 
-Mat K_Means(Mat src, int k, int iterations, int thr) {
-    // I due vettori vengono utilizzati uno per i centroidi dei Cluster e 
-    // uno per i Cluster stessi dell'immagine. 
-    vector<Vec3b> centroyds; 
-    vector<Cluster> clusters; 
+static const float boundMargin = 1e-3f; 
 
-    int it = 0; 
-    bool breakable; 
+static float CentroydDistance(const Vec3b& a, const Vec3b& b) {
+    int d0 = a.val[0] - b.val[0]; 
+    int d1 = a.val[1] - b.val[1]; 
+    int d2 = a.val[2] - b.val[2]; 
+    return sqrt(static_cast<float>(d0*d0 + d1*d1 + d2*d2)); 
+}
 
-    // 1. Selezioniamo dall'immagine i primi centroidi dei cluster 
-    // in maniera random, vengono poi inseriti all'interno della 
-    // lista dei centroidi, mentre il Cluster appena creato viene 
-    // inserito all'interno della lista dei Cluster.  
-    for(int i = 0; i < k; i++) {
-        int randX = rand() % src.rows; 
-        int randY = rand() % src.cols; 
-        
-        Vec3b currentPixel = src.at<Vec3b>(randX, randY); 
-        Cluster currentCluster = Cluster(); 
+static CentroydGeometry MeasureCentroyds(const vector<Vec3b>& previous, const vector<Vec3b>& current) {
+    int k = static_cast<int>(current.size()); 
+    CentroydGeometry geometry; 
+    geometry.shift.resize(k); 
+    geometry.halfGap.assign(k, numeric_limits<float>::infinity()); 
 
-        centroyds.push_back(currentPixel); 
-        clusters.push_back(currentCluster); 
+    for(int x = 0; x < k; x++) {
+        geometry.shift[x] = CentroydDistance(previous[x], current[x]) + boundMargin; 
+        if(geometry.shift[x] > geometry.maxShift) {
+            geometry.secondMaxShift = geometry.maxShift; 
+            geometry.maxShift = geometry.shift[x]; 
+            geometry.maxShiftIndex = x; 
+        } else {
+            geometry.secondMaxShift = max(geometry.secondMaxShift, geometry.shift[x]); 
+        }
+
+        for(int y = 0; y < x; y++) {
+            float gap = CentroydDistance(current[x], current[y]) / 2 - boundMargin; 
+            geometry.halfGap[x] = min(geometry.halfGap[x], gap); 
+            geometry.halfGap[y] = min(geometry.halfGap[y], gap); 
+        }
     }
 
-    for(int it = 0; it < iterations; it++) {
-        // 2. Per tutti i punti dell'immagine dobbiamo trovare quei pixel
-        // che sono più vicini ad uno dei centroidi selezionati in precedenza.
-        // Per fare questo si scorre tutta l'immagine e per ogni pixel si 
-        // calcola la distanza da tutti i centroidi. Queste distanze vengono 
-        // inserite all'interno di una lista.  
+    return geometry; 
+}
+
+// L'assegnamento di un'iterazione, comune a tutte le bande: i centroidi come 
+// tre piani (blu, verde, rosso) di interi a 16 bit, se le etichette sono 
+// quelle dell'iterazione precedente (da cui si contano i punti che cambiano 
+// Cluster) e, con i limiti di Hamerly, la geometria dei centroidi (nullptr 
+// alla prima iterazione, che calcola i limiti con una ricerca completa). 
+struct Assignment {
+    const int16_t* centroydPlanes = nullptr; 
+    int k = 0; 
+    bool labelled = false; 
+    bool bounded = false; 
+    const CentroydGeometry* geometry = nullptr; 
+}; 
+
+// Le somme parziali dei Cluster di una banda, il numero delle distanze 
+// calcolate e di quelle evitate dai limiti di Hamerly, dei pixel che hanno 
+// cambiato Cluster, con i buffer di una riga, che vengono riutilizzati da 
+// un'iterazione all'altra. 
+struct BandResult {
+    vector<ClusterSums> sums; 
+    int64_t evaluations = 0; 
+    int64_t skipped = 0; 
+    int64_t reassigned = 0; 
+
+    vector<uchar> previousLabels; 
+
+    vector<int> pending; 
+    vector<uchar> pendingPoints; 
+    vector<uchar> pendingLabels; 
+    vector<int32_t> nearestDistances; 
+    vector<int32_t> secondDistances; 
+}; 
+
+static inline int SquaredDistance(const uchar* pixel, const int16_t* centroydPlanes, int k, int x) {
+    int dB = pixel[0] - centroydPlanes[x]; 
+    int dG = pixel[1] - centroydPlanes[k+x]; 
+    int dR = pixel[2] - centroydPlanes[2*k+x]; 
+    return dB*dB + dG*dG + dR*dR; 
+}
+
+// Assegna ognuno dei count punti BGR (pixel o colori, con il loro peso, 1 
+// senza weights) al centroide più vicino e accumula le somme dei Cluster. 
+// Senza limiti la distanza è quella Euclidea sulle tre componenti, ma basta 
+// confrontarne i quadrati (la radice non cambia il minimo): il kernel 
+// calcola per molti punti alla volta la distanza da tutti i centroidi e 
+// tiene il primo centroide a distanza minima. 
+// Con i limiti di Hamerly, bounds tiene per ogni punto un limite superiore 
+// della distanza dal suo centroide e uno inferiore della distanza da tutti 
+// gli altri. Quando la distanza dal proprio centroide è strettamente minore 
+// del limite inferiore, o di metà della distanza dal centroide più vicino, 
+// nessun altro centroide può essere più vicino (né alla pari) e la ricerca 
+// viene saltata: le etichette sono quelle dell'assegnamento completo. I 
+// punti rimasti vengono raccolti e cercati tutti insieme dal kernel, che 
+// restituisce anche le due distanze più piccole per i nuovi limiti. 
+static void AssignItems(const Assignment& assignment, const uchar* bgr, const int64_t* weights, int count, uchar* labels, float* bounds, BandResult& result) {
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    const int16_t* planes = assignment.centroydPlanes; 
+    int k = assignment.k; 
+
+    if(assignment.labelled) {
+        result.previousLabels.assign(labels, labels + count); 
+    }
+
+    if(!assignment.bounded) {
+        kernels.nearestCentroidRow(bgr, count, planes, k, labels); 
+        result.evaluations += static_cast<int64_t>(count) * k; 
+    } else {
+        vector<int>& pending = result.pending; 
+        pending.clear(); 
+
+        if(assignment.geometry) {
+            const CentroydGeometry& geometry = *assignment.geometry; 
+            for(int c = 0; c < count; c++) {
+                float& upper = bounds[2*c]; 
+                float& lower = bounds[2*c+1]; 
+                int label = labels[c]; 
+
+                upper += geometry.shift[label]; 
+                lower -= label == geometry.maxShiftIndex ? geometry.secondMaxShift : geometry.maxShift; 
+                float bound = max(geometry.halfGap[label], lower); 
+                if(upper < bound) {
+                    result.skipped += k; 
+                    continue; 
+                }
+
+                // Prima di cercare si stringe il limite superiore con la distanza vera. 
+                upper = sqrt(static_cast<float>(SquaredDistance(bgr + 3*c, planes, k, label))) + boundMargin; 
+                result.evaluations++; 
+                if(!(upper < bound)) {
+                    pending.push_back(c); 
+                } else {
+                    result.skipped += k - 1; 
+                }
+            }
+        } else {
+            pending.resize(count); 
+            for(int c = 0; c < count; c++) {
+                pending[c] = c; 
+            }
+        }
+
+        int found = static_cast<int>(pending.size()); 
+        result.pendingPoints.resize(3*static_cast<size_t>(found)); 
+        result.pendingLabels.resize(found); 
+        result.nearestDistances.resize(found); 
+        result.secondDistances.resize(found); 
+        for(int p = 0; p < found; p++) {
+            memcpy(&result.pendingPoints[3*p], bgr + 3*pending[p], 3); 
+        }
+
+        kernels.nearestTwoCentroidsRow(result.pendingPoints.data(), found, planes, k, result.pendingLabels.data(), result.nearestDistances.data(), result.secondDistances.data()); 
+        result.evaluations += static_cast<int64_t>(found) * k; 
+
+        for(int p = 0; p < found; p++) {
+            int c = pending[p]; 
+            labels[c] = result.pendingLabels[p]; 
+            bounds[2*c] = sqrt(static_cast<float>(result.nearestDistances[p])) + boundMargin; 
+            bounds[2*c+1] = k > 1 ? max(0.0f, sqrt(static_cast<float>(result.secondDistances[p])) - boundMargin) : numeric_limits<float>::infinity(); 
+        }
+    }
+
+    for(int c = 0; c < count; c++) {
+        const uchar* point = bgr + 3*c; 
+        int64_t weight = weights ? weights[c] : 1; 
+        ClusterSums& cluster = result.sums[labels[c]]; 
+        cluster.sumB += weight * point[0]; 
+        cluster.sumG += weight * point[1]; 
+        cluster.sumR += weight * point[2]; 
+        cluster.sumSquares += weight * (point[0]*point[0] + point[1]*point[1] + point[2]*point[2]); 
+        cluster.pixelNum += weight; 
+
+        if(!assignment.labelled || labels[c] != result.previousLabels[c]) {
+            result.reassigned += weight; 
+        }
+    }
+}
+
+// Assegna i pixel delle righe [firstRow, lastRow), scrivendo la mappa delle 
+// etichette (e dei limiti, con i limiti di Hamerly). 
+static void AssignBand(const Mat& src, Mat& labelMap, Mat& boundsMap, const Assignment& assignment, int firstRow, int lastRow, BandResult& result) {
+    result.sums.assign(assignment.k, ClusterSums()); 
+    result.evaluations = 0; 
+    result.skipped = 0; 
+    result.reassigned = 0; 
+
+    for(int i = firstRow; i < lastRow; i++) {
+        float* bounds = assignment.bounded ? boundsMap.ptr<float>(i) : nullptr; 
+        AssignItems(assignment, src.ptr<uchar>(i), nullptr, src.cols, labelMap.ptr<uchar>(i), bounds, result); 
+    }
+}
+
+// I colori distinti dell'immagine, quantizzati a bits bit per canale, con 
+// il numero dei pixel di ognuno. Ogni colore è la media dei pixel del suo 
+// bin (con 8 bit è il colore stesso), e binIndex dà per ogni bin 
+// dell'istogramma l'indice del suo colore in colors (3 byte BGR) e weights. 
+struct WeightedColors {
+    int bits = 8; 
+    vector<uint32_t> binIndex; 
+    vector<uchar> colors; 
+    vector<int64_t> weights; 
+}; 
+
+static inline uint32_t ColorBin(const uchar* pixel, int bits) {
+    int shift = 8 - bits; 
+    return static_cast<uint32_t>(pixel[0] >> shift) << (2*bits) | static_cast<uint32_t>(pixel[1] >> shift) << bits | static_cast<uint32_t>(pixel[2] >> shift); 
+}
+
+// Costruisce l'istogramma dei colori e lo compatta nella lista dei colori 
+// presenti. Il contatore di ogni bin diventa poi l'indice del suo colore; 
+// sotto gli 8 bit un secondo passaggio sui pixel somma le componenti dei 
+// pixel di ogni colore per calcolarne la media. 
+static WeightedColors CollectColors(const Mat& src, int bits) {
+    WeightedColors result; 
+    result.bits = bits; 
+    result.binIndex.assign(static_cast<size_t>(1) << (3*bits), 0); 
+
+    for(int i = 0; i < src.rows; i++) {
+        const uchar* row = src.ptr<uchar>(i); 
+        for(int j = 0; j < src.cols; j++) {
+            result.binIndex[ColorBin(row + 3*j, bits)]++; 
+        }
+    }
+
+    int shift = 8 - bits; 
+    for(uint32_t bin = 0; bin < result.binIndex.size(); bin++) {
+        if(result.binIndex[bin] == 0) {
+            continue; 
+        }
+        result.weights.push_back(result.binIndex[bin]); 
+        result.colors.push_back(static_cast<uchar>((bin >> (2*bits)) << shift)); 
+        result.colors.push_back(static_cast<uchar>(((bin >> bits) & ((1u << bits) - 1)) << shift)); 
+        result.colors.push_back(static_cast<uchar>((bin & ((1u << bits) - 1)) << shift)); 
+        result.binIndex[bin] = static_cast<uint32_t>(result.weights.size() - 1); 
+    }
+
+    if(bits < 8) {
+        vector<int64_t> sums(result.colors.size(), 0); 
         for(int i = 0; i < src.rows; i++) {
+            const uchar* row = src.ptr<uchar>(i); 
             for(int j = 0; j < src.cols; j++) {
-                vector<double> distances; 
-                Vec3b pixelValue = src.at<Vec3b>(i, j);
+                int64_t* sum = &sums[3*static_cast<size_t>(result.binIndex[ColorBin(row + 3*j, bits)])]; 
+                sum[0] += row[3*j]; 
+                sum[1] += row[3*j+1]; 
+                sum[2] += row[3*j+2]; 
+            }
+        }
+        for(size_t c = 0; c < result.colors.size(); c++) {
+            int64_t weight = result.weights[c/3]; 
+            result.colors[c] = static_cast<uchar>((sums[c] + weight/2) / weight); 
+        }
+    }
 
-                // 3. Per ognuno dei cluster calcoliamo la distanza che intercorre
-                // tra il punto in questione ed il centroide del cluster. 
-                for(int x = 0; x < k; x++) {
-                    Vec3b currentCentroyd = centroyds.at(x); 
+    return result; 
+}
+
+// Come AssignBand, per i colori [first, last) della lista dei colori: 
+// ogni colore conta nelle somme del suo Cluster con il suo peso. 
+static void AssignColors(const WeightedColors& colors, vector<uchar>& colorLabels, vector<float>& colorBounds, const Assignment& assignment, int first, int last, BandResult& result) {
+    result.sums.assign(assignment.k, ClusterSums()); 
+    result.evaluations = 0; 
+    result.skipped = 0; 
+    result.reassigned = 0; 
+
+    float* bounds = assignment.bounded ? colorBounds.data() + 2*static_cast<size_t>(first) : nullptr; 
+    AssignItems(assignment, colors.colors.data() + 3*static_cast<size_t>(first), colors.weights.data() + first, last - first, colorLabels.data() + first, bounds, result); 
+}
+
+// Esegue job(b, first, last) sulle parti [first, last) di count elementi, 
+// in parallelo sul pool quando ci sono più parti. 
+static void RunBands(ThreadPool* pool, int count, int parts, const function<void(int, int, int)>& job) {
+    for(int b = 0; b < parts; b++) {
+        int first = static_cast<int>(static_cast<int64_t>(count) * b / parts); 
+        int last = static_cast<int>(static_cast<int64_t>(count) * (b+1) / parts); 
+        if(parts > 1) {
+            pool->Submit([&job, b, first, last] {
+                job(b, first, last); 
+            }); 
+        } else {
+            job(b, first, last); 
+        }
+    }
+    if(parts > 1) {
+        pool->Wait(); 
+    }
+}
+
+// Inserisce nei Cluster le somme totali di un assegnamento e ricalcola i 
+// centroidi, scrivendo in stats l'inerzia e lo spostamento più grande; 
+// centroyds sono i centroidi con cui sono stati assegnati i pixel, e alla 
+// fine contiene i nuovi. Restituisce true se nessun centroide si è spostato 
+// più del threshold. 
+static bool UpdateCentroyds(const vector<ClusterSums>& totals, vector<Cluster>& clusters, vector<Vec3b>& centroyds, int thr, KMeansIterationStats& stats) {
+    int k = static_cast<int>(centroyds.size()); 
+
+    // L'inerzia (la somma dei quadrati delle distanze dei pixel dai centroidi 
+    // a cui sono stati assegnati) si ricava dalle somme: per ogni Cluster è 
+    // la somma dei quadrati dei pixel, meno due volte il prodotto scalare del 
+    // centroide con la somma dei pixel, più il numero dei pixel per il 
+    // quadrato del centroide. 
+    int64_t inertia = 0; 
+    for(int x = 0; x < k; x++) {
+        const ClusterSums& total = totals[x]; 
+        int64_t b = centroyds[x].val[0], g = centroyds[x].val[1], r = centroyds[x].val[2]; 
+        inertia += total.sumSquares - 2*(b*total.sumB + g*total.sumG + r*total.sumR) + total.pixelNum*(b*b + g*g + r*r); 
+        clusters[x].clusterCentroyd = centroyds[x]; 
+        clusters[x].InsertPixels(total); 
+    }
+    stats.inertia = static_cast<double>(inertia); 
+
+    // Per ognuno dei Cluster si deve ricalcolare il centroide essendo 
+    // adesso composti da una serie di pixel. Il centroide viene ricalcolato 
+    // con l'apposito metodo della funzione, e viene confrontato (in quanto a 
+    // distanza) con il vecchio centroide, quello con cui sono stati assegnati 
+    // i pixel. Se nessuno dei centroidi si è spostato più del threshold, 
+    // l'algoritmo è arrivato a convergenza e si deve fermare. 
+    bool breakable = true; 
+    for(int i = 0; i < k; i++) {
+        clusters.at(i).SetCentroyd(); 
+
+        // Si deve calcolare la distanza tra il vecchio centroide e quello nuovo, 
+        // e questo viene fatto attraverso la norma. 
+        double distance = norm(centroyds.at(i), clusters.at(i).clusterCentroyd);
+        centroyds.at(i) = clusters.at(i).clusterCentroyd; 
+        stats.maxShift = max(stats.maxShift, distance); 
+        
+        // Se la distanza è maggiore del threshold che abbiamo scelto, allora 
+        // l'algoritmo può continuare, altrimenti deve fermarsi. 
+        if(distance > thr) {
+            breakable = false;
+        }
+    }
+
+    return breakable; 
+}
+
+// L'inizializzazione k-means++ sceglie i centroidi tra i punti dell'immagine: 
+// il primo con probabilità proporzionale al peso del punto, ognuno dei 
+// successivi con probabilità proporzionale al peso per il quadrato della 
+// distanza dal centroide già scelto più vicino, così che i centroidi 
+// partano lontani tra loro. Fino a plusPlusLimit punti la scelta è quella 
+// sequenziale di k-means++; oltre, ogni centroide richiederebbe un passaggio 
+// su tutta l'immagine e si usa k-means|| (ParallelSeeds). 
+static const int64_t plusPlusLimit = 1 << 16; 
+
+static inline int PointDistance(const uchar* a, const uchar* b) {
+    int dB = a[0] - b[0]; 
+    int dG = a[1] - b[1]; 
+    int dR = a[2] - b[2]; 
+    return dB*dB + dG*dG + dR*dR; 
+}
+
+// Sceglie k centroidi tra i count punti BGR di bgr (con il loro peso, 1 senza 
+// weights) con k-means++. I numeri casuali vengono da generator; se i punti 
+// distinti sono meno di k, i centroidi mancanti ripetono il primo. 
+static vector<Vec3b> PlusPlusSeeds(const uchar* bgr, const int64_t* weights, int64_t count, int k, mt19937_64& generator) {
+    vector<Vec3b> seeds; 
+    vector<int> distances(count, numeric_limits<int>::max()); 
+
+    // Il punto a cui arriva la somma cumulativa dei pesi (per le distanze, 
+    // con distances) che supera target. 
+    auto locate = [&](uint64_t target, bool byDistance) {
+        uint64_t sum = 0; 
+        for(int64_t c = 0; c < count; c++) {
+            sum += static_cast<uint64_t>((weights ? weights[c] : 1) * (byDistance ? distances[c] : 1)); 
+            if(sum > target) {
+                return c; 
+            }
+        }
+        return count - 1; 
+    }; 
+
+    uint64_t totalWeight = 0; 
+    for(int64_t c = 0; c < count; c++) {
+        totalWeight += weights ? weights[c] : 1; 
+    }
+    const uchar* first = bgr + 3*locate(generator() % totalWeight, false); 
+    seeds.push_back(Vec3b(first[0], first[1], first[2])); 
+
+    while(static_cast<int>(seeds.size()) < k) {
+        const uchar* last = &seeds.back().val[0]; 
+        uint64_t cost = 0; 
+        for(int64_t c = 0; c < count; c++) {
+            distances[c] = min(distances[c], PointDistance(bgr + 3*c, last)); 
+            cost += static_cast<uint64_t>((weights ? weights[c] : 1) * distances[c]); 
+        }
+        if(cost == 0) {
+            seeds.resize(k, seeds.front()); 
+            break; 
+        }
+        const uchar* next = bgr + 3*locate(generator() % cost, true); 
+        seeds.push_back(Vec3b(next[0], next[1], next[2])); 
+    }
 
-                    // La distanza che viene calcolata è semplicemente quella Euclidea, adattata 
-                    // al contesto in cui ci sono tre componenti. 
-                    double distance0 = currentCentroyd.val[0]-pixelValue.val[0]; 
-                    double distance1 = currentCentroyd.val[1]-pixelValue.val[1];
-                    double distance2 = currentCentroyd.val[2]-pixelValue.val[2];  
-                    double currentDistance = sqrt(pow(distance0, 2) + pow(distance1, 2) + pow(distance2, 2));
+    return seeds; 
+}
+
+// Un numero uniforme in [0, 1) che dipende solo dal seme, dal giro e dal 
+// punto (lo splitmix64 di Steele, Lea e Flood), e non dall'ordine in cui le 
+// bande vengono elaborate. 
+static inline uint64_t SplitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull; 
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull; 
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull; 
+    return x ^ (x >> 31); 
+}
 
-                    distances.push_back(currentDistance); 
+static inline double UniformHash(unsigned seed, int round, int64_t point) {
+    uint64_t stream = SplitMix64(static_cast<uint64_t>(seed) << 8 | static_cast<uint64_t>(round)); 
+    return static_cast<double>(SplitMix64(stream ^ static_cast<uint64_t>(point)) >> 11) * 0x1.0p-53; 
+}
+
+// I punti delle parti [first, last) degli elementi di K_Means, a blocchi: 
+// le righe dell'immagine, o i colori a blocchi di 4096, con l'indice del 
+// primo punto del blocco. 
+static void ForEachChunk(const Mat& src, const WeightedColors* colors, int first, int last, const function<void(const uchar*, const int64_t*, int, int64_t)>& chunk) {
+    if(colors) {
+        for(int c = first; c < last; c += 4096) {
+            chunk(colors->colors.data() + 3*static_cast<size_t>(c), colors->weights.data() + c, min(4096, last - c), c); 
+        }
+    } else {
+        for(int i = first; i < last; i++) {
+            chunk(src.ptr<uchar>(i), nullptr, src.cols, static_cast<int64_t>(i) * src.cols); 
+        }
+    }
+}
+
+typedef function<void(int, int, const function<void(int, int, int)>&)> BandRunner; 
+
+// L'inizializzazione k-means|| di Bahmani et al.: dopo un primo centroide 
+// scelto come in k-means++, per parallelRounds giri ogni punto diventa un 
+// candidato con probabilità oversampling volte il suo peso per il quadrato 
+// della sua distanza dai candidati, diviso la somma di questi prodotti; ogni 
+// candidato viene poi pesato con i punti a cui è il più vicino, e k-means++ 
+// sui candidati pesati (pochi, circa 2k per giro) sceglie i k centroidi. 
+// Ogni giro richiede due passaggi in parallelo sulle bande invece di un 
+// passaggio per centroide, e le distanze dai nuovi candidati vengono 
+// calcolate con il kernel dell'assegnamento, a gruppi di 256 candidati. 
+// La scelta di un punto dipende solo dal seme e dal punto, quindi il 
+// risultato non dipende dal numero dei thread. Ogni punto tiene la 
+// distanza dal candidato più vicino e il suo indice, 8 byte per punto. 
+static const int parallelRounds = 5; 
+
+static vector<Vec3b> ParallelSeeds(const Mat& src, const WeightedColors* colors, int items, int bands, int k, unsigned seed, const BandRunner& runBands) {
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    int64_t count = colors ? static_cast<int64_t>(colors->weights.size()) : static_cast<int64_t>(src.total()); 
+    mt19937_64 generator(seed); 
+
+    // Il primo candidato: un pixel a caso, o un colore con probabilità 
+    // proporzionale al numero dei suoi pixel. 
+    vector<uchar> candidates(3); 
+    if(colors) {
+        uint64_t target = generator() % static_cast<uint64_t>(src.total()); 
+        uint64_t sum = 0; 
+        int64_t c = 0; 
+        while(c < count - 1 && (sum += colors->weights[c]) <= target) {
+            c++; 
+        }
+        memcpy(candidates.data(), &colors->colors[3*c], 3); 
+    } else {
+        int64_t index = static_cast<int64_t>(generator() % static_cast<uint64_t>(count)); 
+        memcpy(candidates.data(), src.ptr<uchar>(static_cast<int>(index / src.cols)) + 3*(index % src.cols), 3); 
+    }
+
+    vector<int> distances(count, numeric_limits<int>::max()); 
+    vector<int> nearest(count, 0); 
+    vector<uint64_t> bandCosts(bands); 
+    vector<vector<uchar>> bandCandidates(bands); 
+    int oversampling = 2*k; 
+    int measured = 0; 
+
+    for(int round = 0; ; round++) {
+        // Le distanze dai candidati aggiunti nell'ultimo giro. 
+        int added = static_cast<int>(candidates.size() / 3); 
+        vector<vector<int16_t>> groups; 
+        for(int g = measured; g < added; g += 256) {
+            int size = min(256, added - g); 
+            vector<int16_t> planes(3*size); 
+            for(int x = 0; x < size; x++) {
+                for(int c = 0; c < 3; c++) {
+                    planes[c*size+x] = candidates[3*(g+x)+c]; 
+                }
+            }
+            groups.push_back(planes); 
+        }
+
+        runBands(items, bands, [&](int b, int first, int last) {
+            vector<uchar> labels; 
+            vector<int32_t> nearestDistances, secondDistances; 
+            uint64_t cost = 0; 
+            ForEachChunk(src, colors, first, last, [&](const uchar* bgr, const int64_t* weights, int n, int64_t base) {
+                labels.resize(n); 
+                nearestDistances.resize(n); 
+                secondDistances.resize(n); 
+                for(size_t g = 0; g < groups.size(); g++) {
+                    int size = static_cast<int>(groups[g].size() / 3); 
+                    kernels.nearestTwoCentroidsRow(bgr, n, groups[g].data(), size, labels.data(), nearestDistances.data(), secondDistances.data()); 
+                    for(int j = 0; j < n; j++) {
+                        if(nearestDistances[j] < distances[base+j]) {
+                            distances[base+j] = nearestDistances[j]; 
+                            nearest[base+j] = measured + 256*static_cast<int>(g) + labels[j]; 
+                        }
+                    }
+                }
+                for(int j = 0; j < n; j++) {
+                    cost += static_cast<uint64_t>((weights ? weights[j] : 1) * distances[base+j]); 
                 }
+            }); 
+            bandCosts[b] = cost; 
+        }); 
+        measured = added; 
 
-                // 5. Troviamo per il punto corrente la minima distanza tra quelle calcolate. Quindi 
-                // si scorre tutta la lista delle distanze e si trova quella minima. Il Cluster che 
-                // dovrà contenere quel pixel ha indice index.  
-                int index = 0; 
-                for(int i = 0; i < k; i++) {
-                    if(distances.at(i) < distances.at(index)) {
-                        index = i; 
+        uint64_t cost = 0; 
+        for(int b = 0; b < bands; b++) {
+            cost += bandCosts[b]; 
+        }
+        if(round == parallelRounds || cost == 0) {
+            break; 
+        }
+
+        // I nuovi candidati, nell'ordine dei punti. 
+        runBands(items, bands, [&](int b, int first, int last) {
+            bandCandidates[b].clear(); 
+            ForEachChunk(src, colors, first, last, [&](const uchar* bgr, const int64_t* weights, int n, int64_t base) {
+                for(int j = 0; j < n; j++) {
+                    double probability = static_cast<double>(oversampling) * static_cast<double>((weights ? weights[j] : 1) * distances[base+j]) / static_cast<double>(cost); 
+                    if(UniformHash(seed, round, base+j) < probability) {
+                        bandCandidates[b].insert(bandCandidates[b].end(), bgr + 3*j, bgr + 3*j + 3); 
                     }
                 }
+            }); 
+        }); 
+        for(int b = 0; b < bands; b++) {
+            candidates.insert(candidates.end(), bandCandidates[b].begin(), bandCandidates[b].end()); 
+        }
+    }
 
-                // 6. Inseriamo il punto nel relativo Cluster, utilizzando l'apposito metodo della classe. 
-                clusters.at(index).InsertPixel(i, j, pixelValue); 
-                distances.clear(); 
-            } 
-        }
-
-        centroyds.clear(); 
-        breakable = false; 
-
-        // Per ognuno dei Cluster si deve ricalcolare il centroide essendo 
-        // adesso composti da una serie di pixel. Il centroide viene ricalcolato 
-        // con l'apposito metodo della funzione, ma prima viene salvato il vecchio 
-        // centroide per poterlo confrontare (in quanto a distanza) con il nuovo 
-        // centroide. Se uno dei centroidi non è stato modificato sostanzialmente, 
-        // ed infatti a questo serve il threshold, allora si deve bloccare il ciclo 
-        // for e terminare l'algoritmo. 
-        for(int i = 0; i < clusters.size(); i++) {
-            Vec3b prevCentroyd = clusters.at(i).clusterCentroyd; 
-
-            clusters.at(i).SetCentroyd(); 
-            centroyds.push_back(clusters.at(i).clusterCentroyd); 
-
-            // Si deve calcolare la distanza tra il vecchio centroide e quello nuovo, 
-            // e questo viene fatto attraverso la norma. 
-            double distance = norm(prevCentroyd, clusters.at(i).clusterCentroyd);
-            
-            // Se la distanza è maggiore del threshold che abbiamo scelto, allora 
-            // l'algoritmo può continuare, altrimenti deve fermarsi. 
+    // Il peso di ogni candidato è quello dei punti a cui è il più vicino. 
+    int candidateCount = static_cast<int>(candidates.size() / 3); 
+    vector<vector<int64_t>> bandWeights(bands); 
+    runBands(items, bands, [&](int b, int first, int last) {
+        bandWeights[b].assign(candidateCount, 0); 
+        ForEachChunk(src, colors, first, last, [&](const uchar*, const int64_t* weights, int n, int64_t base) {
+            for(int j = 0; j < n; j++) {
+                bandWeights[b][nearest[base+j]] += weights ? weights[j] : 1; 
+            }
+        }); 
+    }); 
+    vector<int64_t> candidateWeights(candidateCount, 0); 
+    for(int b = 0; b < bands; b++) {
+        for(int c = 0; c < candidateCount; c++) {
+            candidateWeights[c] += bandWeights[b][c]; 
+        }
+    }
+
+    return PlusPlusSeeds(candidates.data(), candidateWeights.data(), candidateCount, k, generator); 
+}
+
+// La versione mini-batch di K_Means: ad ogni iterazione i centroidi vengono 
+// aggiornati con un campione casuale di batch pixel dell'immagine, invece 
+// che con tutti i pixel. Ogni pixel del campione viene assegnato al 
+// centroide più vicino (con il kernel dell'assegnamento completo) e sposta 
+// il centroide verso di sé con un passo 1/n, dove n è il numero dei pixel 
+// assegnati fino a quel momento al suo Cluster: ogni centroide resta la 
+// media dei pixel che ha ricevuto, e si muove sempre meno. I centroidi sono 
+// tenuti in double e arrotondati solo per l'assegnamento; i pixel vengono 
+// scelti con un generatore mt19937_64 inizializzato con seed, quindi lo 
+// stesso seed dà sempre gli stessi centroidi. Le iterazioni si fermano 
+// quando nessun centroide si è spostato più di thr. 
+static void MiniBatchCentroyds(const Mat& src, vector<Vec3b>& centroyds, int iterations, int thr, int batch, unsigned seed, const function<void(const KMeansIterationStats&)>& onIteration) {
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    int k = static_cast<int>(centroyds.size()); 
+    uint64_t total = static_cast<uint64_t>(src.total()); 
+
+    vector<double> centers(3*k); 
+    vector<int64_t> counts(k, 0); 
+    for(int x = 0; x < k; x++) {
+        for(int c = 0; c < 3; c++) {
+            centers[3*x+c] = centroyds[x].val[c]; 
+        }
+    }
+
+    mt19937_64 generator(seed); 
+    vector<int16_t> planes(3*k); 
+    vector<uchar> points(3*static_cast<size_t>(batch)); 
+    vector<uchar> labels(batch); 
+
+    for(int it = 0; it < iterations; it++) {
+        auto start = chrono::steady_clock::now(); 
+
+        for(int x = 0; x < k; x++) {
+            for(int c = 0; c < 3; c++) {
+                planes[c*k+x] = static_cast<int16_t>(centroyds[x].val[c]); 
+            }
+        }
+
+        // Il campione viene copiato in un buffer contiguo, come una riga 
+        // dell'immagine, e assegnato tutto insieme dal kernel. 
+        for(int p = 0; p < batch; p++) {
+            uint64_t index = generator() % total; 
+            int row = static_cast<int>(index / src.cols); 
+            int col = static_cast<int>(index % src.cols); 
+            memcpy(&points[3*static_cast<size_t>(p)], src.ptr<uchar>(row) + 3*col, 3); 
+        }
+        kernels.nearestCentroidRow(points.data(), batch, planes.data(), k, labels.data()); 
+
+        KMeansIterationStats stats; 
+        stats.iteration = it; 
+        stats.distanceEvaluations = static_cast<int64_t>(batch) * k; 
+        for(int p = 0; p < batch; p++) {
+            const uchar* point = &points[3*static_cast<size_t>(p)]; 
+            int x = labels[p]; 
+            stats.inertia += SquaredDistance(point, planes.data(), k, x); 
+
+            double rate = 1.0 / ++counts[x]; 
+            for(int c = 0; c < 3; c++) {
+                centers[3*x+c] += rate * (point[c] - centers[3*x+c]); 
+            }
+        }
+
+        bool breakable = true; 
+        for(int x = 0; x < k; x++) {
+            Vec3b centroyd(saturate_cast<uchar>(centers[3*x]), saturate_cast<uchar>(centers[3*x+1]), saturate_cast<uchar>(centers[3*x+2])); 
+            double distance = norm(centroyds[x], centroyd); 
+            centroyds[x] = centroyd; 
+            stats.maxShift = max(stats.maxShift, distance); 
             if(distance > thr) {
-                breakable = false;
+                breakable = false; 
+            }
+        }
+
+        stats.converged = breakable; 
+        stats.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); 
+        if(onIteration) {
+            onIteration(stats); 
+        }
+        if(breakable) {
+            break; 
+        }
+    }
+}
+
+// Gli input della funzione K_Means sono l'immagine originale, il numero 
+// di Cluster da creare, il numero di iterazioni da effettuare ed il numero 
+// relativo al threshold con il quale confrontare la distanza tra il vecchio 
+// centroide della regione ed il nuovo ricalcolato nell'iterazione attuale. 
+Mat K_Means(Mat src, int k, int iterations, int thr, const KMeansOptions& options) {
+    vector<Vec3b> centroyds; 
+    return K_Means(src, k, iterations, thr, centroyds, options); 
+}
+
+// Con centroyds vuoto i centroidi iniziali vengono scelti come indicato da 
+// options.seeding, altrimenti si parte da quelli dati. 
+Mat K_Means(Mat src, int k, int iterations, int thr, vector<Vec3b>& centroyds, const KMeansOptions& options) {
+    IPA_TRACE_SCOPE("K_Means", src.total()); 
+
+    if(src.type() != CV_8UC3) {
+        throw invalid_argument("K_Means needs a CV_8UC3 image"); 
+    }
+    if(k < 1 || k > 256) {
+        throw invalid_argument("the number of clusters must be between 1 and 256: " + to_string(k)); 
+    }
+    if(options.colorBits < 0 || options.colorBits > 8) {
+        throw invalid_argument("the bits per channel of the color histogram must be between 0 and 8: " + to_string(options.colorBits)); 
+    }
+    if(options.miniBatch < 0) {
+        throw invalid_argument("the size of the mini-batch must not be negative: " + to_string(options.miniBatch)); 
+    }
+    if(!centroyds.empty() && static_cast<int>(centroyds.size()) != k) {
+        throw invalid_argument("the initial centroids must be as many as the clusters: " + to_string(centroyds.size())); 
+    }
+    if(src.rows == 0 || src.cols == 0) {
+        return Mat(src.size(), src.type()); 
+    }
+
+    // L'etichetta di ogni pixel (l'indice del suo Cluster) viene scritta 
+    // nella mappa delle etichette, quindi la memoria non cresce con il numero 
+    // di iterazioni. Con colorBits le iterazioni scorrono invece la lista dei 
+    // colori distinti dell'immagine, e l'etichetta è tenuta per ogni colore. 
+    bool byColor = options.colorBits > 0; 
+    WeightedColors colors; 
+    vector<uchar> colorLabels; 
+    Mat labelMap; 
+    if(byColor) {
+        colors = CollectColors(src, options.colorBits); 
+        colorLabels.resize(colors.weights.size()); 
+    } else {
+        labelMap.create(src.rows, src.cols, CV_8UC1); 
+    }
+    int items = byColor ? static_cast<int>(colors.weights.size()) : src.rows; 
+
+    // Con i limiti di Hamerly ogni punto ha anche i suoi due limiti, 8 byte 
+    // in più per pixel (o per colore). Il mini-batch fa un solo assegnamento 
+    // completo, a cui i limiti non servono. 
+    bool miniBatch = options.miniBatch > 0; 
+    bool bounded = options.hamerly && !miniBatch; 
+    vector<float> colorBounds; 
+    Mat boundsMap; 
+    if(bounded && byColor) {
+        colorBounds.resize(2*colors.weights.size()); 
+    } else if(bounded) {
+        boundsMap.create(src.rows, src.cols, CV_32FC2); 
+    }
+
+    // I centroidi vengono passati al kernel di assegnamento come tre piani 
+    // (blu, verde, rosso) di interi a 16 bit; previousCentroyds sono quelli 
+    // dell'assegnamento precedente, per gli spostamenti dei limiti. 
+    vector<int16_t> centroydPlanes(3*k); 
+    vector<Vec3b> previousCentroyds; 
+    CentroydGeometry geometry; 
+    Assignment assignment; 
+    assignment.centroydPlanes = centroydPlanes.data(); 
+    assignment.k = k; 
+    assignment.bounded = bounded; 
+    int64_t points = byColor ? static_cast<int64_t>(colors.weights.size()) : static_cast<int64_t>(src.total()); 
+
+    // Le bande di righe (o di colori) vengono assegnate in parallelo, ognuna 
+    // con le proprie somme parziali dei Cluster, che vengono sommate alla 
+    // fine di ogni iterazione; il pool di thread viene creato una sola volta. 
+    int maxThreads = options.threads > 0 ? options.threads : DefaultThreadCount(); 
+    int rowBands = max(1, min(maxThreads, src.rows / 16)); 
+    int bands = byColor ? max(1, min(maxThreads, items / 4096)) : rowBands; 
+    vector<BandResult> bandResults(bands); 
+    unique_ptr<ThreadPool> pool; 
+    if(max(bands, rowBands) > 1) {
+        pool.reset(new ThreadPool(max(bands, rowBands))); 
+    }
+
+    // Le parti vengono eseguite sul pool di K_Means. 
+    auto runBands = [&pool](int count, int parts, const function<void(int, int, int)>& job) {
+        RunBands(pool.get(), count, parts, job); 
+    }; 
+
+    // I due vettori vengono utilizzati uno per i centroidi dei Cluster e 
+    // uno per i Cluster stessi dell'immagine. 
+    vector<Cluster> clusters(k); 
+
+    // 1. Selezioniamo dall'immagine i primi centroidi dei cluster (se non 
+    // sono stati dati): in maniera random, oppure con k-means++, sui pixel 
+    // o sui colori pesati. 
+    if(centroyds.empty() && options.seeding == KMeansSeeding::Random) {
+        mt19937_64 generator(options.sampleSeed); 
+        for(int i = 0; i < k; i++) {
+            int randX = static_cast<int>(generator() % static_cast<uint64_t>(src.rows)); 
+            int randY = static_cast<int>(generator() % static_cast<uint64_t>(src.cols)); 
+            centroyds.push_back(src.at<Vec3b>(randX, randY)); 
+        }
+    } else if(centroyds.empty() && points > plusPlusLimit) {
+        centroyds = ParallelSeeds(src, byColor ? &colors : nullptr, items, bands, k, options.sampleSeed, runBands); 
+    } else if(centroyds.empty() && byColor) {
+        mt19937_64 generator(options.sampleSeed); 
+        centroyds = PlusPlusSeeds(colors.colors.data(), colors.weights.data(), points, k, generator); 
+    } else if(centroyds.empty()) {
+        vector<uchar> pixels; 
+        for(int i = 0; i < src.rows; i++) {
+            pixels.insert(pixels.end(), src.ptr<uchar>(i), src.ptr<uchar>(i) + 3*src.cols); 
+        }
+        mt19937_64 generator(options.sampleSeed); 
+        centroyds = PlusPlusSeeds(pixels.data(), nullptr, points, k, generator); 
+    }
+
+    auto fillPlanes = [&]() {
+        for(int x = 0; x < k; x++) {
+            centroydPlanes[x] = centroyds[x].val[0]; 
+            centroydPlanes[k+x] = centroyds[x].val[1]; 
+            centroydPlanes[2*k+x] = centroyds[x].val[2]; 
+        }
+    }; 
+    auto assignAll = [&]() {
+        runBands(items, bands, [&](int b, int first, int last) {
+            if(byColor) {
+                AssignColors(colors, colorLabels, colorBounds, assignment, first, last, bandResults[b]); 
+            } else {
+                AssignBand(src, labelMap, boundsMap, assignment, first, last, bandResults[b]); 
             }
+        }); 
+    }; 
+
+    // Con il mini-batch le iterazioni aggiornano i centroidi con i campioni, 
+    // e i pixel (o i colori) vengono assegnati una volta sola, alla fine, ai 
+    // centroidi così trovati, che non vengono più ricalcolati. 
+    if(miniBatch) {
+        MiniBatchCentroyds(src, centroyds, iterations, thr, options.miniBatch, options.sampleSeed, options.onIteration); 
+        fillPlanes(); 
+        assignAll(); 
+    }
+
+    for(int it = 0; it < (miniBatch ? 0 : iterations); it++) {
+        auto start = chrono::steady_clock::now(); 
+
+        fillPlanes(); 
+        if(bounded && it > 0) {
+            geometry = MeasureCentroyds(previousCentroyds, centroyds); 
+            assignment.geometry = &geometry; 
+        }
+        assignment.labelled = it > 0; 
+        previousCentroyds = centroyds; 
+
+        // 2. Per tutti i punti dell'immagine dobbiamo trovare il centroide più 
+        // vicino, e sommare le componenti del punto a quelle del suo Cluster. 
+        assignAll(); 
+
+        // 3. Le somme parziali delle bande vengono sommate per ogni Cluster e 
+        // inserite nei relativi Cluster. 
+        KMeansIterationStats stats; 
+        stats.iteration = it; 
+        vector<ClusterSums> totals(k); 
+        for(int b = 0; b < bands; b++) {
+            for(int x = 0; x < k; x++) {
+                const ClusterSums& sums = bandResults[b].sums[x]; 
+                totals[x].sumB += sums.sumB; 
+                totals[x].sumG += sums.sumG; 
+                totals[x].sumR += sums.sumR; 
+                totals[x].sumSquares += sums.sumSquares; 
+                totals[x].pixelNum += sums.pixelNum; 
+            }
+            stats.distanceEvaluations += bandResults[b].evaluations; 
+            stats.skippedEvaluations += bandResults[b].skipped; 
+            stats.reassigned += bandResults[b].reassigned; 
+        }
+
+        bool breakable = UpdateCentroyds(totals, clusters, centroyds, thr, stats); 
+
+        // L'algoritmo si ferma anche quando i pixel che hanno cambiato Cluster 
+        // sono al più la frazione reassignedTolerance di tutti i pixel: senza 
+        // nessun cambiamento la prossima iterazione sarebbe identica. 
+        if(it > 0 && stats.reassigned <= options.reassignedTolerance * static_cast<double>(src.total())) {
+            breakable = true; 
+        }
+
+        stats.converged = breakable; 
+        stats.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); 
+        if(options.onIteration) {
+            options.onIteration(stats); 
         }
 
         // Se la variabile breakable è vera allora si deve terminare l'algoritmo. 
@@ -169,51 +938,245 @@ Mat K_Means(Mat src, int k, int iterations, int thr) {
     }
 
     // Si deve creare l'immagine risultante dalle operazioni precedenti, quindi una
-    // volta usciti dal ciclo for si deve scorrere su tutti i Cluster e per ogni 
-    // Cluster scorrere la lista dei pixel per poter assegnare all'immagine finale 
-    // le cui coordinate coincidono con quelle del pixel scelto il valore del pixel 
-    // della lista. 
+    // volta usciti dal ciclo for si assegna ad ogni pixel dell'immagine finale il 
+    // centroide del Cluster della sua etichetta. Senza iterazioni (e senza 
+    // mini-batch, che assegna comunque i pixel) l'immagine resta nera. 
     Mat resultImage = Mat(src.size(), src.type(), Scalar::all(0));  
 
-    for(int cluster = 0; cluster < k; cluster++) {
-        for(int pixel = 0; pixel < clusters.at(cluster).pixelsCoordsList.size(); pixel++) {
-            int x = clusters.at(cluster).pixelsCoordsList.at(pixel).x;
-            int y = clusters.at(cluster).pixelsCoordsList.at(pixel).y; 
-
-            resultImage.at<Vec3b>(x, y) = clusters.at(cluster).clusterCentroyd;  
-        }
+    // Con i colori, l'etichetta di un pixel è quella del colore del suo bin. 
+    if(iterations > 0 || miniBatch) {
+        runBands(src.rows, rowBands, [&](int, int firstRow, int lastRow) {
+            for(int i = firstRow; i < lastRow; i++) {
+                const uchar* pixels = src.ptr<uchar>(i); 
+                Vec3b* row = resultImage.ptr<Vec3b>(i); 
+                if(byColor) {
+                    for(int j = 0; j < src.cols; j++) {
+                        row[j] = centroyds[colorLabels[colors.binIndex[ColorBin(pixels + 3*j, colors.bits)]]]; 
+                    }
+                } else {
+                    const uchar* labels = labelMap.ptr<uchar>(i); 
+                    for(int j = 0; j < src.cols; j++) {
+                        row[j] = centroyds[labels[j]]; 
+                    }
+                }
+            }
+        }); 
     }
 
     // Alla fine si restituisce il risultato finale. 
     return resultImage; 
 }
 
-int main(int argc, char *argv[]) {
-    // Si legge l'immagine di input da riga di comando, che deve 
-    // essere a colori. 
-    String inputFile = argv[1]; 
-    Mat inputImage = imread(inputFile, IMREAD_ANYCOLOR);
+// Legge le immagini di una raccolta a blocchi di righe, aprendo un'immagine 
+// alla volta: un blocco non contiene mai righe di due immagini. 
+class ChunkReader {
+    public: 
+    ChunkReader(const vector<RowSourceFactory>& images, int chunkRows) : images(images), chunkRows(chunkRows) {}
 
-    // Si mostra l'immagine all'interno di una apposita finestra. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE); 
-    imshow("Original Image", inputImage); 
+    // Legge il blocco successivo in chunk; restituisce false alla fine della 
+    // raccolta. 
+    bool Next(Mat& chunk) {
+        while(!this->source || this->rowsLeft == 0) {
+            if(this->nextImage == this->images.size()) {
+                this->source.reset(); 
+                return false; 
+            }
+            this->source = this->images[this->nextImage++](); 
+            if(!this->source || this->source->Type() != CV_8UC3) {
+                throw invalid_argument("StreamK_Means needs CV_8UC3 images: image " + to_string(this->nextImage - 1)); 
+            }
+            this->rowsLeft = this->source->Cols() > 0 ? this->source->Rows() : 0; 
+        }
+
+        chunk.create(min(this->chunkRows, this->rowsLeft), this->source->Cols(), CV_8UC3); 
+        this->source->Read(chunk); 
+        this->rowsLeft -= chunk.rows; 
+        return true; 
+    }
+
+    void Rewind() {
+        this->source.reset(); 
+        this->nextImage = 0; 
+        this->rowsLeft = 0; 
+    }
+
+    private: 
+    const vector<RowSourceFactory>& images; 
+    int chunkRows; 
+    size_t nextImage = 0; 
+    unique_ptr<RowSource> source; 
+    int rowsLeft = 0; 
+}; 
+
+// Chiama process su tutti i blocchi della raccolta, in ordine: mentre 
+// process elabora un blocco, il thread di readerThread legge il successivo 
+// nell'altro dei due buffer. 
+static void ForEachStreamChunk(ChunkReader& reader, ThreadPool& readerThread, const function<void(const Mat&)>& process) {
+    reader.Rewind(); 
+    Mat buffers[2]; 
+    bool available[2] = {reader.Next(buffers[0]), false}; 
 
-    // Da riga di comando si prendono anche i parametri: 
-    // k:          numero di Cluster da creare, 
-    // iterations: numero di iterazione da fare al massimo, 
-    // threshold:  il valore che la distanza deve superare per poter 
-    //             permettere all'algoritmo di continuare. 
-    int k = atoi(argv[2]); 
-    int iterations = atoi(argv[3]); 
-    int threshold = atoi(argv[4]); 
+    for(int current = 0; available[current]; current = 1 - current) {
+        int following = 1 - current; 
+        readerThread.Submit([&reader, &buffers, &available, following] {
+            available[following] = reader.Next(buffers[following]); 
+        }); 
 
-    Mat resultImage = K_Means(inputImage, k, iterations, threshold);
+        // La lettura usa i buffer, quindi deve finire prima di uscire anche 
+        // in caso di errore. 
+        try {
+            process(buffers[current]); 
+        } catch(...) {
+            try {
+                readerThread.Wait(); 
+            } catch(...) {
+            }
+            throw; 
+        }
+        readerThread.Wait(); 
+    }
+}
 
-    // Il risultato finale viene mostrato in un'apposita finestra. 
-    namedWindow("K-Means Image", WINDOW_AUTOSIZE); 
-    imshow("K-Means Image", resultImage); 
+// Un campione uniforme di al più sampleSize pixel della raccolta, estratto 
+// in un solo passaggio con l'algoritmo L di Li (reservoir sampling): dopo i 
+// primi sampleSize pixel il numero dei pixel da saltare prima del prossimo 
+// da prendere viene estratto direttamente, quindi i numeri casuali sono 
+// pochi anche su miliardi di pixel. 
+static vector<uchar> SamplePixels(ChunkReader& reader, ThreadPool& readerThread, int64_t sampleSize, mt19937_64& generator) {
+    auto uniform = [&generator]() {
+        return (static_cast<double>(generator() >> 11) + 0.5) * 0x1.0p-53; 
+    }; 
+    double w = exp(log(uniform()) / static_cast<double>(sampleSize)); 
+    auto skip = [&]() {
+        return static_cast<int64_t>(min(1e18, floor(log(uniform()) / log(1 - w)))); 
+    }; 
 
-    waitKey(0); 
+    vector<uchar> sample; 
+    int64_t seen = 0; 
+    int64_t nextTaken = sampleSize + skip(); 
+    ForEachStreamChunk(reader, readerThread, [&](const Mat& chunk) {
+        int64_t count = static_cast<int64_t>(chunk.total()); 
+        auto pixel = [&chunk](int64_t p) {
+            return chunk.ptr<uchar>(static_cast<int>(p / chunk.cols)) + 3*(p % chunk.cols); 
+        }; 
 
-    return 0; 
-}
\ No newline at end of file
+        for(int64_t p = 0; p < count && seen + p < sampleSize; p++) {
+            sample.insert(sample.end(), pixel(p), pixel(p) + 3); 
+        }
+        while(nextTaken < seen + count) {
+            memcpy(&sample[3*(generator() % static_cast<uint64_t>(sampleSize))], pixel(nextTaken - seen), 3); 
+            w *= exp(log(uniform()) / static_cast<double>(sampleSize)); 
+            nextTaken += skip() + 1; 
+        }
+        seen += count; 
+    }); 
+
+    return sample; 
+}
+
+void StreamK_Means(const vector<RowSourceFactory>& images, int k, int iterations, int thr, int chunkRows, vector<Vec3b>& centroyds, const KMeansOptions& options) {
+    IPA_TRACE_SCOPE("StreamK_Means", 0); 
+
+    if(k < 1 || k > 256) {
+        throw invalid_argument("the number of clusters must be between 1 and 256: " + to_string(k)); 
+    }
+    if(chunkRows < 1) {
+        throw invalid_argument("the rows of a chunk must be at least 1: " + to_string(chunkRows)); 
+    }
+    if(!centroyds.empty() && static_cast<int>(centroyds.size()) != k) {
+        throw invalid_argument("the initial centroids must be as many as the clusters: " + to_string(centroyds.size())); 
+    }
+
+    // Un thread legge i blocchi, e i blocchi vengono assegnati a bande di 
+    // righe sul pool degli altri thread. 
+    ChunkReader reader(images, chunkRows); 
+    ThreadPool readerThread(1); 
+    int maxThreads = options.threads > 0 ? options.threads : DefaultThreadCount(); 
+    unique_ptr<ThreadPool> pool; 
+    if(maxThreads > 1) {
+        pool.reset(new ThreadPool(maxThreads)); 
+    }
+
+    // 1. I centroidi iniziali vengono scelti da un campione dei pixel della 
+    // raccolta, che costa un passaggio in più (non serve quando i centroidi 
+    // sono dati). 
+    if(centroyds.empty()) {
+        mt19937_64 generator(options.sampleSeed); 
+        vector<uchar> sample = SamplePixels(reader, readerThread, plusPlusLimit, generator); 
+        int64_t count = static_cast<int64_t>(sample.size() / 3); 
+        if(count == 0) {
+            throw invalid_argument("StreamK_Means needs at least one pixel"); 
+        }
+
+        if(options.seeding == KMeansSeeding::PlusPlus) {
+            centroyds = PlusPlusSeeds(sample.data(), nullptr, count, k, generator); 
+        } else {
+            for(int i = 0; i < k; i++) {
+                const uchar* pixel = &sample[3*(generator() % static_cast<uint64_t>(count))]; 
+                centroyds.push_back(Vec3b(pixel[0], pixel[1], pixel[2])); 
+            }
+        }
+    }
+
+    vector<Cluster> clusters(k); 
+    vector<int16_t> centroydPlanes(3*k); 
+    Assignment assignment; 
+    assignment.centroydPlanes = centroydPlanes.data(); 
+    assignment.k = k; 
+    vector<BandResult> bandResults(maxThreads); 
+    Mat chunkLabels, boundsMap; 
+
+    for(int it = 0; it < iterations; it++) {
+        auto start = chrono::steady_clock::now(); 
+
+        for(int x = 0; x < k; x++) {
+            centroydPlanes[x] = centroyds[x].val[0]; 
+            centroydPlanes[k+x] = centroyds[x].val[1]; 
+            centroydPlanes[2*k+x] = centroyds[x].val[2]; 
+        }
+
+        // 2. Ogni blocco viene assegnato, e le somme delle sue bande vengono 
+        // sommate a quelle di tutta la raccolta: un solo aggiornamento dei 
+        // centroidi per iterazione, come con un'immagine sola. 
+        KMeansIterationStats stats; 
+        stats.iteration = it; 
+        vector<ClusterSums> totals(k); 
+        ForEachStreamChunk(reader, readerThread, [&](const Mat& chunk) {
+            chunkLabels.create(chunk.rows, chunk.cols, CV_8UC1); 
+            int bands = max(1, min(maxThreads, chunk.rows / 16)); 
+            RunBands(pool.get(), chunk.rows, bands, [&](int b, int firstRow, int lastRow) {
+                AssignBand(chunk, chunkLabels, boundsMap, assignment, firstRow, lastRow, bandResults[b]); 
+            }); 
+
+            for(int b = 0; b < bands; b++) {
+                for(int x = 0; x < k; x++) {
+                    const ClusterSums& sums = bandResults[b].sums[x]; 
+                    totals[x].sumB += sums.sumB; 
+                    totals[x].sumG += sums.sumG; 
+                    totals[x].sumR += sums.sumR; 
+                    totals[x].sumSquares += sums.sumSquares; 
+                    totals[x].pixelNum += sums.pixelNum; 
+                }
+                stats.distanceEvaluations += bandResults[b].evaluations; 
+                stats.skippedEvaluations += bandResults[b].skipped; 
+            }
+        }); 
+        if(stats.distanceEvaluations == 0) {
+            throw invalid_argument("StreamK_Means needs at least one pixel"); 
+        }
+
+        // 3. I nuovi centroidi; senza le etichette dei pixel non si possono 
+        // contare i pixel riassegnati, e l'algoritmo si ferma quando nessun 
+        // centroide si è spostato più del threshold. 
+        bool breakable = UpdateCentroyds(totals, clusters, centroyds, thr, stats); 
+
+        stats.converged = breakable; 
+        stats.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); 
+        if(options.onIteration) {
+            options.onIteration(stats); 
+        }
+        if(breakable) {
+            break; 
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef K_MEANS_HPP
+#define K_MEANS_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "StripStreaming.hpp"
+
+// Le statistiche di un'iterazione di K_Means: 
+// milliseconds:        la durata dell'iterazione; 
+// inertia:             la somma dei quadrati delle distanze dei pixel dai 
+//                      centroidi a cui sono stati assegnati (con colorBits, 
+//                      dei colori dei loro bin); 
+// reassigned:          i pixel che hanno cambiato Cluster (tutti alla prima 
+//                      iterazione); 
+// maxShift:            lo spostamento più grande di un centroide; 
+// distanceEvaluations: le distanze tra un punto e un centroide calcolate, 
+// skippedEvaluations:  e quelle evitate grazie ai limiti di Hamerly (k per 
+//                      un punto che salta la ricerca, k-1 per uno a cui 
+//                      basta la distanza dal suo centroide); 
+// converged:           se l'algoritmo si ferma dopo questa iterazione. 
+struct KMeansIterationStats {
+    int iteration = 0; 
+    double milliseconds = 0; 
+    double inertia = 0; 
+    int64_t reassigned = 0; 
+    double maxShift = 0; 
+    int64_t distanceEvaluations = 0; 
+    int64_t skippedEvaluations = 0; 
+    bool converged = false; 
+}; 
+
+// La scelta dei centroidi iniziali: 
+// Random:   k pixel scelti a caso; 
+// PlusPlus: k-means++ (k-means|| sulle immagini più grandi). 
+// In entrambi i casi i numeri casuali sono generati da sampleSeed (e non 
+// da rand()): lo stesso seme dà sempre gli stessi centroidi, qualunque sia 
+// il numero dei thread. 
+enum class KMeansSeeding {
+    Random, 
+    PlusPlus, 
+}; 
+
+// Le opzioni di K_Means: 
+// threads:     le bande dell'immagine vengono elaborate su threads thread 
+//              (con threads <= 0 uno per thread hardware); 
+// colorBits:   con 0 ogni iterazione scorre tutti i pixel; con un valore 
+//              tra 1 e 8 le iterazioni non scorrono i pixel ma i colori 
+//              distinti dell'immagine, quantizzati a colorBits bit per 
+//              canale e pesati con il numero dei loro pixel. Con 8 bit (e gli 
+//              stessi centroidi iniziali) il risultato è identico a 
+//              quello calcolato sui pixel; 
+//              l'istogramma dei colori occupa 2^(3*colorBits) interi; 
+// hamerly:     ogni punto tiene un limite superiore della distanza dal suo 
+//              centroide e uno inferiore della distanza dagli altri, e la 
+//              ricerca del centroide più vicino viene saltata quando i 
+//              limiti (e le distanze tra i centroidi) la rendono inutile. 
+//              Il risultato è identico, al costo di 8 byte per punto; 
+// reassignedTolerance: 
+//              l'algoritmo si ferma quando nessun centroide si è spostato 
+//              più di thr, o quando i pixel che hanno cambiato Cluster sono 
+//              al più questa frazione dei pixel (con 0, quando nessun pixel 
+//              ha cambiato Cluster); 
+// miniBatch:   con un valore positivo ogni iterazione aggiorna i centroidi 
+//              con un campione casuale di miniBatch pixel, con un passo che 
+//              per ogni Cluster decresce con i pixel che ha ricevuto, e i 
+//              pixel vengono assegnati una sola volta, alla fine (i limiti 
+//              di Hamerly vengono ignorati). Le statistiche delle iterazioni 
+//              sono quelle del campione; 
+// seeding:     la scelta dei centroidi iniziali; 
+// sampleSeed:  il seme dei numeri casuali dei campioni del mini-batch e 
+//              della scelta dei centroidi iniziali; 
+// onIteration: se presente, viene chiamata alla fine di ogni iterazione. 
+struct KMeansOptions {
+    int threads = 0; 
+    int colorBits = 0; 
+    bool hamerly = false; 
+    double reassignedTolerance = 0; 
+    int miniBatch = 0; 
+    KMeansSeeding seeding = KMeansSeeding::Random; 
+    unsigned sampleSeed = 1; 
+    std::function<void(const KMeansIterationStats&)> onIteration; 
+}; 
+
+// Gli input della funzione K_Means sono l'immagine originale (a colori), 
+// il numero di Cluster da creare, il numero di iterazioni da effettuare 
+// ed il threshold per la distanza tra i centroidi di due iterazioni. 
+// L'immagine deve essere CV_8UC3 e k compreso tra 1 e 256. 
+cv::Mat K_Means(cv::Mat src, int k, int iterations, int thr, const KMeansOptions& options = KMeansOptions()); 
+
+// Come K_Means, con i centroidi in ingresso e in uscita: se centroyds non è 
+// vuoto deve contenere k centroidi, da cui l'algoritmo parte invece di 
+// sceglierli (per esempio quelli del fotogramma precedente di un video, che 
+// convergono in una o due iterazioni); alla fine contiene i centroidi finali. 
+cv::Mat K_Means(cv::Mat src, int k, int iterations, int thr, std::vector<cv::Vec3b>& centroyds, const KMeansOptions& options = KMeansOptions()); 
+
+// Apre una delle immagini di una raccolta, da cui le righe vengono lette a 
+// blocchi (per esempio un PnmRowSource o un RawRowSource). 
+typedef std::function<std::unique_ptr<RowSource>()> RowSourceFactory; 
+
+// K_Means su una raccolta di immagini troppo grande per la memoria, per 
+// esempio per una palette comune a migliaia di foto: ogni iterazione legge 
+// le immagini a blocchi di chunkRows righe, assegna i pixel di ogni blocco 
+// e ne somma le componenti nei Cluster, e i centroidi vengono aggiornati una 
+// volta sola per tutta la raccolta. Ogni immagine viene aperta dalla sua 
+// funzione solo quando serve e deve essere CV_8UC3; mentre un blocco viene 
+// assegnato, un altro thread legge il successivo. 
+// Se centroyds è vuoto, un primo passaggio sulla raccolta ne estrae un 
+// campione casuale di pixel, da cui vengono scelti i centroidi iniziali 
+// (come indicato da options.seeding); alla fine centroyds contiene i 
+// centroidi finali. Delle opzioni valgono threads, seeding, sampleSeed e 
+// onIteration: senza le etichette dei pixel l'algoritmo si ferma solo 
+// quando nessun centroide si sposta più di thr, e le statistiche non 
+// contano i pixel riassegnati. 
+void StreamK_Means(const std::vector<RowSourceFactory>& images, int k, int iterations, int thr, int chunkRows, std::vector<cv::Vec3b>& centroyds, const KMeansOptions& options = KMeansOptions()); 
+
+#endif
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include <opencv2/opencv.hpp>
+#include "K-Means.hpp"
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    // Si legge l'immagine di input da riga di comando, che deve 
+    // essere a colori. 
+    String inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_ANYCOLOR);
+
+    // Si mostra l'immagine all'interno di una apposita finestra. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage); 
+
+    // Da riga di comando si prendono anche i parametri: 
+    // k:          numero di Cluster da creare, 
+    // iterations: numero di iterazione da fare al massimo, 
+    // threshold:  il valore che la distanza deve superare per poter 
+    //             permettere all'algoritmo di continuare. 
+    int k = atoi(argv[2]); 
+    int iterations = atoi(argv[3]); 
+    int threshold = atoi(argv[4]); 
+
+    // Per ogni iterazione si stampano la durata, l'inerzia e il numero dei 
+    // pixel che hanno cambiato Cluster, per scegliere il numero di iterazioni. 
+    KMeansOptions options; 
+    options.onIteration = [](const KMeansIterationStats& stats) {
+        printf("iterazione %d: %.1f ms, inerzia %.0f, pixel riassegnati %lld, spostamento massimo %.2f%s\n", 
+               stats.iteration, stats.milliseconds, stats.inertia, static_cast<long long>(stats.reassigned), 
+               stats.maxShift, stats.converged ? " (convergenza)" : ""); 
+    }; 
+
+    Mat resultImage = K_Means(inputImage, k, iterations, threshold, options);
+
+    // Il risultato finale viene mostrato in un'apposita finestra. 
+    namedWindow("K-Means Image", WINDOW_AUTOSIZE); 
+    imshow("K-Means Image", resultImage); 
+
+    waitKey(0); 
+
+    return 0; 
+}
\ No newline at end of file
@@ -1,125 +1,302 @@
+#include <algorithm>
 #include <cstdio>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 #include <opencv2/opencv.hpp>
+#include "CpuDispatch.hpp"
+#include "LowHighPass.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
 
 using namespace std; 
 using namespace cv; 
 
-Mat Average(Mat& src);
-Mat Median(Mat& src);
+// L'indice della riga (o della colonna) p riflessa dentro un'immagine di n 
+// righe, senza ripetere il pixel del bordo (gfedcb|abcdefgh|gfedcba), come 
+// BORDER_REFLECT_101 di OpenCV. Con raggi più grandi dell'immagine la 
+// riflessione si ripete. 
+static int Reflect101(int p, int n) {
+    if(n == 1) {
+        return 0; 
+    }
+    while(p < 0 || p >= n) {
+        p = p < 0 ? -p : 2*n-2-p; 
+    }
+    return p; 
+}
 
-Mat Average(Mat& src) {
-    // Questa dichiarata è la maschera che conterrà gli elementi selezionati 
-    // dall'immagine originale. In questo caso la maschera è 3x3. 
-    Mat maskFromSrc; 
-    Mat resultImg(src.rows, src.cols, src.type()); 
-    int summary = 0; 
-    
-    // Con i primi due cicli for annidati scorriamo sulle righe e sulle colonne 
-    // dell'immagine originale. Ad ogni passo del ciclo for più interno assegnamo 
-    // alla maschera solo una specifica porzione dell'immagine originale, definita 
-    // dal range esplicitato. 
-    for(int i = 0; i < src.rows-2; i++) {
-        for(int j = 0; j < src.cols-2; j++) {
-            maskFromSrc = src(Range(i, i+3), Range(j, j+3));
-
-            // I due cicli for annidati più interni scorrono sulla maschera, sommano 
-            // quindi gli elementi della maschera ed inseriscono il risultato nella 
-            // variabile intera summary. 
-            for(int z = 0; z < maskFromSrc.rows; z++) {
-                for(int x = 0; x < maskFromSrc.cols; x++) {
-                    summary += static_cast<int>(maskFromSrc.at<uchar>(z, x)); 
-                }
-            } 
-
-            // Alla fine summary deve essere divisa per la grandezza della maschera,
-            // che in questo caso è 3x3, quindi 9. Il risultato deve essere il pixel 
-            // centrale dell'immagine risultante. 
-            summary = static_cast<int>(summary/9); 
-            resultImg.at<uchar>(i+1, j+1) = static_cast<int>(summary); 
-            summary = 0;  
+Mat Average(Mat& src, int radius) {
+    IPA_TRACE_SCOPE("Average", src.total()); 
+
+    if(radius < 0) {
+        throw invalid_argument("the radius of the average filter must not be negative: " + to_string(radius)); 
+    }
+
+    // La maschera è (2*radius+1)x(2*radius+1), ed ogni pixel del risultato è 
+    // la media dei pixel inquadrati, arrotondata. Invece di risommare tutta la 
+    // maschera per ogni pixel si tengono le somme delle colonne della finestra 
+    // verticale corrente: scendendo di una riga si aggiunge la riga che entra 
+    // e si toglie quella che esce, e lungo la riga le somme orizzontali sono 
+    // differenze di somme prefisse. Il costo per pixel non dipende dal raggio. 
+    // Ai bordi l'immagine viene riflessa, come in cv::blur. 
+    int rows = src.rows; 
+    int cols = src.cols; 
+    int window = 2*radius+1; 
+    int area = window*window; 
+    Mat resultImg = Mat::zeros(rows, cols, src.type()); 
+    if(rows == 0 || cols == 0) {
+        return resultImg; 
+    }
+
+    // La somma delle righe e la divisione sono i kernel vettoriali scelti 
+    // all'avvio per la CPU (CpuDispatch.hpp). 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    vector<int> columnSums(cols, 0); 
+    vector<uint32_t> prefix(cols+window, 0); 
+
+    for(int i = -radius; i <= radius; i++) {
+        kernels.accumulateRow(columnSums.data(), src.ptr<uchar>(Reflect101(i, rows)), cols, 1); 
+    }
+
+    for(int i = 0; i < rows; i++) {
+        if(i > 0) {
+            kernels.accumulateRow(columnSums.data(), src.ptr<uchar>(Reflect101(i+radius, rows)), cols, 1); 
+            kernels.accumulateRow(columnSums.data(), src.ptr<uchar>(Reflect101(i-radius-1, rows)), cols, -1); 
+        }
+
+        // Le somme prefisse della riga di somme, con le colonne riflesse. 
+        uint32_t running = 0; 
+        for(int k = 0; k < cols+window-1; k++) {
+            int column = k-radius; 
+            running += columnSums[column >= 0 && column < cols ? column : Reflect101(column, cols)]; 
+            prefix[k+1] = running; 
         }
+
+        kernels.divideRow(prefix.data(), cols, window, area, resultImg.ptr<uchar>(i)); 
     }
 
     // Alla fine si restituisce l'immagine risultante. 
     return resultImg; 
 }
 
-Mat Median(Mat& src) {
-    Mat maskFromSrc; 
-    Mat resultImg(src.rows, src.cols, src.type());
-
-    // Nell'applicazione del filtro mediana abbiamo bisogno di una variabile 
-    // per il mediano di un vettore, ed appunto un vettore di dimensione pari 
-    // alla grandezza della maschera, in questo caso 3x3, quindi 9. 
-    int medianValue = 0; 
-    vector<int> medianVector(9); 
-
-    // I due cicli for annidati scorrono sull'immagine originale, e creano la 
-    // maschera di dimensione 3x3 con gli elementi presi dall'immagine in input. 
-    for(int i = 0; i < src.rows-2; i++) {
-        for(int j = 0; j < src.cols-2; j++) {
-            maskFromSrc = src(Range(i, i+3), Range(j, j+3));
-
-            // A questo punto, con i due cicli annidati si vanno a selezionare 
-            // tutti gli elementi della maschera e li si inserisce all'interno 
-            // del vettore, dalla testa o dalla coda, non ha importanza dato che 
-            // saranno in seguito ordinati. 
-            for(int z = 0; z < maskFromSrc.rows; z++) {
-                for(int x = 0; x < maskFromSrc.cols; x++) {
-                    medianVector.push_back((maskFromSrc.at<uchar>(z, x))); 
+// Il filtro mediana usa istogrammi a due livelli: 256 livelli di grigio 
+// (fine) e 16 gruppi di 16 livelli (coarse), per trovare la mediana con al 
+// più 16+16 passi invece di 256. 
+static const int fineBins = 256; 
+static const int coarseBins = 16; 
+
+// Aggiunge all'istogramma della maschera la colonna che entra e toglie 
+// quella che esce (i contatori sono a 16 bit, il compilatore vettorizza). 
+static void SlideHistogram(uint16_t* kernel, const uint16_t* entering, const uint16_t* leaving, int bins) {
+    for(int k = 0; k < bins; k++) {
+        kernel[k] = static_cast<uint16_t>(kernel[k] + entering[k] - leaving[k]); 
+    }
+}
+
+// Le righe [firstRow, lastRow) del filtro mediana (l'algoritmo di Perreault 
+// e Hébert). Per ogni colonna dell'immagine si tiene l'istogramma dei pixel 
+// della finestra verticale corrente: scendendo di una riga ogni istogramma 
+// perde un pixel e ne guadagna uno. L'istogramma della maschera si sposta 
+// lungo la riga sommando l'istogramma della colonna che entra e togliendo 
+// quello della colonna che esce, quindi il costo per pixel non dipende dal 
+// raggio. Ai bordi si ripetono i pixel del bordo, come in cv::medianBlur. 
+static void MedianBand(const Mat& src, Mat& resultImg, int radius, int firstRow, int lastRow) {
+    IPA_TRACE_SCOPE("MedianBand", static_cast<int64_t>(lastRow - firstRow) * src.cols); 
+
+    int rows = src.rows; 
+    int cols = src.cols; 
+    int window = 2*radius+1; 
+    int rank = window*window/2; 
+
+    vector<uint16_t> columnFine(static_cast<size_t>(cols) * fineBins, 0); 
+    vector<uint16_t> columnCoarse(static_cast<size_t>(cols) * coarseBins, 0); 
+
+    auto clampRow = [rows](int i) { return min(max(i, 0), rows-1); }; 
+    auto clampCol = [cols](int j) { return min(max(j, 0), cols-1); }; 
+
+    auto addRow = [&](int i) {
+        const uchar* row = src.ptr<uchar>(clampRow(i)); 
+        for(int j = 0; j < cols; j++) {
+            columnFine[j*fineBins + row[j]]++; 
+            columnCoarse[j*coarseBins + (row[j] >> 4)]++; 
+        }
+    }; 
+    auto removeRow = [&](int i) {
+        const uchar* row = src.ptr<uchar>(clampRow(i)); 
+        for(int j = 0; j < cols; j++) {
+            columnFine[j*fineBins + row[j]]--; 
+            columnCoarse[j*coarseBins + (row[j] >> 4)]--; 
+        }
+    }; 
+
+    for(int i = firstRow-radius; i <= firstRow+radius; i++) {
+        addRow(i); 
+    }
+
+    // Gli istogrammi della maschera stanno sullo stack: nessuna allocazione 
+    // per pixel. 
+    uint16_t kernelFine[fineBins]; 
+    uint16_t kernelCoarse[coarseBins]; 
+
+    for(int i = firstRow; i < lastRow; i++) {
+        if(i > firstRow) {
+            addRow(i+radius); 
+            removeRow(i-radius-1); 
+        }
+
+        fill(kernelFine, kernelFine + fineBins, 0); 
+        fill(kernelCoarse, kernelCoarse + coarseBins, 0); 
+        for(int c = -radius; c <= radius; c++) {
+            const uint16_t* fine = &columnFine[clampCol(c)*fineBins]; 
+            const uint16_t* coarse = &columnCoarse[clampCol(c)*coarseBins]; 
+            for(int k = 0; k < fineBins; k++) {
+                kernelFine[k] += fine[k]; 
+            }
+            for(int k = 0; k < coarseBins; k++) {
+                kernelCoarse[k] += coarse[k]; 
+            }
+        }
+
+        uchar* out = resultImg.ptr<uchar>(i); 
+        for(int j = 0; j < cols; j++) {
+            if(j > 0) {
+                int entering = clampCol(j+radius); 
+                int leaving = clampCol(j-radius-1); 
+                if(entering != leaving) {
+                    SlideHistogram(kernelFine, &columnFine[entering*fineBins], &columnFine[leaving*fineBins], fineBins); 
+                    SlideHistogram(kernelCoarse, &columnCoarse[entering*coarseBins], &columnCoarse[leaving*coarseBins], coarseBins); 
                 }
             }
 
-            // Per poter scegliere l'elemento mediano abbiamo bisogno di ordinare 
-            // il vettore, e lo facciamo con la funzione di c++ sort(). 
-            sort(medianVector.begin(), medianVector.end());
+            // La mediana è l'elemento di indice rank dei window*window pixel 
+            // ordinati: prima si trova il gruppo che lo contiene, poi il 
+            // livello di grigio dentro il gruppo. 
+            int count = 0; 
+            int group = 0; 
+            while(count + kernelCoarse[group] <= rank) {
+                count += kernelCoarse[group]; 
+                group++; 
+            }
+            int value = group*coarseBins; 
+            while(count + kernelFine[value] <= rank) {
+                count += kernelFine[value]; 
+                value++; 
+            }
+            out[j] = static_cast<uchar>(value); 
+        }
+    }
+}
 
-            // In seguito l'elemento mediano lo si ottiene dividendo la grandezza 
-            // del vettore per 2 e sommandola ad 1. L'elemento selezionato viene 
-            // inserito in medianValue. 
-            medianValue = medianVector.at((medianVector.size()/2)+1);
+// Le righe [firstRow, lastRow) del filtro mediana 3x3 o 5x5 con le reti di 
+// ordinamento di Paeth e Devillard (19 e 99 scambi, il kernel 
+// medianNetworkRow di CpuDispatch.hpp), che ordinano molti pixel 
+// consecutivi della riga alla volta. Le righe della finestra vengono copiate 
+// in righe allargate di radius pixel per lato, ripetendo i pixel del bordo 
+// (come fa l'algoritmo con gli istogrammi), così ogni blocco di pixel si 
+// legge senza controlli. 
+template<int radius>
+static void MedianNetworkBand(const Mat& src, Mat& resultImg, int firstRow, int lastRow) {
+    IPA_TRACE_SCOPE("MedianNetworkBand", static_cast<int64_t>(lastRow - firstRow) * src.cols); 
 
-            // Il pixel centrale dell'immagine adesso è quell'elemento mediano. 
-            resultImg.at<uchar>(i+1, j+1) = static_cast<int>(medianValue); 
+    const PixelKernels& kernels = ActivePixelKernels(); 
+    const int window = 2*radius+1; 
+    int rows = src.rows; 
+    int cols = src.cols; 
+    int paddedCols = cols + 2*radius; 
 
-            // Si resetta il valore medianValue a 0, cosi come si cancellano tutti 
-            // gli elementi presenti nel vettore. 
-            medianValue = 0; 
-            medianVector.clear();
+    // Le righe allargate stanno in un anello: la riga r della sorgente va 
+    // nello slot r % window, e cached ricorda quale riga contiene ogni slot. 
+    vector<uchar> ring(static_cast<size_t>(window) * paddedCols); 
+    int cached[window]; 
+    fill(cached, cached + window, -1); 
+    const uchar* padded[window]; 
+
+    for(int i = firstRow; i < lastRow; i++) {
+        for(int dy = 0; dy < window; dy++) {
+            int r = min(max(i+dy-radius, 0), rows-1); 
+            uchar* slot = &ring[static_cast<size_t>(r % window) * paddedCols]; 
+            if(cached[r % window] != r) {
+                const uchar* row = src.ptr<uchar>(r); 
+                fill(slot, slot + radius, row[0]); 
+                copy(row, row + cols, slot + radius); 
+                fill(slot + radius + cols, slot + paddedCols, row[cols-1]); 
+                cached[r % window] = r; 
+            }
+            padded[dy] = slot; 
         }
-    }
 
-    // Alla fine si restituisce l'immagine risultante. 
-    return resultImg; 
+        kernels.medianNetworkRow(padded, radius, cols, resultImg.ptr<uchar>(i)); 
+    }
 }
 
-int main(int argc, char *argv[]) {
-    string inputFile = argv[1]; 
-    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE); 
+Mat Median(Mat& src, int radius, int threads) {
+    IPA_TRACE_SCOPE("Median", src.total()); 
+
+    // I contatori a 16 bit bastano finché la maschera ha meno di 65536 pixel. 
+    if(radius < 0 || radius > 127) {
+        throw invalid_argument("the radius of the median filter must be between 0 and 127: " + to_string(radius)); 
+    }
 
-    // Richiamiamo la funzione Average su inputImage, ed assegniamo 
-    // il suo risultato all'oggetto average. 
-    Mat average; 
-    average = Average(inputImage); 
+    Mat resultImg(src.rows, src.cols, src.type()); 
+    if(src.rows == 0 || src.cols == 0) {
+        return resultImg; 
+    }
 
-    // Richiamiamo la funzione Median su inputImage, ed assegniamo 
-    // il suo risultato all'oggetto median. 
-    Mat median; 
-    median = Median(inputImage); 
-    
-    // Alla fine mostriamo tutte le immagini (compresa quella originale)
-    // in apposite finestre. 
-    namedWindow("Average Image", WINDOW_AUTOSIZE);
-    imshow("Average Image", average);
+    // Con raggio 1 e 2 le reti di ordinamento sono più veloci degli 
+    // istogrammi, e danno lo stesso risultato. 
+    function<void(int, int)> medianBand = [&src, &resultImg, radius](int firstRow, int lastRow) {
+        if(radius == 1) {
+            MedianNetworkBand<1>(src, resultImg, firstRow, lastRow); 
+        } else if(radius == 2) {
+            MedianNetworkBand<2>(src, resultImg, firstRow, lastRow); 
+        } else {
+            MedianBand(src, resultImg, radius, firstRow, lastRow); 
+        }
+    }; 
 
-    namedWindow("Original Image", WINDOW_AUTOSIZE);
-    imshow("Original Image", inputImage);
+    // Le bande di righe sono indipendenti, e ognuna ha i suoi istogrammi 
+    // delle colonne: ogni banda deve essere abbastanza alta da ammortizzare 
+    // la costruzione iniziale degli istogrammi (2*radius+1 righe). 
+    int maxThreads = threads > 0 ? threads : DefaultThreadCount(); 
+    int minBandRows = max(32, 4*(2*radius+1)); 
+    int bands = max(1, min(maxThreads, src.rows / minBandRows)); 
 
-    namedWindow("Median Image", WINDOW_AUTOSIZE);
-    imshow("Median Image", median);
+    if(bands == 1) {
+        medianBand(0, src.rows); 
+        return resultImg; 
+    }
 
-    waitKey(0); 
+    ThreadPool pool(bands); 
+    for(int b = 0; b < bands; b++) {
+        int firstRow = static_cast<int>(static_cast<int64_t>(src.rows) * b / bands); 
+        int lastRow = static_cast<int>(static_cast<int64_t>(src.rows) * (b+1) / bands); 
+        pool.Submit([&medianBand, firstRow, lastRow] {
+            medianBand(firstRow, lastRow); 
+        }); 
+    }
+    pool.Wait(); 
 
-    return 0; 
-}
\ No newline at end of file
+    // Alla fine si restituisce l'immagine risultante. 
+    return resultImg; 
+}
+
+// Entrambi i filtri scrivono la riga i a partire dalle righe 
+// i-radius..i+radius (riflesse o ripetute ai bordi dell'immagine, che 
+// coincidono con i bordi della banda). Le bande sono già elaborate una alla 
+// volta, quindi il filtro mediana usa un solo thread per banda. 
+StripStage AverageStage(int radius) {
+    return {"Average", radius, radius, 0, [radius](const Mat& band) {
+        Mat input = band; 
+        return Average(input, radius); 
+    }}; 
+}
+
+StripStage MedianStage(int radius) {
+    return {"Median", radius, radius, 0, [radius](const Mat& band) {
+        Mat input = band; 
+        return Median(input, radius, 1); 
+    }}; 
+}
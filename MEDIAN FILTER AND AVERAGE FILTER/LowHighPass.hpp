@@ -0,0 +1,20 @@
+#ifndef LOW_HIGH_PASS_HPP
+#define LOW_HIGH_PASS_HPP
+
+#include <opencv2/opencv.hpp>
+#include "StripStreaming.hpp"
+
+// Filtro media e filtro mediana con una maschera (2*radius+1)x(2*radius+1), 
+// con un costo per pixel che non dipende dal raggio. Il filtro media riflette 
+// i bordi, il filtro mediana ripete i pixel del bordo (raggio fino a 127) e 
+// divide l'immagine in bande di righe su threads thread (con 0, uno per 
+// core); le maschere 3x3 e 5x5 usano reti di ordinamento vettoriali. 
+// L'immagine in input deve essere in scala di grigi. 
+cv::Mat Average(cv::Mat& src, int radius = 1);
+cv::Mat Median(cv::Mat& src, int radius = 1, int threads = 0);
+
+// Gli stessi filtri come fasi della elaborazione a bande (StreamStrips). 
+StripStage AverageStage(int radius = 1);
+StripStage MedianStage(int radius = 1);
+
+#endif
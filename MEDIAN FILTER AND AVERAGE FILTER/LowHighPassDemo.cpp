@@ -0,0 +1,37 @@
+#include <cstdio>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "LowHighPass.hpp"
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char *argv[]) {
+    string inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE); 
+
+    // Richiamiamo la funzione Average su inputImage, ed assegniamo 
+    // il suo risultato all'oggetto average. 
+    Mat average; 
+    average = Average(inputImage); 
+
+    // Richiamiamo la funzione Median su inputImage, ed assegniamo 
+    // il suo risultato all'oggetto median. 
+    Mat median; 
+    median = Median(inputImage); 
+    
+    // Alla fine mostriamo tutte le immagini (compresa quella originale)
+    // in apposite finestre. 
+    namedWindow("Average Image", WINDOW_AUTOSIZE);
+    imshow("Average Image", average);
+
+    namedWindow("Original Image", WINDOW_AUTOSIZE);
+    imshow("Original Image", inputImage);
+
+    namedWindow("Median Image", WINDOW_AUTOSIZE);
+    imshow("Median Image", median);
+
+    waitKey(0); 
+
+    return 0; 
+}
\ No newline at end of file
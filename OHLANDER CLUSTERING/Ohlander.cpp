@@ -2,38 +2,86 @@
 #include <cstdio>
 #include <vector>
 #include <opencv2/opencv.hpp>
+#include "Ohlander.hpp"
+#include "Trace.hpp"
 
 using namespace cv; 
 using namespace std;
 
 // We describe the functions to use in the algorithm. 
-void Ohlander(Mat, int);
-pair<int, int> ComputeMidPoint(Mat, Mat, int); 
-void ComputeMasks(Mat, Mat, int, int); 
+static void Ohlander(Mat, int);
+static pair<int, int> ComputeMidPoint(Mat, Mat, int); 
+static void ComputeMasks(Mat, Mat, int, int); 
 
 // channels is relative to the three channels of the color RGB, 
 // channelsMat is relative to the output of calcHist() function 
 // of openCV to compute the histogram of an image (in this case
-// the histogram of the three colors).  
-Mat channels[3]; 
-Mat channelsMat[3]; 
+// the histogram of the three colors). The state of the algorithm 
+// is kept per thread, so that different images can be segmented 
+// at the same time by different threads. 
+static thread_local Mat channels[3]; 
+static thread_local Mat channelsMat[3]; 
 
 // resultsMask is the vector that contains the mask that correspond
 // to the cluster of the image. In particular we push a mask into 
 // this vector when we cannot split its histogram into two masks 
 // because the histogram has not two peak.  
-vector<Mat> resultsMask; 
-vector<Mat> maskToApply;
+static thread_local vector<Mat> resultsMask; 
+static thread_local vector<Mat> maskToApply;
 
 // These variables are relative to the calcHist function that compute 
 // the histogram with a particular mask. 
-int histSize = 256;
-float range[] = { 0, 256 } ;
-const float* histRange = { range };
-bool uniformHist = true; 
-bool accumulateHist = false;
+static const int histSize = 256;
+static const float range[] = { 0, 256 } ;
+static const float* histRange = { range };
+static const bool uniformHist = true; 
+static const bool accumulateHist = false;
 
-void Ohlander(Mat src, int thr) {
+Mat OhlanderSegmentation(Mat src, int thr) {
+    IPA_TRACE_SCOPE("OhlanderSegmentation", src.total()); 
+
+    // To remove the eventual noise we can apply on the input image
+    // a GaussianBlur to smooth the original image. 
+    Mat inputImage; 
+    GaussianBlur(src, inputImage, Size(5, 5), 8); 
+
+    // This function split the input image into its three component: R, G, B. 
+    split(inputImage, channels); 
+
+    // The first mask to push into the vector is the mask that cover all the image. 
+    // The vectors are cleared because they can contain the masks of a previous call. 
+    resultsMask.clear(); 
+    maskToApply.clear(); 
+    Mat firstMask = Mat(inputImage.size(), CV_8UC1, Scalar::all(1)); 
+    maskToApply.push_back(firstMask); 
+
+    // We call the algorithm.  
+    Ohlander(inputImage, thr); 
+
+    // At the end we declare the output matrix for the image. 
+    Mat outputImage = Mat(inputImage.size(), inputImage.type(), Scalar::all(0)); 
+    RNG rng(12345); 
+
+    // For the results masks we make a random color and we assign it to the different 
+    // regions founded with Ohlander.  
+    for(int i = 0; i < resultsMask.size(); i++) {
+        Vec3b color = Vec3b(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
+        for(int x = 0; x < inputImage.rows; x++) {
+            for(int y = 0; y < inputImage.cols; y++) {
+                if(resultsMask.at(i).at<uchar>(x, y) != 0) {
+                    outputImage.at<Vec3b>(x, y) = color; 
+                }
+            }
+        }
+    }
+
+    // The masks are not needed anymore, so we release them. 
+    resultsMask.clear(); 
+
+    return outputImage; 
+}
+
+static void Ohlander(Mat src, int thr) {
     // The algorithm extract from vector the mask until he is empty, 
     // and then he pop the element from the same vector. 
     while(!maskToApply.empty()) {
@@ -86,7 +134,7 @@ void Ohlander(Mat src, int thr) {
     }
 }
 
-pair<int, int> ComputeMidPoint(Mat histogram, Mat src, int thr) {
+static pair<int, int> ComputeMidPoint(Mat histogram, Mat src, int thr) {
     // The theory says that might be more than two peak, and at the 
     // same time more than one valley, so we use a blur on the histogram 
     // to smooth the peak and the valley, with an advance in computation time.  
@@ -143,7 +191,7 @@ pair<int, int> ComputeMidPoint(Mat histogram, Mat src, int thr) {
     return toReturn; 
 }
 
-void ComputeMasks(Mat histogram, Mat src, int valley, int index) { 
+static void ComputeMasks(Mat histogram, Mat src, int valley, int index) { 
     // We should create two masks, that are the clone of the principal 
     // histogram, because we need to split this. 
     Mat left = histogram.clone(); 
@@ -193,60 +241,3 @@ void ComputeMasks(Mat histogram, Mat src, int valley, int index) {
     maskToApply.push_back(leftMask); 
     maskToApply.push_back(rightMask); 
 }
-
-int main(int argc, char *argv[]) {
-    if(argc != 3) {
-        cout << "Usage: ./[program-name] [image-name].[image-format] [threshold]" << endl;
-        exit(0);  
-    }
-
-    // We read the input image (colored). 
-    String inputName = argv[1]; 
-    Mat inputImage = imread(inputName, IMREAD_COLOR);
-
-    // To remove the eventual noise we can apply on the input image
-    // a GaussianBlur to smooth the original image. 
-    GaussianBlur(inputImage, inputImage, Size(5, 5), 8); 
-
-    // This function split the input image into its three component: R, G, B. 
-    split(inputImage, channels); 
-
-    // The first mask to push into the vector is the mask that cover all the image.  
-    Mat firstMask = Mat(inputImage.size(), CV_8UC1, Scalar::all(1)); 
-    maskToApply.push_back(firstMask); 
-
-    // We read the threshold. 
-    int thr = atoi(argv[2]);
-
-    // We call the algorithm.  
-    Ohlander(inputImage, thr); 
-
-    // This function show the image into a window.  
-    namedWindow("Original Image", WINDOW_AUTOSIZE);
-    imshow("Original Image", inputImage); 
-    
-    // At the end we declare the output matrix for the image. 
-    Mat outputImage = Mat(inputImage.size(), inputImage.type(), Scalar::all(0)); 
-    RNG rng(12345); 
-
-    // For the results masks we make a random color and we assign it to the different 
-    // regions founded with Ohlander.  
-    for(int i = 0; i < resultsMask.size(); i++) {
-        Vec3b color = Vec3b(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
-        for(int x = 0; x < inputImage.rows; x++) {
-            for(int y = 0; y < inputImage.cols; y++) {
-                if(resultsMask.at(i).at<uchar>(x, y) != 0) {
-                    outputImage.at<Vec3b>(x, y) = color; 
-                }
-            }
-        }
-    }
-
-    // The result is shown into a specific window.  
-    namedWindow("Computed Image", WINDOW_AUTOSIZE);
-    imshow("Computed Image", outputImage);
-    
-    waitKey(0);  
-
-    return 0; 
-}
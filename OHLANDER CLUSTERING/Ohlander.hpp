@@ -0,0 +1,11 @@
+#ifndef OHLANDER_HPP
+#define OHLANDER_HPP
+
+#include <opencv2/opencv.hpp>
+
+// The function takes a colored image and the threshold for the distance 
+// between two peaks of an histogram, and returns the image with a random 
+// color assigned to every region found by the Ohlander algorithm. 
+cv::Mat OhlanderSegmentation(cv::Mat src, int thr);
+
+#endif
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Ohlander.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    if(argc != 3) {
+        cout << "Usage: ./[program-name] [image-name].[image-format] [threshold]" << endl;
+        exit(0);  
+    }
+
+    // We read the input image (colored). 
+    String inputName = argv[1]; 
+    Mat inputImage = imread(inputName, IMREAD_COLOR);
+
+    // We read the threshold. 
+    int thr = atoi(argv[2]);
+
+    // We call the algorithm, that blurs the image, splits it into its three 
+    // channels and colors the regions founded with Ohlander. 
+    Mat outputImage = OhlanderSegmentation(inputImage, thr); 
+
+    // This function show the image into a window.  
+    namedWindow("Original Image", WINDOW_AUTOSIZE);
+    imshow("Original Image", inputImage); 
+
+    // The result is shown into a specific window.  
+    namedWindow("Computed Image", WINDOW_AUTOSIZE);
+    imshow("Computed Image", outputImage);
+    
+    waitKey(0);  
+
+    return 0; 
+}
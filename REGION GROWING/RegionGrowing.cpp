@@ -4,6 +4,8 @@
 #include <unistd.h>
 #include <math.h>
 #include <opencv2/opencv.hpp>
+#include "RegionGrowing.hpp"
+#include "Trace.hpp"
 
 using namespace cv; 
 using namespace std;
@@ -21,9 +23,9 @@ class RegionPoint {
     }
 }; 
 
-Mat StartGrow(Mat& src, int thr);
-
 Mat StartGrow(Mat& src, int thr) {
+    IPA_TRACE_SCOPE("StartGrow", src.total()); 
+
     // La prima matrice conterrà le regioni che sono state trovate, la
     // seconda matrice conterrà i pixel che sono stati visitati o meno. 
     // Nel senso: se un pixel è stato visitato allora viene posto a 1, 
@@ -109,26 +111,3 @@ Mat StartGrow(Mat& src, int thr) {
     // Alla fine restituiamo il risultato finale. 
     return clonedSrc; 
 }
-
-int main(int argc, char *argv[]) {
-    // Leggiamo l'immagine da riga di comando. 
-    string inputFile = argv[1]; 
-    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
-
-    // Si mostra l'immagine originale in una apposita finestra. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE); 
-    imshow("Original Image", inputImage);
-
-    // Si applica la funzione per il Region Growing con in input 
-    // l'immagine e il valore di thresholding. 
-    Mat regionGrowingImage = StartGrow(inputImage, atoi(argv[2]));  
-
-    // Il risultato dell'operazione viene mostrato in una
-    // apposita finestra. 
-    namedWindow("Region Growing Image", WINDOW_AUTOSIZE); 
-    imshow("Region Growing Image", regionGrowingImage);
-
-    waitKey(0); 
-
-    return 0;  
-}
\ No newline at end of file
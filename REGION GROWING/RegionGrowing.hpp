@@ -0,0 +1,11 @@
+#ifndef REGION_GROWING_HPP
+#define REGION_GROWING_HPP
+
+#include <opencv2/opencv.hpp>
+
+// La funzione fa crescere le regioni dell'immagine (in scala di grigi) 
+// a partire dai seed, il threshold è la massima differenza ammessa tra 
+// il valore del seed e quello di un pixel della regione. 
+cv::Mat StartGrow(cv::Mat& src, int thr);
+
+#endif
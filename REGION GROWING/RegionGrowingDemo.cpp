@@ -0,0 +1,33 @@
+#include <cstdio>
+#include <iostream>
+#include <stack>
+#include <unistd.h>
+#include <math.h>
+#include <opencv2/opencv.hpp>
+#include "RegionGrowing.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    // Leggiamo l'immagine da riga di comando. 
+    string inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
+
+    // Si mostra l'immagine originale in una apposita finestra. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage);
+
+    // Si applica la funzione per il Region Growing con in input 
+    // l'immagine e il valore di thresholding. 
+    Mat regionGrowingImage = StartGrow(inputImage, atoi(argv[2]));  
+
+    // Il risultato dell'operazione viene mostrato in una
+    // apposita finestra. 
+    namedWindow("Region Growing Image", WINDOW_AUTOSIZE); 
+    imshow("Region Growing Image", regionGrowingImage);
+
+    waitKey(0); 
+
+    return 0;  
+}
\ No newline at end of file
@@ -1,41 +1,11 @@
 #include <iostream>
 #include <cstdio>
 #include <opencv2/opencv.hpp>
+#include "SplitAndMerge.hpp"
 
 using namespace cv; 
 using namespace std;
 
-// Definiamo una struttura per contenere le informazioni relative
-// ad una particolare regione. 
-// regionRect:   il rettangolo che corrisponde alla porzione di 
-//               regione da considerare (relativa alla immagine);  
-// regionSrc:    l'immagine relativa alla porzione di regione che 
-//               viene considerata; 
-// colorSrc:     il colore del pixel che viene calcolato con la 
-//               funzione di OpenCV meanStdDev() che calcola la 
-//               deviazione standard e la media di un set di dati; 
-// regionChilds: è la lista dei nodi figli dell'attuale regione, 
-//               ossia le regioni che sono state ottenute dalla 
-//               suddivisione della regione attuale in quattro. 
-// regionActive: è un flag che indica che se la regione che siamo 
-//               elaborando deve essere considerata per la
-//               colorazione finale per l'ottenimento dell'immagine 
-//               finale. 
-struct Region {
-    Rect regionRect;
-    Mat regionSrc;
-    Scalar colorSrc; 
-    vector<Region> regionChilds; 
-
-    bool regionActive;  
-}; 
-
-Region Split(Mat src, Rect rec, int thr);
-bool CheckHomogeneity(Mat region, int thr); 
-bool MergeRegion(Mat src, Region R1, Region R2, int thr);  
-void Merge(Mat src, Region R, int thr); 
-void Fill(Mat src, Region region); 
-
 Region Split(Mat src, Rect rec, int thr) {
     // La funzione Split è una funzione ricorsiva, ogni volta che viene richiamata viene 
     // creata una regione corrente che dovrà o meno essere divisa in quattro sottoregioni. 
@@ -194,53 +164,3 @@ void Fill(Mat src, Region region) {
         Fill(src, region.regionChilds[i]); 
     }
 }
-
-int main(int argc, char *argv[]) {
-    // Viene letta l'immagine da riga di comando, ed inserita nella 
-    // variabile inputImage. 
-    String inputFile = argv[1]; 
-    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
-
-    // Quindi l'immagine originale viene mostrata all'interno di 
-    // un'apposita finestra. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE); 
-    imshow("Original Image", inputImage); 
-
-    int inputCols = inputImage.cols; 
-    int inputRows = inputImage.rows; 
-    int threshold = atoi(argv[2]); 
-    Mat resultImage = inputImage.clone(); 
-
-    // La prima regione da considerare è ovviamente l'immagine
-    // per intera, che viene data in input alla funzione di Split. 
-    Mat resultSrc = inputImage(Rect(0, 0, inputCols, inputRows)); 
-    Rect resultRect = Rect(0, 0, inputCols, inputRows); 
-
-    // Il primo passo da compiere sull'immagine risultante è quello di
-    // eseguire lo Split in sottoregioni. 
-    Region regionSplitted = Split(resultSrc, resultRect, threshold);
-    
-    // Una volta eseguito lo Split in sottoregioni, queste devono essere 
-    // fuse secondo i criteri descritti per ogni funzione utilizzata.  
-    Merge(inputImage, regionSplitted, threshold);
-
-    // Il passo finale è quello di colorare le regioni attive con i 
-    // relativi colori, per ottenere il risultato finale. 
-    Fill(resultImage, regionSplitted);
-
-    // Eseguiamo la post-elaborazione dell'immagine per rendere 
-    // le regioni che sono state ottenute più smussate. 
-    Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(5, 5));
-    dilate(resultImage, resultImage, kernel, Point(-1, -1), 2);
-    erode(resultImage, resultImage, kernel, Point(-1, -1), 2);
-    erode(resultImage, resultImage, kernel, Point(-1, -1), 2);
-    dilate(resultImage, resultImage, kernel, Point(-1, -1), 2); 
-
-    // L'immagine risultante viene mostrato in un'apposita finestra. 
-    namedWindow("Output Image", WINDOW_AUTOSIZE); 
-    imshow("Output Image", resultImage);
-
-    waitKey(0);  
-
-    return 0; 
-}
\ No newline at end of file
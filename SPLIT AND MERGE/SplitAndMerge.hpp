@@ -0,0 +1,38 @@
+#ifndef SPLIT_AND_MERGE_HPP
+#define SPLIT_AND_MERGE_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Definiamo una struttura per contenere le informazioni relative
+// ad una particolare regione. 
+// regionRect:   il rettangolo che corrisponde alla porzione di 
+//               regione da considerare (relativa alla immagine);  
+// regionSrc:    l'immagine relativa alla porzione di regione che 
+//               viene considerata; 
+// colorSrc:     il colore del pixel che viene calcolato con la 
+//               funzione di OpenCV meanStdDev() che calcola la 
+//               deviazione standard e la media di un set di dati; 
+// regionChilds: è la lista dei nodi figli dell'attuale regione, 
+//               ossia le regioni che sono state ottenute dalla 
+//               suddivisione della regione attuale in quattro. 
+// regionActive: è un flag che indica che se la regione che siamo 
+//               elaborando deve essere considerata per la
+//               colorazione finale per l'ottenimento dell'immagine 
+//               finale. 
+struct Region {
+    cv::Rect regionRect;
+    cv::Mat regionSrc;
+    cv::Scalar colorSrc; 
+    std::vector<Region> regionChilds; 
+
+    bool regionActive;  
+}; 
+
+Region Split(cv::Mat src, cv::Rect rec, int thr);
+bool CheckHomogeneity(cv::Mat region, int thr); 
+bool MergeRegion(cv::Mat src, Region R1, Region R2, int thr);  
+void Merge(cv::Mat src, Region R, int thr); 
+void Fill(cv::Mat src, Region region); 
+
+#endif
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <cstdio>
+#include <opencv2/opencv.hpp>
+#include "SplitAndMerge.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    // Viene letta l'immagine da riga di comando, ed inserita nella 
+    // variabile inputImage. 
+    String inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
+
+    // Quindi l'immagine originale viene mostrata all'interno di 
+    // un'apposita finestra. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage); 
+
+    int inputCols = inputImage.cols; 
+    int inputRows = inputImage.rows; 
+    int threshold = atoi(argv[2]); 
+    Mat resultImage = inputImage.clone(); 
+
+    // La prima regione da considerare è ovviamente l'immagine
+    // per intera, che viene data in input alla funzione di Split. 
+    Mat resultSrc = inputImage(Rect(0, 0, inputCols, inputRows)); 
+    Rect resultRect = Rect(0, 0, inputCols, inputRows); 
+
+    // Il primo passo da compiere sull'immagine risultante è quello di
+    // eseguire lo Split in sottoregioni. 
+    Region regionSplitted = Split(resultSrc, resultRect, threshold);
+    
+    // Una volta eseguito lo Split in sottoregioni, queste devono essere 
+    // fuse secondo i criteri descritti per ogni funzione utilizzata.  
+    Merge(inputImage, regionSplitted, threshold);
+
+    // Il passo finale è quello di colorare le regioni attive con i 
+    // relativi colori, per ottenere il risultato finale. 
+    Fill(resultImage, regionSplitted);
+
+    // Eseguiamo la post-elaborazione dell'immagine per rendere 
+    // le regioni che sono state ottenute più smussate. 
+    Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(5, 5));
+    dilate(resultImage, resultImage, kernel, Point(-1, -1), 2);
+    erode(resultImage, resultImage, kernel, Point(-1, -1), 2);
+    erode(resultImage, resultImage, kernel, Point(-1, -1), 2);
+    dilate(resultImage, resultImage, kernel, Point(-1, -1), 2); 
+
+    // L'immagine risultante viene mostrato in un'apposita finestra. 
+    namedWindow("Output Image", WINDOW_AUTOSIZE); 
+    imshow("Output Image", resultImage);
+
+    waitKey(0);  
+
+    return 0; 
+}
\ No newline at end of file
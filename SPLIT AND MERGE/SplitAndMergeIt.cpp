@@ -2,29 +2,17 @@
 #include <cstdio>
 #include <stack>
 #include <opencv2/opencv.hpp>
+#include "SplitAndMergeIt.hpp"
+#include "Trace.hpp"
 
 using namespace cv; 
 using namespace std; 
 
-// Definiamo la struttura dati per le informazioni relative alle 
-// regioni dell'immagine. In particolare abbiamo: 
-// regionRec: rettangolo che definisce la regione sull'immagine 
-//            originale; 
-// regionSrc: porzione dell'immagine che andiamo a considerare; 
-// regionCl:  colore della regione, che sarà utilizzato per colorare 
-//            appunto il rettangolo che stiamo considerando; 
-struct Region {
-    Rect regionRec; 
-    Mat regionSrc; 
-    Scalar regionCl;
-}; 
-
-stack<Region> Split(Mat src, Rect rec, int thr); 
-bool CheckHomogeneity(Mat src, int thr); 
-bool MergeRegion(Mat src, Region R1, Region R2, int thr); 
-void Merge(Mat src, stack<Region> regionList, int thr); 
+namespace iterative {
 
 stack<Region> Split(Mat src, Rect rec, int thr) {
+    IPA_TRACE_SCOPE("Split", rec.area()); 
+
     // Abbiamo bisogno di due stack, uno per le regioni che devono essere 
     // considerate per essere divise in 4 o meno, ed uno per quelle regioni 
     // che rispettano il criterio di omogeneità previsto. 
@@ -159,6 +147,8 @@ bool MergeRegion(Mat src, Region R1, Region R2, int thr) {
 }
 
 void Merge(Mat src, stack<Region> regionList, int thr) {
+    IPA_TRACE_SCOPE("Merge", src.total()); 
+
     // Il ciclo while prosegue fino a quando non si arriva 
     // ad avere solamente 4 elementi all'interno dello stack. 
     // Quindi si estraggono i quattro "nodi" dallo stack relativi 
@@ -211,49 +201,4 @@ void Merge(Mat src, stack<Region> regionList, int thr) {
     }
 }
 
-int main(int argc, char *argv[]) {
-    // Si legge l'immagine da riga di comando, e la si converte
-    // in grigio. 
-    String inputFile = argv[1]; 
-    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
-
-    // Per poter ottenere un risultato ottimale si applica un filtro Gaussiano 
-    // sull'immagine di input, la maschera è di dimensione 5x5, mentre la 
-    // deviazione standard è pari a 0. 
-    GaussianBlur(inputImage, inputImage, Size(5, 5), 0, 0);
-
-    // L'immagine originale viene mostrata in un'apposita finestra. 
-    namedWindow("Original Image", WINDOW_AUTOSIZE); 
-    imshow("Original Image", inputImage); 
-
-    int inputCols = inputImage.cols; 
-    int inputRows = inputImage.rows; 
-    int threshold = atoi(argv[2]); 
-    Mat resultImage = inputImage.clone(); 
-
-    Mat resultSrc = inputImage(Rect(0, 0, inputCols, inputRows)); 
-    Rect resultRect = Rect(0, 0, inputCols, inputRows);
-
-    // Viene richiamata la funzione di Split sull'immagine originale
-    // ed il risultato, essendo uno stack delle regioni ottenute viene 
-    // salvato in un apposito stack. Su tale stack viene effettuata 
-    // l'operazione di Merge.  
-    stack<Region> regionList = Split(resultSrc, resultRect, threshold); 
-    Merge(resultImage, regionList, threshold); 
-
-    // Si effettua sul risultato finale un processo di post-elaborazione 
-    // per poter smussare i contorni delle regioni calcolate. 
-    Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(5, 5));
-    dilate(resultImage, resultImage, kernel, Point(-1,-1), 2);
-    erode(resultImage, resultImage, kernel, Point(-1,-1), 2);
-    erode(resultImage, resultImage, kernel, Point(-1,-1), 2);
-    dilate(resultImage, resultImage, kernel, Point(-1,-1), 2);  
-
-    // Alla fine si mostra il risultato in un'apposita finestra. 
-    namedWindow("Output Image", WINDOW_AUTOSIZE); 
-    imshow("Output Image", resultImage);
-
-    waitKey(0);  
-
-    return 0; 
-}
\ No newline at end of file
+} // namespace iterative
@@ -0,0 +1,31 @@
+#ifndef SPLIT_AND_MERGE_IT_HPP
+#define SPLIT_AND_MERGE_IT_HPP
+
+#include <stack>
+#include <opencv2/opencv.hpp>
+
+// La versione iterativa dello Split and Merge, racchiusa nel namespace 
+// iterative per non entrare in conflitto con la versione ricorsiva. 
+namespace iterative {
+
+// Definiamo la struttura dati per le informazioni relative alle 
+// regioni dell'immagine. In particolare abbiamo: 
+// regionRec: rettangolo che definisce la regione sull'immagine 
+//            originale; 
+// regionSrc: porzione dell'immagine che andiamo a considerare; 
+// regionCl:  colore della regione, che sarà utilizzato per colorare 
+//            appunto il rettangolo che stiamo considerando; 
+struct Region {
+    cv::Rect regionRec; 
+    cv::Mat regionSrc; 
+    cv::Scalar regionCl;
+}; 
+
+std::stack<Region> Split(cv::Mat src, cv::Rect rec, int thr); 
+bool CheckHomogeneity(cv::Mat src, int thr); 
+bool MergeRegion(cv::Mat src, Region R1, Region R2, int thr); 
+void Merge(cv::Mat src, std::stack<Region> regionList, int thr); 
+
+} // namespace iterative
+
+#endif
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <cstdio>
+#include <stack>
+#include <opencv2/opencv.hpp>
+#include "SplitAndMergeIt.hpp"
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    // Si legge l'immagine da riga di comando, e la si converte
+    // in grigio. 
+    String inputFile = argv[1]; 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
+
+    // Per poter ottenere un risultato ottimale si applica un filtro Gaussiano 
+    // sull'immagine di input, la maschera è di dimensione 5x5, mentre la 
+    // deviazione standard è pari a 0. 
+    GaussianBlur(inputImage, inputImage, Size(5, 5), 0, 0);
+
+    // L'immagine originale viene mostrata in un'apposita finestra. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE); 
+    imshow("Original Image", inputImage); 
+
+    int inputCols = inputImage.cols; 
+    int inputRows = inputImage.rows; 
+    int threshold = atoi(argv[2]); 
+    Mat resultImage = inputImage.clone(); 
+
+    Mat resultSrc = inputImage(Rect(0, 0, inputCols, inputRows)); 
+    Rect resultRect = Rect(0, 0, inputCols, inputRows);
+
+    // Viene richiamata la funzione di Split sull'immagine originale
+    // ed il risultato, essendo uno stack delle regioni ottenute viene 
+    // salvato in un apposito stack. Su tale stack viene effettuata 
+    // l'operazione di Merge.  
+    stack<iterative::Region> regionList = iterative::Split(resultSrc, resultRect, threshold); 
+    iterative::Merge(resultImage, regionList, threshold); 
+
+    // Si effettua sul risultato finale un processo di post-elaborazione 
+    // per poter smussare i contorni delle regioni calcolate. 
+    Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(5, 5));
+    dilate(resultImage, resultImage, kernel, Point(-1,-1), 2);
+    erode(resultImage, resultImage, kernel, Point(-1,-1), 2);
+    erode(resultImage, resultImage, kernel, Point(-1,-1), 2);
+    dilate(resultImage, resultImage, kernel, Point(-1,-1), 2);  
+
+    // Alla fine si mostra il risultato in un'apposita finestra. 
+    namedWindow("Output Image", WINDOW_AUTOSIZE); 
+    imshow("Output Image", resultImage);
+
+    waitKey(0);  
+
+    return 0; 
+}
\ No newline at end of file
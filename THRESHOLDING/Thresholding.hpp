@@ -0,0 +1,10 @@
+#ifndef THRESHOLDING_HPP
+#define THRESHOLDING_HPP
+
+#include <opencv2/opencv.hpp>
+
+// La funzione restituisce l'immagine binaria ottenuta confrontando 
+// ogni pixel con il valore di sogliatura dato in input. 
+cv::Mat Threshold(cv::Mat& src, int thrValue);
+
+#endif
@@ -0,0 +1,34 @@
+#include <cstdio>
+#include <opencv2/opencv.hpp>
+#include "Thresholding.hpp"
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    // Si prende in input il nome dell'immagine da modificare, ed 
+    // anche il valore di sogliatura scelto. 
+    string inputFile = argv[1]; 
+    int thrValue = atoi(argv[2]);     
+
+    // Si legge l'immagine, che ricordiamo essere in bianco e nero. 
+    Mat inputImage = imread(inputFile, IMREAD_GRAYSCALE);
+
+    // E si richiama la funzione Threshold per poter effettuare
+    // l'omonima operazione sull'immagine data in input. 
+    Mat resultImage; 
+    resultImage = Threshold(inputImage, thrValue);
+
+    // Alla fine si mostrano in apposite finestre sia l'immagine 
+    // originale che l'immagine risultante dall'operazione. 
+    namedWindow("Original Image", WINDOW_AUTOSIZE);
+    imshow("Original Image", inputImage);
+
+    namedWindow("Thresholded Image", WINDOW_AUTOSIZE);
+    imshow("Thresholded Image", resultImage);
+
+    waitKey(0); 
+
+    return 0; 
+}
\ No newline at end of file